@@ -0,0 +1,175 @@
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NF10_IOCTL_CMD_SET_RATE (SIOCDEVPRIVATE+4)
+#define NF10_IOCTL_CMD_GET_RATE (SIOCDEVPRIVATE+5)
+#define NF10_IOCTL_CMD_CALIBRATE (SIOCDEVPRIVATE+6)
+#define NF10_IOCTL_CMD_SET_DRR (SIOCDEVPRIVATE+8)
+#define NF10_IOCTL_CMD_SET_MIN (SIOCDEVPRIVATE+9)
+#define NF10_IOCTL_CMD_GET_STATS (SIOCDEVPRIVATE+10)
+#define NF10_IOCTL_CMD_SET_PRIO (SIOCDEVPRIVATE+11)
+#define NF10_IOCTL_CMD_SET_CC (SIOCDEVPRIVATE+12)
+#define NF10_IOCTL_CMD_ADD_CLASS (SIOCDEVPRIVATE+13)
+#define NF10_IOCTL_CMD_SET_RATE_RANGE (SIOCDEVPRIVATE+14)
+#define NICPIC_MARK_BASE 0x4e460000U
+
+struct nicpic_rate{
+    uint64_t rate;
+    uint64_t tokens_max;
+    uint64_t bps;
+    uint64_t step_bps;
+    int64_t error_ppm;
+};
+
+struct nf10_ioctl_rate{
+    uint64_t class_index;
+    uint64_t bps;
+    uint64_t burst_bytes;
+    uint64_t ms;
+    struct nicpic_rate result;
+};
+
+struct nf10_ioctl_range{
+    uint64_t class_index;
+    uint64_t count;
+    uint64_t bps;
+    uint64_t burst_bytes;
+    struct nicpic_rate result;
+};
+
+struct nf10_ioctl_stats{
+    uint64_t class_index;
+    uint64_t bytes;
+    uint64_t pkts;
+    uint64_t starved_cycles;
+    uint64_t doorbells;
+};
+
+// Usage: ./rate set <class> <bps> <burst bytes>
+//        ./rate get <class>
+//        ./rate cal <expected bps> <ms>   (keep the port busy meanwhile)
+//        ./rate drr <class> <quantum bytes>  (a parent sets all its children)
+//        ./rate min <class> <committed bps> <burst bytes>  (bps 0 removes it)
+//        ./rate stats <class>  (counters since the class was added)
+//        ./rate prio <class> <level>  (0 to 3, 0 goes first)
+//        ./rate starve <passes>  (a waiting level is served after that many, 0 never)
+//        ./rate cc <class> <increase bps>  (adapt to ECN below the set rate, 0 stops)
+//        ./rate add <bps> <burst bytes>  (a new class, packets with the printed mark use it)
+//        ./rate range <class> <count> <bps> <burst bytes>  (count classes in one doorbell)
+int main(int argc, char* argv[]){
+    int f, ret;
+    struct nf10_ioctl_rate r;
+    uint64_t drr[2];
+    struct nf10_ioctl_stats s;
+    struct nf10_ioctl_range g;
+
+    memset(&r, 0, sizeof(r));
+    memset(&g, 0, sizeof(g));
+    if(argc == 5 && (!strcmp(argv[1], "set") || !strcmp(argv[1], "min"))){
+        r.class_index = strtoull(argv[2], NULL, 0);
+        r.bps = strtoull(argv[3], NULL, 0);
+        r.burst_bytes = strtoull(argv[4], NULL, 0);
+    }
+    else if(argc == 3 && (!strcmp(argv[1], "get") || !strcmp(argv[1], "stats"))){
+        r.class_index = strtoull(argv[2], NULL, 0);
+    }
+    else if(argc == 6 && !strcmp(argv[1], "range")){
+        g.class_index = strtoull(argv[2], NULL, 0);
+        g.count = strtoull(argv[3], NULL, 0);
+        g.bps = strtoull(argv[4], NULL, 0);
+        g.burst_bytes = strtoull(argv[5], NULL, 0);
+    }
+    else if(argc == 4 && !strcmp(argv[1], "add")){
+        r.bps = strtoull(argv[2], NULL, 0);
+        r.burst_bytes = strtoull(argv[3], NULL, 0);
+    }
+    else if(argc == 4 && !strcmp(argv[1], "cal")){
+        r.bps = strtoull(argv[2], NULL, 0);
+        r.ms = strtoull(argv[3], NULL, 0);
+    }
+    else if(argc == 4 && (!strcmp(argv[1], "drr") || !strcmp(argv[1], "prio") || !strcmp(argv[1], "cc"))){
+        drr[0] = strtoull(argv[2], NULL, 0);
+        drr[1] = strtoull(argv[3], NULL, 0);
+    }
+    else if(argc == 3 && !strcmp(argv[1], "starve")){
+        drr[0] = ~0ULL;
+        drr[1] = strtoull(argv[2], NULL, 0);
+    }
+    else{
+        printf("usage: %s set <class> <bps> <burst bytes> | get <class> | cal <bps> <ms> | drr <class> <quantum>"
+               " | min <class> <bps> <burst bytes> | stats <class> | prio <class> <level> | starve <passes>"
+               " | cc <class> <increase bps> | add <bps> <burst bytes>"
+               " | range <class> <count> <bps> <burst bytes>\n",
+               argv[0]);
+        return 0;
+    }
+
+    //----------------------------------------------------
+    //-- open nf10 file descriptor for all the fun stuff
+    //----------------------------------------------------
+    f = open("/dev/nf10", O_RDWR);
+    if(f < 0){
+        perror("/dev/nf10");
+        return 0;
+    }
+
+    if(!strcmp(argv[1], "drr") || !strcmp(argv[1], "prio") || !strcmp(argv[1], "starve") || !strcmp(argv[1], "cc")){
+        if(ioctl(f, !strcmp(argv[1], "drr") ? NF10_IOCTL_CMD_SET_DRR :
+                    !strcmp(argv[1], "cc") ? NF10_IOCTL_CMD_SET_CC : NF10_IOCTL_CMD_SET_PRIO, drr) < 0)
+            perror("nf10 ioctl failed");
+        close(f);
+        return 0;
+    }
+
+    if(!strcmp(argv[1], "stats")){
+        memset(&s, 0, sizeof(s));
+        s.class_index = r.class_index;
+        if(ioctl(f, NF10_IOCTL_CMD_GET_STATS, &s) < 0)
+            perror("nf10 ioctl failed");
+        printf("bytes:      %" PRIu64 "\n", s.bytes);
+        printf("packets:    %" PRIu64 "\n", s.pkts);
+        printf("starved:    %" PRIu64 " cycles\n", s.starved_cycles);
+        printf("doorbells:  %" PRIu64 "\n", s.doorbells);
+        close(f);
+        return 0;
+    }
+
+    if(!strcmp(argv[1], "range")){
+        ret = ioctl(f, NF10_IOCTL_CMD_SET_RATE_RANGE, &g);
+        r.result = g.result;
+    }
+    else if(!strcmp(argv[1], "set"))
+        ret = ioctl(f, NF10_IOCTL_CMD_SET_RATE, &r);
+    else if(!strcmp(argv[1], "min"))
+        ret = ioctl(f, NF10_IOCTL_CMD_SET_MIN, &r);
+    else if(!strcmp(argv[1], "get"))
+        ret = ioctl(f, NF10_IOCTL_CMD_GET_RATE, &r);
+    else if(!strcmp(argv[1], "add"))
+        ret = ioctl(f, NF10_IOCTL_CMD_ADD_CLASS, &r);
+    else
+        ret = ioctl(f, NF10_IOCTL_CMD_CALIBRATE, &r);
+
+    if(ret < 0)
+        perror("nf10 ioctl failed");
+
+    if(!strcmp(argv[1], "add")){
+        printf("class:      %" PRIu64 "\n", r.class_index);
+        printf("mark:       0x%x\n", NICPIC_MARK_BASE + (unsigned int)r.class_index);
+    }
+
+    printf("rate:       %" PRIu64 "\n", r.result.rate);
+    printf("tokens_max: %" PRIu64 "\n", r.result.tokens_max);
+    printf("bps:        %" PRIu64 "\n", r.result.bps);
+    printf("resolution: %" PRIu64 " bps\n", r.result.step_bps);
+    printf("error:      %" PRId64 " ppm\n", r.result.error_ppm);
+
+    close(f);
+
+    return 0;
+}
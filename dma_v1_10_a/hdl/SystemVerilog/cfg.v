@@ -82,6 +82,7 @@ module cfg
     output logic [63:0]              tx_pkt_mask,
     output logic [63:0]              tx_dne_mask,
     output logic [63:0]              rx_dsc_mask_t, 
+    output logic [15:0]              tx_cut_lines,
 
     // rx_clk
     output logic [63:0]              tx_dne_mask_r,
@@ -144,6 +145,7 @@ module cfg
    logic [63:0]                      host_rx_dne_mask_l;
 
    logic [15:0]                      rx_byte_wait_l;
+   logic [15:0]                      tx_cut_lines_l;
    
    logic                             tx_int_enable_l;
    logic                             rx_int_enable_l;
@@ -176,6 +178,7 @@ module cfg
    x_signal #(64) x_cfg_2(pcie_clk, tx_pkt_mask_l, tx_clk, tx_pkt_mask);
    x_signal #(64) x_cfg_3(pcie_clk, tx_dne_mask_l, tx_clk, tx_dne_mask);
    x_signal #(64) x_cfg_4(pcie_clk, rx_dsc_mask_l, tx_clk, rx_dsc_mask_t);
+   x_signal #(16) x_cfg_28(pcie_clk, tx_cut_lines_l, tx_clk, tx_cut_lines);
 
    x_signal #(64) x_cfg_5(pcie_clk, tx_dne_mask_l, rx_clk, tx_dne_mask_r);
    x_signal #(64) x_cfg_6(pcie_clk, rx_dsc_mask_l, rx_clk, rx_dsc_mask);
@@ -230,6 +233,7 @@ module cfg
          host_tx_doorbell_dne_mask_l <= 0;
 
          rx_byte_wait_l  <= 16'hffff;
+         tx_cut_lines_l  <= `TX_CUT_LINES;
          tx_int_enable_l <= 1;
          rx_int_enable_l <= 1;
          tx_doorbell_int_enable_l <= 1;
@@ -269,6 +273,7 @@ module cfg
 
               40: for(i=0; i<4; i++) if(wr_mask_lo[i]) mem_tx_dne_head_l[i*8+:8]   <= wr_data_lo[i*8+:8];
               41: for(i=0; i<4; i++) if(wr_mask_lo[i]) mem_tx_doorbell_dne_head_l[i*8+:8]   <= wr_data_lo[i*8+:8];
+              42: for(i=0; i<2; i++) if(wr_mask_lo[i]) tx_cut_lines_l[i*8+:8]  <= wr_data_lo[i*8+:8];
 
               128: for(i=0; i<4; i++) if(wr_mask_lo[i]) axi_wr_data_l[i*8+:8] <= wr_data_lo[i*8+:8];
               default:;
@@ -405,11 +410,23 @@ module cfg
 
               40: rd_data_lo <= mem_tx_dne_head_l[0+:32];
               41: rd_data_lo <= mem_tx_doorbell_dne_head_l[0+:32];
+              42: rd_data_lo <= {16'b0, tx_cut_lines_l};
 
               50: rd_data_lo <= dma_start_l[0+:32];
               51: rd_data_lo <= dma_end_l[0+:32];
               52: rd_data_lo <= {12'd0, mem_tx_doorbell_head_l};
 
+              // memory sizes the card was built with, as masks
+              53: rd_data_lo <= `MEM_N_TX_DSC*64-1;
+              54: rd_data_lo <= `MEM_N_TX_PKT*64-1;
+              55: rd_data_lo <= `MEM_N_TX_DNE*64-1;
+              56: rd_data_lo <= `MEM_N_RX_DSC*64-1;
+              57: rd_data_lo <= `MEM_N_RX_PKT*64-1;
+              58: rd_data_lo <= `MEM_N_RX_DNE*64-1;
+              59: rd_data_lo <= `MEM_N_TX_DOORBELL*64-1;
+              60: rd_data_lo <= `MEM_N_TX_DOORBELL_DNE*64-1;
+              61: rd_data_lo <= `MEM_N_TX_INLINE*64-1;
+
               128: rd_data_lo <= axi_wr_data_l[0+:32];
               129: rd_data_lo <= axi_rd_data_l[0+:32];
               130: rd_data_lo <= {29'b0, axi_fifo_full, axi_fifo_almost_full, axi_fifo_empty_l};
@@ -51,22 +51,22 @@ module dma_engine
 
    // feedback task queue
    output logic                       feedback_task_q_enq_en,
-   output logic [195:0]               feedback_task_q_enq_data,
+   output logic [351:0]               feedback_task_q_enq_data,
    input logic                        feedback_task_q_full,
 
    // doorbell dne queue
    output logic                       doorbell_dne_q_deq_en,
-   input logic [31:0]                 doorbell_dne_q_deq_data,
+   input logic [287:0]                doorbell_dne_q_deq_data,
    input logic                        doorbell_dne_q_empty,
 
    // tx task queue inputs
    output logic                       tx_task_q_deq_en,
-   input logic [381:0]                tx_task_q_data,
+   input logic [513:0]                tx_task_q_data,
    input logic                        tx_task_q_empty,
 
    // doorbell task queue output
    output logic                       doorbell_task_q_enq_en,
-   output logic [127:0]               doorbell_task_q_data,
+   output logic [191:0]               doorbell_task_q_data,
    input logic                        doorbell_task_q_full,
 
    // Tx
@@ -186,6 +186,7 @@ module dma_engine
    logic [2:0]           max_read_req_size;
    logic [2:0]           max_payload_size;
    logic                 read_completion_bundary;
+   logic                 ext_tag_en;
 
    always_ff @(posedge pcie_clk) begin
       pcie_id                 <= {cfg_bus_number, cfg_device_number, cfg_function_number};
@@ -193,6 +194,7 @@ module dma_engine
       max_read_req_size       <= cfg_dcommand[14:12];
       max_payload_size        <= cfg_dcommand[7:5];
       read_completion_bundary <= cfg_lcommand[3];
+      ext_tag_en              <= cfg_dcommand[8];
       cfg_dsn                 <= 'd1337;
    end
 
@@ -211,12 +213,12 @@ module dma_engine
    logic [`CM_Q_WIDTH-1:0]      cm_q_data;
    logic                        cm_q_almost_full;
    logic                        ort_req_v;
-   logic [3:0]                  ort_req_tag;
+   logic [`ORT_TAG_BITS-1:0]    ort_req_tag;
    logic [1:0]                  ort_req_iface;
    logic [3:0]                  ort_req_mem;
    logic [`MEM_ADDR_BITS-1:0]   ort_req_addr;
    logic                        ort_next_tag_v;
-   logic [3:0]                  ort_next_tag;
+   logic [`ORT_TAG_BITS-1:0]    ort_next_tag;
    logic                        iface_rdy;
 
    // pcie_tx wires
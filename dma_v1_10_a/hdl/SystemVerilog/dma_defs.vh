@@ -49,8 +49,35 @@
 // max bit size of the memory address
 `define MEM_ADDR_BITS 20
 
-// depth of the tx pending queue
+// depth of the tx pending queue, a power of two
+`ifndef TX_PENDING_DEPTH
 `define TX_PENDING_DEPTH 32
+`endif
+
+// descriptors a class may have requested ahead of the packet being sent
+`define TX_DSC_PREFETCH 16
+
+// descriptors fetched by one read request, 64 bytes each on the host
+`define TX_DSC_BATCH 8
+
+// tx completions of one class are held and merged until they cover this many
+// packets or the oldest is TX_DNE_TIMEOUT cycles old (10 us)
+`define TX_DNE_COALESCE 32
+`define TX_DNE_TIMEOUT 1600
+
+// lines of a tx packet in tx_pkt memory before it starts to the MAC, 0 starts
+// on the first line, 16'hffff waits for the whole packet. Reset value of cfg word 42
+`define TX_CUT_LINES 0
+
+// dma reads tx_ctrl keeps outstanding, descriptors and packets together. A
+// packet read counts until the packet left for the MAC. Has to exceed
+// TX_DSC_PREFETCH. Reads beyond the free pcie tags wait in pcie_tx_rd.
+// Every packet read also takes a tx pending queue entry, so no more than
+// TX_PENDING_DEPTH of them are out whatever this is, raise both together.
+// tx_ctrl_rd_tb.sh sweeps the pair
+`ifndef TX_RD_IN_FLIGHT
+`define TX_RD_IN_FLIGHT 32
+`endif
 
 // interface write queue parameters
 `define WR_Q_WIDTH (90 + `MEM_ADDR_BITS)
@@ -62,6 +89,11 @@
 `define CM_Q_WIDTH (75 + `MEM_ADDR_BITS)
 `define CM_Q_DEPTH 8
 
+// tags of outstanding pcie reads. Without Extended Tag Field Enable set by
+// the root port only the low 5 bits are used
+`define ORT_TAG_BITS 8
+`define ORT_N (1 << `ORT_TAG_BITS)
+
 // pcie tx queue parameters
 `define PCIE_WR_Q_WIDTH (94 + `MEM_ADDR_BITS)
 `define PCIE_WR_Q_DEPTH 8
@@ -76,15 +108,41 @@
 // mem valid write cross domain fifo depth
 `define MEM_VALID_X_DEPTH 4
 
-// memory sizes (in number of cache lines)
+// memory sizes (in number of cache lines), powers of two. Any of them can
+// be set for synthesis with a define, the driver reads them from cfg
+`ifndef MEM_N_TX_DSC
 `define MEM_N_TX_DSC 32
-`define MEM_N_TX_PKT 512
+`endif
+`ifndef MEM_N_TX_PKT
+`define MEM_N_TX_PKT 2048
+`endif
+`ifndef MEM_N_TX_DNE
 `define MEM_N_TX_DNE 32
+`endif
+`ifndef MEM_N_RX_DSC
 `define MEM_N_RX_DSC 32
-`define MEM_N_RX_PKT 512
+`endif
+`ifndef MEM_N_RX_PKT
+`define MEM_N_RX_PKT 2048
+`endif
+`ifndef MEM_N_RX_DNE
 `define MEM_N_RX_DNE 32
+`endif
+`ifndef MEM_N_TX_DOORBELL
 `define MEM_N_TX_DOORBELL 32
+`endif
+`ifndef MEM_N_TX_DOORBELL_DNE
 `define MEM_N_TX_DOORBELL_DNE 32
+`endif
+`ifndef MEM_N_TX_BULK
+`define MEM_N_TX_BULK 32
+`endif
+`ifndef MEM_N_TX_INLINE
+`define MEM_N_TX_INLINE 128
+`endif
+
+// the inline packet memory is the upper half of the tx doorbell window
+`define TX_INLINE_ADDR_BIT 19
 
 // config memory address size
 `define CFG_ADDR_BITS 12
@@ -117,3 +175,4 @@
 `define ID_MEM_RX_PKT 7
 `define ID_MEM_TX_DOORBELL 2
 `define ID_MEM_TX_DOORBELL_DNE 9
+`define ID_MEM_TX_BULK 10
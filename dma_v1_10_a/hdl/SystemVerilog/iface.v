@@ -48,22 +48,22 @@ module iface #(parameter IFACE_ID = 0)
 
     // feedback task queue
     output logic                       feedback_task_q_enq_en,
-    output logic [195:0]               feedback_task_q_enq_data,
+    output logic [351:0]               feedback_task_q_enq_data,
     input logic                        feedback_task_q_full,
 
     // doorbell dne queue
     output logic                       doorbell_dne_q_deq_en,
-    input logic [31:0]                 doorbell_dne_q_deq_data,
+    input logic [287:0]                doorbell_dne_q_deq_data,
     input logic                        doorbell_dne_q_empty,
 
     // tx task queue inputs
     output logic                       tx_task_q_deq_en,
-    input logic [381:0]                tx_task_q_data,
+    input logic [513:0]                tx_task_q_data,
     input logic                        tx_task_q_empty,
 
     // doorbell task queue output
     output logic                       doorbell_task_q_enq_en,
-    output logic [127:0]               doorbell_task_q_data,
+    output logic [191:0]               doorbell_task_q_data,
     input logic                        doorbell_task_q_full,
 
     // memory write interface (pcie_clk)
@@ -193,6 +193,7 @@ module iface #(parameter IFACE_ID = 0)
    logic [63:0]           host_rx_dne_offset;
    logic [63:0]           host_rx_dne_mask;
    logic [15:0]           rx_byte_wait;
+   logic [15:0]           tx_cut_lines;
    logic                  tx_int_enable;
    logic                  tx_doorbell_int_enable;
    logic                  rx_int_enable;
@@ -212,6 +213,8 @@ module iface #(parameter IFACE_ID = 0)
    logic [63:0]           stat_mac_tx_ts;
    logic [31:0]           stat_mac_tx_word_cnt;
    logic [31:0]           stat_mac_tx_pkt_cnt;
+   logic [63:0]           stat_tx_time;
+   logic [31:0]           stat_doorbell_stall_cnt;
    
    logic [63:0]           stat_mac_rx_ts;
    logic [31:0]           stat_mac_rx_word_cnt;
@@ -241,11 +244,18 @@ module iface #(parameter IFACE_ID = 0)
    logic                       mem_vld_tx_dsc_wr_stall;
    logic                       mem_vld_tx_dsc_rd_bit;
    
+   logic [`MEM_ADDR_BITS-12:0] mem_vld_tx_bulk_wr_addr;
+   logic [31:0]                mem_vld_tx_bulk_wr_mask;
+   logic                       mem_vld_tx_bulk_wr_clear;
+   logic                       mem_vld_tx_bulk_wr_stall;
+   logic                       mem_vld_tx_bulk_rd_bit;
+
    logic [`MEM_ADDR_BITS-12:0] mem_vld_tx_pkt_wr_addr;
    logic [31:0]                mem_vld_tx_pkt_wr_mask;
    logic                       mem_vld_tx_pkt_wr_clear;
    logic                       mem_vld_tx_pkt_wr_stall;
    logic                       mem_vld_tx_pkt_rd_bit;
+   logic [31:0]                mem_vld_tx_pkt_rd_bits;
    
    logic [`MEM_ADDR_BITS-12:0] mem_vld_tx_dne_wr_addr;
    logic [31:0]                mem_vld_tx_dne_wr_mask;
@@ -282,6 +292,14 @@ module iface #(parameter IFACE_ID = 0)
    logic [63:0]               mem_tx_pkt_rd_data;
    logic                      mem_tx_pkt_rd_en;
 
+   logic [`MEM_ADDR_BITS-1:0] mem_tx_bulk_rd_addr;
+   logic [63:0]               mem_tx_bulk_rd_data;
+   logic                      mem_tx_bulk_rd_en;
+
+   logic [`MEM_ADDR_BITS-1:0] mem_tx_inline_rd_addr;
+   logic [63:0]               mem_tx_inline_rd_data;
+   logic                      mem_tx_inline_rd_en;
+
    logic [`MEM_ADDR_BITS-1:0] mem_rx_dsc_rd_addr;
    logic [63:0]               mem_rx_dsc_rd_data;
    logic                      mem_rx_dsc_rd_en;
@@ -352,8 +370,8 @@ module iface #(parameter IFACE_ID = 0)
    // -----------------------------------
    // -- Instantiate memories
    // -----------------------------------
-   logic [31:0]           rd_data_lo_array[9:0];
-   logic [31:0]           rd_data_hi_array[9:0];
+   logic [31:0]           rd_data_lo_array[10:0];
+   logic [31:0]           rd_data_hi_array[10:0];
 
    logic [3:0]            rd_mem_select_d1;
 
@@ -361,10 +379,12 @@ module iface #(parameter IFACE_ID = 0)
    assign rd_data_lo_array[`ID_MEM_TX_PKT] = 32'hdeadbeef;
    assign rd_data_lo_array[`ID_MEM_TX_DSC] = 32'hdeadbeef;
    assign rd_data_lo_array[`ID_MEM_TX_DOORBELL] = 32'hdeadbeef;
+   assign rd_data_lo_array[`ID_MEM_TX_BULK] = 32'hdeadbeef;
    assign rd_data_hi_array[`ID_MEM_RX_DSC] = 32'hdeadbeef;
    assign rd_data_hi_array[`ID_MEM_TX_PKT] = 32'hdeadbeef;
    assign rd_data_hi_array[`ID_MEM_TX_DSC] = 32'hdeadbeef;
    assign rd_data_hi_array[`ID_MEM_TX_DOORBELL] = 32'hdeadbeef;
+   assign rd_data_hi_array[`ID_MEM_TX_BULK] = 32'hdeadbeef;
    
    always_ff @(posedge pcie_clk) rd_mem_select_d1 <= rd_mem_select;
    assign rd_data_lo = rd_data_lo_array[rd_mem_select_d1];
@@ -392,8 +412,10 @@ module iface #(parameter IFACE_ID = 0)
               .rst(rst_reg_p),
               .*);
    
-   mem #(.DEPTH(`MEM_N_TX_DOORBELL), .WIDTH(16), .VALID_MODE(1), .HAS_WR_MASK(1)) 
-   u_mem_tx_doorbell (.wr_mem_valid((wr_if_select == IFACE_ID[1:0]) && (wr_mem_select == `ID_MEM_TX_DOORBELL)),
+   // the third word is the ADD_DSC launch time, written before the second
+   mem #(.DEPTH(`MEM_N_TX_DOORBELL), .WIDTH(24), .VALID_MODE(1), .HAS_WR_MASK(1), .VALID_BYTE(15)) 
+   u_mem_tx_doorbell (.wr_mem_valid((wr_if_select == IFACE_ID[1:0]) && (wr_mem_select == `ID_MEM_TX_DOORBELL) &&
+                                    !wr_addr_lo[`TX_INLINE_ADDR_BIT]),
                  .rd_mem_valid(1'b1),
                  .rd_addr_hi(mem_tx_doorbell_rd_addr),
                  .rd_data_hi(mem_tx_doorbell_rd_data[63:32]),
@@ -416,7 +438,7 @@ module iface #(parameter IFACE_ID = 0)
                  .rd_clk(tx_clk),
                  .rst(rst_reg_p),
                  .*);
-   mem #(.DEPTH(`MEM_N_TX_DOORBELL_DNE), .WIDTH(4), .VALID_MODE(2), .HAS_WR_MASK(0)) 
+   mem #(.DEPTH(`MEM_N_TX_DOORBELL_DNE), .WIDTH(24), .VALID_MODE(2), .HAS_WR_MASK(0)) 
    u_mem_tx_doorbell_dne (.wr_mem_valid(1),
                  .rd_mem_valid((rd_if_select == IFACE_ID[1:0]) && (rd_mem_select == `ID_MEM_TX_DOORBELL_DNE)), 
                  .wr_addr_hi(mem_tx_doorbell_dne_wr_addr),
@@ -445,7 +467,8 @@ module iface #(parameter IFACE_ID = 0)
                  .rst(rst_reg_t),
                  .*);
 
-   mem #(.DEPTH(`MEM_N_TX_DSC), .WIDTH(16), .VALID_MODE(1), .HAS_WR_MASK(1)) 
+   // the third word is the launch time of the descriptor, its write sets the valid bit
+   mem #(.DEPTH(`MEM_N_TX_DSC), .WIDTH(24), .VALID_MODE(1), .HAS_WR_MASK(1)) 
    u_mem_tx_dsc (.wr_mem_valid((wr_if_select == IFACE_ID[1:0]) && (wr_mem_select == `ID_MEM_TX_DSC)),
                  .rd_mem_valid(1'b1),
                  .rd_addr_hi(mem_tx_dsc_rd_addr),
@@ -484,6 +507,30 @@ module iface #(parameter IFACE_ID = 0)
                  .valid_wr_clear(mem_vld_tx_pkt_wr_clear),
                  .valid_wr_stall(mem_vld_tx_pkt_wr_stall),
                  .valid_rd_addr(),
+                 .valid_rd_bits(mem_vld_tx_pkt_rd_bits),
+                 .valid_rd_addr_x(),
+                 .valid_rd_bits_x(),
+                 .valid_rd_clk(),
+                 .valid_wr_clk(tx_clk),
+                 .wr_clk(pcie_clk),
+                 .rd_clk(tx_clk),
+                 .rst(rst_reg_p),
+                 .*);
+   mem #(.DEPTH(`MEM_N_TX_BULK), .WIDTH(64), .VALID_MODE(1), .HAS_WR_MASK(1)) 
+   u_mem_tx_bulk (.wr_mem_valid((wr_if_select == IFACE_ID[1:0]) && (wr_mem_select == `ID_MEM_TX_BULK)),
+                 .rd_mem_valid(1'b1),
+                 .rd_addr_hi(mem_tx_bulk_rd_addr),
+                 .rd_data_hi(mem_tx_bulk_rd_data[63:32]),
+                 .rd_en_hi(mem_tx_bulk_rd_en),
+                 .rd_addr_lo(mem_tx_bulk_rd_addr),
+                 .rd_data_lo(mem_tx_bulk_rd_data[31:0]),
+                 .rd_en_lo(mem_tx_bulk_rd_en),
+                 .rd_vld_lo(mem_vld_tx_bulk_rd_bit),
+                 .valid_wr_addr(mem_vld_tx_bulk_wr_addr),
+                 .valid_wr_mask(mem_vld_tx_bulk_wr_mask),
+                 .valid_wr_clear(mem_vld_tx_bulk_wr_clear),
+                 .valid_wr_stall(mem_vld_tx_bulk_wr_stall),
+                 .valid_rd_addr(),
                  .valid_rd_bits(),
                  .valid_rd_addr_x(),
                  .valid_rd_bits_x(),
@@ -493,6 +540,33 @@ module iface #(parameter IFACE_ID = 0)
                  .rd_clk(tx_clk),
                  .rst(rst_reg_p),
                  .*);
+   // small packets written by the driver, sent without a dma read. The
+   // doorbell that follows them tells they are complete, no valid bits
+   mem #(.DEPTH(`MEM_N_TX_INLINE), .WIDTH(64), .VALID_MODE(0), .HAS_WR_MASK(1)) 
+   u_mem_tx_inline (.wr_mem_valid((wr_if_select == IFACE_ID[1:0]) && (wr_mem_select == `ID_MEM_TX_DOORBELL) &&
+                                  wr_addr_lo[`TX_INLINE_ADDR_BIT]),
+                 .rd_mem_valid(1'b1),
+                 .rd_addr_hi(mem_tx_inline_rd_addr),
+                 .rd_data_hi(mem_tx_inline_rd_data[63:32]),
+                 .rd_en_hi(mem_tx_inline_rd_en),
+                 .rd_addr_lo(mem_tx_inline_rd_addr),
+                 .rd_data_lo(mem_tx_inline_rd_data[31:0]),
+                 .rd_en_lo(mem_tx_inline_rd_en),
+                 .rd_vld_lo(),
+                 .valid_wr_addr(),
+                 .valid_wr_mask(),
+                 .valid_wr_clear(),
+                 .valid_wr_stall(),
+                 .valid_rd_addr(),
+                 .valid_rd_bits(),
+                 .valid_rd_addr_x(),
+                 .valid_rd_bits_x(),
+                 .valid_rd_clk(),
+                 .valid_wr_clk(),
+                 .wr_clk(pcie_clk),
+                 .rd_clk(tx_clk),
+                 .rst(rst_reg_p),
+                 .*);
    mem #(.DEPTH(`MEM_N_TX_DNE), .WIDTH(8), .VALID_MODE(2), .HAS_WR_MASK(0)) 
    u_mem_tx_dne (.wr_mem_valid(1),
                  .rd_mem_valid((rd_if_select == IFACE_ID[1:0]) && (rd_mem_select == `ID_MEM_TX_DNE)), 
@@ -606,31 +680,32 @@ module iface #(parameter IFACE_ID = 0)
    // -----------------------------------
    // -- Decode pcie settings
    // -----------------------------------
-   logic [9:0]            max_payload_decoded, max_payload_decoded_reg_p, max_payload_decoded_reg_r;
-   logic [9:0]            max_read_decoded, max_read_decoded_reg_t;
+   // in dwords, 11 bits so 4096 bytes does not wrap to 0
+   logic [10:0]           max_payload_decoded, max_payload_decoded_reg_p, max_payload_decoded_reg_r;
+   logic [10:0]           max_read_decoded, max_read_decoded_reg_t;
    always_comb begin
       unique case(max_payload_size)
-        'b000: max_payload_decoded = 10'd32;
-        'b001: max_payload_decoded = 10'd64;
-        'b010: max_payload_decoded = 10'd128;
-        'b011: max_payload_decoded = 10'd256;
-        'b100: max_payload_decoded = 10'd512;
-        'b101: max_payload_decoded = 10'd1024; // i.e. 'd0
-        default: max_payload_decoded = 'd0;
+        'b000: max_payload_decoded = 11'd32;
+        'b001: max_payload_decoded = 11'd64;
+        'b010: max_payload_decoded = 11'd128;
+        'b011: max_payload_decoded = 11'd256;
+        'b100: max_payload_decoded = 11'd512;
+        'b101: max_payload_decoded = 11'd1024;
+        default: max_payload_decoded = 11'd32; // reserved, 128 bytes is always legal
       endcase
       unique case(max_read_req_size)
-        'b000: max_read_decoded = 10'd32;
-        'b001: max_read_decoded = 10'd64;
-        'b010: max_read_decoded = 10'd128;
-        'b011: max_read_decoded = 10'd256;
-        'b100: max_read_decoded = 10'd512;
-        'b101: max_read_decoded = 10'd1024; // i.e. 'd0
-        default: max_read_decoded = 'd0;
+        'b000: max_read_decoded = 11'd32;
+        'b001: max_read_decoded = 11'd64;
+        'b010: max_read_decoded = 11'd128;
+        'b011: max_read_decoded = 11'd256;
+        'b100: max_read_decoded = 11'd512;
+        'b101: max_read_decoded = 11'd1024;
+        default: max_read_decoded = 11'd32; // reserved, 128 bytes is always legal
       endcase
    end
    always_ff @(posedge pcie_clk) max_payload_decoded_reg_p <= max_payload_decoded;
-   x_signal #(10) u_x_pcie_0(pcie_clk, max_payload_decoded, rx_clk, max_payload_decoded_reg_r);
-   x_signal #(10) u_x_pcie_1(pcie_clk, max_read_decoded,    tx_clk, max_read_decoded_reg_t);
+   x_signal #(11) u_x_pcie_0(pcie_clk, max_payload_decoded, rx_clk, max_payload_decoded_reg_r);
+   x_signal #(11) u_x_pcie_1(pcie_clk, max_read_decoded,    tx_clk, max_read_decoded_reg_t);
 
 
    // -----------------------------------
@@ -52,7 +52,9 @@ module mem #(
              // mode=2 random valid bit interface
              // mode=3 same as 2 with two separate read interfaces for valid bit
              parameter VALID_MODE=0,
-             parameter HAS_WR_MASK=1)
+             parameter HAS_WR_MASK=1,
+             // byte whose write sets the valid bit, the last one by default
+             parameter VALID_BYTE=WIDTH-1)
    (
     // memory interface signals valid
     input logic                       wr_mem_valid,
@@ -97,7 +99,7 @@ module mem #(
     input logic                       rst
     );
 
-   localparam LAST_BYTE = WIDTH - 1;
+   localparam LAST_BYTE = VALID_BYTE;
    localparam ADDR_BITS = (DEPTH<=32) ? 1 : $clog2((DEPTH+31)/32);
 
    //-------------------------------------------------
@@ -132,9 +134,12 @@ module mem #(
    logic [`MEM_ADDR_BITS-1:0]        rd_addr_lo_d1;
    logic [31:0]                      rd_vld_bits;
 
+   // mode=1 also gives the valid word of the read, the 32 lines around it
    generate
-      if(VALID_MODE == 1)
+      if(VALID_MODE == 1) begin
         assign rd_vld_lo = rd_vld_bits[rd_addr_lo_d1[10:6]];
+        assign valid_rd_bits = rd_vld_bits;
+      end
       else
         assign rd_vld_lo = 0;
    endgenerate
@@ -60,7 +60,7 @@ module pcie_cm_q
    input logic                         cm_q_req_grant,
 
    // pcie misc
-   input logic [9:0]                   max_payload_decoded,
+   input logic [10:0]                  max_payload_decoded,
    input logic                         read_completion_bundary,
 
    // misc
@@ -57,7 +57,7 @@ module pcie_rd_q #(parameter IFACE_ID = 0)
    input logic                         rd_q_req_grant,
 
    // pcie config
-   input logic [9:0]                   max_read_decoded,
+   input logic [10:0]                  max_read_decoded,
 
    // misc
    input logic                         clk,
@@ -133,12 +133,12 @@ module pcie_rd_q #(parameter IFACE_ID = 0)
               
               rd_local_byte_size = rd_q_deq_data[15:0] + {14'b0, rd_q_deq_data[85:84]};
               
-              if(rd_local_byte_size > {4'b0, max_read_decoded, 2'b0}) begin // read bigger than max_read_request
-                 if((({1'b0, rd_q_deq_data[31:22]} + {1'b0, max_read_decoded}) & 11'h400) != 0) begin // 4k hit
+              if(rd_local_byte_size > {3'b0, max_read_decoded, 2'b0}) begin // read bigger than max_read_request
+                 if((({1'b0, rd_q_deq_data[31:22]} + max_read_decoded) & 11'h400) != 0) begin // 4k hit
                     rd_local_dw_size_nxt = 10'd1024 - rd_q_deq_data[31:22];
                  end
                  else begin // 4k ok
-                    rd_local_dw_size_nxt = max_read_decoded - ((max_read_decoded - 10'd1) & rd_q_deq_data[31:22]);
+                    rd_local_dw_size_nxt = max_read_decoded - ((max_read_decoded - 11'd1) & rd_q_deq_data[31:22]);
                  end
               end
               else begin // smaller than max_read_request
@@ -166,7 +166,7 @@ module pcie_rd_q #(parameter IFACE_ID = 0)
 
               rd_local_byte_size = rd_q_deq_data[15:0] + {14'b0, rd_q_deq_data[85:84]};
               
-              if(rd_local_byte_size > {4'b0, max_read_decoded, 2'b0}) begin // read bigger than max_read_request
+              if(rd_local_byte_size > {3'b0, max_read_decoded, 2'b0}) begin // read bigger than max_read_request
                  // lastDW BE
                  if(rd_local_dw_size == 1)
                    rd_q_req_data_nxt[3:0] = 4'b0000;
@@ -262,11 +262,11 @@ module pcie_rd_q #(parameter IFACE_ID = 0)
         RD_STATE_BODY_PREP: begin
 
            if(rd_dw_len_reg > max_read_decoded) begin // write bigger than max_read_request
-              if((({1'b0, rd_host_addr_reg[11:2]} + {1'b0, max_read_decoded}) & 11'h400) != 0) begin // 4k hit
+              if((({1'b0, rd_host_addr_reg[11:2]} + max_read_decoded) & 11'h400) != 0) begin // 4k hit
                  rd_local_dw_size_nxt = 10'd1024 - rd_host_addr_reg[11:2];
               end
               else begin // 4k ok
-                 rd_local_dw_size_nxt = max_read_decoded - (rd_host_addr_reg[11:2] & (max_read_decoded-10'd1));
+                 rd_local_dw_size_nxt = max_read_decoded - (rd_host_addr_reg[11:2] & (max_read_decoded-11'd1));
               end
            end
            else begin // smaller than max_payload
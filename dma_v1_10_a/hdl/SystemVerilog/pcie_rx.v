@@ -78,12 +78,13 @@ module pcie_rx
 
    // ORT request interface
    input logic                       ort_req_v,
-   input logic [3:0]                 ort_req_tag,
+   input logic [`ORT_TAG_BITS-1:0]   ort_req_tag,
    input logic [1:0]                 ort_req_iface,
    input logic [3:0]                 ort_req_mem,
    input logic [`MEM_ADDR_BITS-1:0]  ort_req_addr,
    output logic                      ort_next_tag_v,
-   output logic [3:0]                ort_next_tag,
+   output logic [`ORT_TAG_BITS-1:0]  ort_next_tag,
+   input logic                       ext_tag_en,
 
 `ifdef DEBUG_PCIE
    // debug
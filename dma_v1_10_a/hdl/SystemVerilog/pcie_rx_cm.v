@@ -70,12 +70,13 @@ module pcie_rx_cm
 
    // ORT request interface
    input logic                       ort_req_v,
-   input logic [3:0]                 ort_req_tag,
+   input logic [`ORT_TAG_BITS-1:0]   ort_req_tag,
    input logic [1:0]                 ort_req_iface,
    input logic [3:0]                 ort_req_mem,
    input logic [`MEM_ADDR_BITS-1:0]  ort_req_addr,
    output logic                      ort_next_tag_v,
-   output logic [3:0]                ort_next_tag,
+   output logic [`ORT_TAG_BITS-1:0]  ort_next_tag,
+   input logic                       ext_tag_en,
 
    // stats
    output logic                      stat_pcie_rx_cm_cnt_inc,
@@ -109,10 +110,21 @@ module pcie_rx_cm
    // -----------------------------------
    // -- Outstanding Request Table entries
    // -----------------------------------
-   logic [15:0]               ort_valid,       ort_valid_nxt;
-   logic [1:0]                ort_iface[15:0], ort_iface_nxt[15:0];
-   logic [3:0]                ort_mem  [15:0], ort_mem_nxt  [15:0];
-   logic [`MEM_ADDR_BITS-1:0] ort_addr [15:0], ort_addr_nxt [15:0];
+   logic [`ORT_N-1:0]         ort_valid,             ort_valid_nxt;
+   logic [1:0]                ort_iface[`ORT_N-1:0], ort_iface_nxt[`ORT_N-1:0];
+   logic [3:0]                ort_mem  [`ORT_N-1:0], ort_mem_nxt  [`ORT_N-1:0];
+   logic [`MEM_ADDR_BITS-1:0] ort_addr [`ORT_N-1:0], ort_addr_nxt [`ORT_N-1:0];
+
+   // tags are handed out round robin, the one after the last request is
+   // offered once its previous read has completed. 32 tags unless the root
+   // port enabled extended tags
+   logic [`ORT_TAG_BITS-1:0]  ort_tag_ptr,           ort_tag_ptr_nxt;
+   logic [`ORT_TAG_BITS-1:0]  ort_tag_mask;
+   assign ort_tag_mask = ext_tag_en ? {`ORT_TAG_BITS{1'b1}} : `ORT_TAG_BITS'h1f;
+
+   // tag of the completion in trn_rd_reg
+   logic [`ORT_TAG_BITS-1:0]  cm_tag;
+   assign cm_tag = trn_rd_reg[40 +: `ORT_TAG_BITS];
 
    always_ff @(posedge pcie_clk) cfg_trn_pending_n <= ~|ort_valid;
 
@@ -135,7 +147,7 @@ module pcie_rx_cm
 
    logic [`MEM_ADDR_BITS-1:0] ort_update_addr,  ort_update_addr_nxt;
    logic                      ort_update_valid, ort_update_valid_nxt;
-   logic [3:0]                ort_update_tag,   ort_update_tag_nxt;
+   logic [`ORT_TAG_BITS-1:0]  ort_update_tag,   ort_update_tag_nxt;
 
    logic [1:0]                wr_if_select_nxt_1,  wr_if_select_nxt_2,  wr_if_select_nxt_3;
    logic [3:0]                wr_mem_select_nxt_1, wr_mem_select_nxt_2, wr_mem_select_nxt_3;
@@ -151,8 +163,6 @@ module pcie_rx_cm
    logic [1:0]                wr_mux_select; // 0 - head2-write; 1 - head2-completion; 2-body-odd; 3-body-even    
 
    always_comb begin
-      integer i;
-      
       state_nxt   = state;
       op_nxt      = op;
       head1_nxt   = head1;
@@ -201,8 +211,7 @@ module pcie_rx_cm
       ort_mem_nxt   = ort_mem;
       ort_addr_nxt  = ort_addr;
 
-      ort_next_tag_v = 0;
-      ort_next_tag   = 0;
+      ort_tag_ptr_nxt = ort_tag_ptr;
 
       ort_update_tag_nxt   = ort_update_tag;
       ort_update_addr_nxt  = ort_update_addr;
@@ -215,12 +224,11 @@ module pcie_rx_cm
       // --------------------
       // ORT request handling
       // --------------------
-      for(i = 0; i < 16; i++) begin
-         if(!ort_valid[i] && !(ort_req_v && ort_req_tag == i[3:0])) begin
-            ort_next_tag   = i[3:0];
-            ort_next_tag_v = 1;
-         end
+      if(ort_req_v) begin
+         ort_tag_ptr_nxt = (ort_req_tag + 1'b1) & ort_tag_mask;
       end
+      ort_next_tag   = ort_tag_ptr_nxt;
+      ort_next_tag_v = !ort_valid[ort_tag_ptr_nxt];
       if(ort_req_v) begin
          ort_valid_nxt[ort_req_tag] = 1;
          ort_iface_nxt[ort_req_tag] = ort_req_iface;
@@ -254,11 +262,11 @@ module pcie_rx_cm
               if((head1[62:61] == 2'b10) && (head1[60:56] == 5'b01010) && (head1[15:13] == 3'b000)) begin
                  wr_mux_select = 1;
                  // read state from ORT
-                 wr_if_select_nxt_1  = ort_iface[trn_rd_reg[43:40]];
-                 wr_mem_select_nxt_1 = ort_mem[trn_rd_reg[43:40]];
-                 addr_nxt_1          = ort_addr[trn_rd_reg[43:40]] + 4;
-                 wr_addr_hi_nxt_1    = ort_addr[trn_rd_reg[43:40]];
-                 wr_addr_lo_nxt_1    = ort_addr[trn_rd_reg[43:40]];
+                 wr_if_select_nxt_1  = ort_iface[cm_tag];
+                 wr_mem_select_nxt_1 = ort_mem[cm_tag];
+                 addr_nxt_1          = ort_addr[cm_tag] + 4;
+                 wr_addr_hi_nxt_1    = ort_addr[cm_tag];
+                 wr_addr_lo_nxt_1    = ort_addr[cm_tag];
 
                  // setup data and mask
                  wr_data_hi_nxt_1 = {trn_rd_reg[7:0], trn_rd_reg[15:8], trn_rd_reg[23:16], trn_rd_reg[31:24]};
@@ -271,7 +279,7 @@ module pcie_rx_cm
                  endcase
                  
                  // store operation state
-                 if(ort_addr[trn_rd_reg[43:40]][2]) begin
+                 if(ort_addr[cm_tag][2]) begin
                     wr_en_hi_nxt_1 = 1;
                     op_nxt = OP_WR_EVEN;
                  end
@@ -288,20 +296,20 @@ module pcie_rx_cm
                       2'b10: lastBE_nxt = 4'b0011;
                       2'b11: lastBE_nxt = 4'b0111;
                     endcase
-                    ort_valid_nxt[trn_rd_reg[43:40]] = 0;
+                    ort_valid_nxt[cm_tag] = 0;
                  end
                  else begin
                     lastBE_nxt = 4'b1111;
                  end                 
 
                  if(head1[41:32] == 10'b0) begin
-                    ort_update_addr_nxt = ort_addr[trn_rd_reg[43:40]] + 'h1000;
-                    ort_update_tag_nxt = trn_rd_reg[43:40];
+                    ort_update_addr_nxt = ort_addr[cm_tag] + 'h1000;
+                    ort_update_tag_nxt = cm_tag;
                     ort_update_valid_nxt = 1;
                  end
                  else begin
-                    ort_update_addr_nxt = ort_addr[trn_rd_reg[43:40]] + {{(`MEM_ADDR_BITS-12){1'b0}}, head1[41:32], 2'b0};
-                    ort_update_tag_nxt = trn_rd_reg[43:40];
+                    ort_update_addr_nxt = ort_addr[cm_tag] + {{(`MEM_ADDR_BITS-12){1'b0}}, head1[41:32], 2'b0};
+                    ort_update_tag_nxt = cm_tag;
                     ort_update_valid_nxt = 1;
                  end
 
@@ -314,7 +322,7 @@ module pcie_rx_cm
               // --------------------------
               else if((head1[62:61] == 2'b10) && (head1[60:56] == 5'b01010) && (head1[15:13] != 3'b000)) begin
                  stat_pcie_rx_err_cnt_inc = 1;
-                 ort_valid_nxt[trn_rd_reg[43:40]] = 0;
+                 ort_valid_nxt[cm_tag] = 0;
                  op_nxt = OP_DROP;
               end
 
@@ -422,7 +430,8 @@ module pcie_rx_cm
    always_ff @(posedge pcie_clk) begin
       if(rst) begin
          state      <= STATE_HEADER1;
-         ort_valid  <= 16'h0;
+         ort_valid  <= 0;
+         ort_tag_ptr <= 0;
          ort_update_valid <= 0;
 
          wr_en_lo   <= 0;
@@ -451,6 +460,7 @@ module pcie_rx_cm
          endcase
 
          ort_valid  <= ort_valid_nxt;
+         ort_tag_ptr <= ort_tag_ptr_nxt;
          ort_update_valid <= ort_update_valid_nxt;
       end
 
@@ -90,12 +90,12 @@ module pcie_tx
    
    // ORT request interface
    output logic                       ort_req_v,
-   output logic [3:0]                 ort_req_tag,
+   output logic [`ORT_TAG_BITS-1:0]   ort_req_tag,
    output logic [1:0]                 ort_req_iface,
    output logic [3:0]                 ort_req_mem,
    output logic [`MEM_ADDR_BITS-1:0]  ort_req_addr,
    input logic                        ort_next_tag_v,
-   input logic [3:0]                  ort_next_tag,
+   input logic [`ORT_TAG_BITS-1:0]    ort_next_tag,
 
 `ifdef DEBUG_PCIE
    // debug
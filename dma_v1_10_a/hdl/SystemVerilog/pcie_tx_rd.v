@@ -68,12 +68,12 @@ module pcie_tx_rd
 
    // ORT request interface
    output logic                       ort_req_v,
-   output logic [3:0]                 ort_req_tag,
+   output logic [`ORT_TAG_BITS-1:0]   ort_req_tag,
    output logic [1:0]                 ort_req_iface,
    output logic [3:0]                 ort_req_mem,
    output logic [`MEM_ADDR_BITS-1:0]  ort_req_addr,
    input logic                        ort_next_tag_v,
-   input logic [3:0]                  ort_next_tag,
+   input logic [`ORT_TAG_BITS-1:0]    ort_next_tag,
 
    // misc
    input logic                        tx_clk,
@@ -126,9 +126,10 @@ module pcie_tx_rd
    logic [10:0]                       dw_count,          dw_count_nxt;
    logic                              double_last,       double_last_nxt;
 
-   logic [3:0]                        ort_next_tag_reg;
+   logic [`ORT_TAG_BITS-1:0]          ort_next_tag_reg;
+   logic [7:0]                        trn_tag;
    logic                              ort_req_v_nxt;
-   logic [3:0]                        ort_req_tag_nxt;
+   logic [`ORT_TAG_BITS-1:0]          ort_req_tag_nxt;
    logic [1:0]                        ort_req_iface_nxt;
    logic [3:0]                        ort_req_mem_nxt;
    logic [`MEM_ADDR_BITS-1:0]         ort_req_addr_nxt;
@@ -139,6 +140,9 @@ module pcie_tx_rd
    logic                              trn_teof_n_reg;
    logic                              trn_tsrc_rdy_n_reg;
 
+   // tag field of the request header, zero extended
+   assign trn_tag = ort_next_tag_reg;
+
    // address generation pipeline stage
    always_comb begin
       state_nxt = state;
@@ -193,7 +197,7 @@ module pcie_tx_rd
               end
               
               trn_td[55:32] = {8'b0, 6'b0, rd_q_deq_data[17:8]};
-              trn_td[31:0]  = {pcie_id, 3'b0, 1'b0, ort_next_tag_reg, rd_q_deq_data[3:0], rd_q_deq_data[7:4]};
+              trn_td[31:0]  = {pcie_id, trn_tag, rd_q_deq_data[3:0], rd_q_deq_data[7:4]};
               
               rd_q_deq_en = 1;
               
@@ -58,7 +58,7 @@ module pcie_wr_q #(parameter IFACE_ID = 0)
    input logic                         wr_q_req_grant,
 
    // pcie config
-   input logic [9:0]                   max_payload_decoded,
+   input logic [10:0]                  max_payload_decoded,
     
    // misc
    input logic                         clk,
@@ -145,12 +145,12 @@ module pcie_wr_q #(parameter IFACE_ID = 0)
 
                  wr_local_byte_size = wr_q_deq_data[21:6] + {14'b0, wr_q_deq_data[91:90]};
                  
-                 if(wr_local_byte_size > {4'b0, max_payload_decoded, 2'b0}) begin // write bigger than max_payload
-                    if((({1'b0, wr_q_deq_data[37:28]} + {1'b0, max_payload_decoded}) & 11'h400) != 0) begin // 4k hit
+                 if(wr_local_byte_size > {3'b0, max_payload_decoded, 2'b0}) begin // write bigger than max_payload
+                    if((({1'b0, wr_q_deq_data[37:28]} + max_payload_decoded) & 11'h400) != 0) begin // 4k hit
                        wr_local_dw_size_nxt = 10'd1024 - wr_q_deq_data[37:28];
                     end
                     else begin // 4k ok
-                       wr_local_dw_size_nxt = max_payload_decoded - ((max_payload_decoded - 10'd1) & wr_q_deq_data[37:28]);
+                       wr_local_dw_size_nxt = max_payload_decoded - ((max_payload_decoded - 11'd1) & wr_q_deq_data[37:28]);
                     end
                  end
                  else begin // smaller than max_payload
@@ -180,7 +180,7 @@ module pcie_wr_q #(parameter IFACE_ID = 0)
 
               wr_local_byte_size = wr_q_deq_data[21:6] + {14'b0, wr_q_deq_data[91:90]};
               
-              if(wr_local_byte_size > {4'b0, max_payload_decoded, 2'b0}) begin // write bigger than max_payload
+              if(wr_local_byte_size > {3'b0, max_payload_decoded, 2'b0}) begin // write bigger than max_payload
                  // lastDW BE
                  if(wr_local_dw_size == 1)
                    wr_q_req_data_nxt[9:6] = 4'b0000;
@@ -270,11 +270,11 @@ module pcie_wr_q #(parameter IFACE_ID = 0)
         WR_STATE_BODY_PREP: begin
 
            if(wr_dw_len_reg > max_payload_decoded) begin // write bigger than max_payload
-              if((({1'b0, wr_host_addr_reg[11:2]} + {1'b0, max_payload_decoded}) & 11'h400) != 0) begin // 4k hit
+              if((({1'b0, wr_host_addr_reg[11:2]} + max_payload_decoded) & 11'h400) != 0) begin // 4k hit
                  wr_local_dw_size_nxt = 10'd1024 - wr_host_addr_reg[11:2];
               end
               else begin // 4k ok
-                 wr_local_dw_size_nxt = max_payload_decoded - ((max_payload_decoded - 10'd1) & wr_host_addr_reg[11:2]);
+                 wr_local_dw_size_nxt = max_payload_decoded - ((max_payload_decoded - 11'd1) & wr_host_addr_reg[11:2]);
               end
            end
            else begin // smaller than max_payload
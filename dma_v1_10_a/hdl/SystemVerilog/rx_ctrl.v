@@ -262,7 +262,7 @@ module rx_ctrl
                  mem_tx_doorbell_dne_head_nxt    = (mem_tx_doorbell_dne_head + 64) & tx_doorbell_dne_mask[`MEM_ADDR_BITS-1:0];
                  mem_vld_tx_doorbell_dne_rd_addr = mem_tx_doorbell_dne_head_nxt[`MEM_ADDR_BITS-1:11];
                  
-                 wr_q_enq_data_nxt[21:6] = 4; // byte len
+                 wr_q_enq_data_nxt[21:6] = 24; // byte len, status and spilled class state
                  wr_q_enq_data_nxt[25:22] = `ID_MEM_TX_DOORBELL_DNE; // mem select
                  wr_q_enq_data_nxt[89:26] = (host_tx_doorbell_dne_offset & ~host_tx_doorbell_dne_mask) | 
                                             ({{($bits(host_tx_doorbell_dne_mask)-`MEM_ADDR_BITS){1'b0}}, mem_tx_doorbell_dne_head} & host_tx_doorbell_dne_mask); // host address
@@ -98,6 +98,8 @@ module stats
    input logic [63:0]               stat_mac_tx_ts,
    input logic [31:0]               stat_mac_tx_word_cnt,
    input logic [31:0]               stat_mac_tx_pkt_cnt,
+   input logic [63:0]               stat_tx_time,
+   input logic [31:0]               stat_doorbell_stall_cnt,
    
    // mac rx (rx_clk)
    input logic [63:0]               stat_mac_rx_ts,
@@ -118,6 +120,7 @@ module stats
    logic [63:0]                     stat_mac_tx_ts_l;
    logic [31:0]                     stat_mac_tx_word_cnt_l;
    logic [31:0]                     stat_mac_tx_pkt_cnt_l;
+   logic [31:0]                     stat_doorbell_stall_cnt_l;
    logic [63:0]                     stat_mac_rx_ts_l;
    logic [31:0]                     stat_mac_rx_word_cnt_l;
    logic [31:0]                     stat_mac_rx_pkt_cnt_l;
@@ -130,6 +133,26 @@ module stats
    x_signal #(32) x_stat_4(rx_clk, stat_mac_rx_word_cnt, pcie_clk, stat_mac_rx_word_cnt_l);
    x_signal #(32) x_stat_5(rx_clk, stat_mac_rx_pkt_cnt,  pcie_clk, stat_mac_rx_pkt_cnt_l);
    x_signal #(32) x_stat_6(rx_clk, stat_mac_rx_err_cnt,  pcie_clk, stat_mac_rx_err_cnt_l);
+   x_signal #(32) x_stat_8(tx_clk, stat_doorbell_stall_cnt, pcie_clk, stat_doorbell_stall_cnt_l);
+
+   // the tx time keeps counting, so it crosses in gray code and the
+   // driver never sees a half updated value
+   logic [63:0]                     stat_tx_time_gray;
+   logic [63:0]                     stat_tx_time_gray_l;
+   logic [63:0]                     stat_tx_time_l;
+
+   always_ff @(posedge tx_clk) begin
+      stat_tx_time_gray <= stat_tx_time ^ (stat_tx_time >> 1);
+   end
+
+   x_signal #(64) x_stat_7(tx_clk, stat_tx_time_gray,    pcie_clk, stat_tx_time_gray_l);
+
+   always_comb begin
+      stat_tx_time_l[63] = stat_tx_time_gray_l[63];
+      for(int i = 62; i >= 0; i--) begin
+         stat_tx_time_l[i] = stat_tx_time_l[i+1] ^ stat_tx_time_gray_l[i];
+      end
+   end
    
    // -----------------------
    // -- read logic
@@ -170,11 +193,14 @@ module stats
                  16: rd_data_lo <= stat_mac_tx_ts_l[0+:32];
                  17: rd_data_lo <= stat_mac_tx_word_cnt_l[0+:32];
                  18: rd_data_lo <= stat_mac_tx_pkt_cnt_l[0+:32];
+                 19: rd_data_lo <= stat_tx_time_l[0+:32];
 
                  20: rd_data_lo <= stat_mac_rx_ts_l[0+:32];
                  21: rd_data_lo <= stat_mac_rx_word_cnt_l[0+:32];
                  22: rd_data_lo <= stat_mac_rx_pkt_cnt_l[0+:32];
                  23: rd_data_lo <= stat_mac_rx_err_cnt_l[0+:32];
+
+                 24: rd_data_lo <= stat_doorbell_stall_cnt_l[0+:32];
                  default: rd_data_lo <= 32'hcafebabe;
                endcase
             end
@@ -202,6 +228,7 @@ module stats
                  7: rd_data_hi <= stat_pcie_tx_ts[32+:32];
 
                  16: rd_data_hi <= stat_mac_tx_ts_l[32+:32];
+                 19: rd_data_hi <= stat_tx_time_l[32+:32];
 
                  20: rd_data_hi <= stat_mac_rx_ts_l[32+:32];
                  default: rd_data_hi <= 32'h0;
@@ -56,22 +56,22 @@ module tx_ctrl
 
    // feedback task queue
    output logic                       feedback_task_q_enq_en,
-   output logic [195:0]               feedback_task_q_enq_data,
+   output logic [351:0]               feedback_task_q_enq_data,
    input logic                        feedback_task_q_full,
 
    // doorbell dne queue
    output logic                       doorbell_dne_q_deq_en,
-   input logic [31:0]                 doorbell_dne_q_deq_data,
+   input logic [287:0]                doorbell_dne_q_deq_data,
    input logic                        doorbell_dne_q_empty,
 
    // tx task queue inputs
    output logic                       tx_task_q_deq_en,
-   input logic [381:0]                tx_task_q_data,
+   input logic [513:0]                tx_task_q_data,
    input logic                        tx_task_q_empty,
 
    // doorbell task queue output
    output logic                       doorbell_task_q_enq_en,
-   output logic [127:0]               doorbell_task_q_data,
+   output logic [191:0]               doorbell_task_q_data,
    input logic                        doorbell_task_q_full,
   
    // memory read interfaces
@@ -87,6 +87,14 @@ module tx_ctrl
    input logic [63:0]                 mem_tx_pkt_rd_data,
    output logic                       mem_tx_pkt_rd_en,
 
+   output logic [`MEM_ADDR_BITS-1:0]  mem_tx_bulk_rd_addr,
+   input logic [63:0]                 mem_tx_bulk_rd_data,
+   output logic                       mem_tx_bulk_rd_en,
+
+   output logic [`MEM_ADDR_BITS-1:0]  mem_tx_inline_rd_addr,
+   input logic [63:0]                 mem_tx_inline_rd_data,
+   output logic                       mem_tx_inline_rd_en,
+
    // memory write interfaces
    output logic [`MEM_ADDR_BITS-1:0]  mem_tx_doorbell_dne_wr_addr,
    output logic [63:0]                mem_tx_doorbell_dne_wr_data,
@@ -121,7 +129,14 @@ module tx_ctrl
    output logic                       mem_vld_tx_pkt_wr_clear,
    input logic                        mem_vld_tx_pkt_wr_stall,
    input logic                        mem_vld_tx_pkt_rd_bit,
+   input logic [31:0]                 mem_vld_tx_pkt_rd_bits,
    
+   output logic [`MEM_ADDR_BITS-12:0] mem_vld_tx_bulk_wr_addr,
+   output logic [31:0]                mem_vld_tx_bulk_wr_mask,
+   output logic                       mem_vld_tx_bulk_wr_clear,
+   input logic                        mem_vld_tx_bulk_wr_stall,
+   input logic                        mem_vld_tx_bulk_rd_bit,
+
    output logic [`MEM_ADDR_BITS-12:0] mem_vld_tx_dne_wr_addr,
    output logic [31:0]                mem_vld_tx_dne_wr_mask,
    output logic                       mem_vld_tx_dne_wr_clear,
@@ -134,6 +149,7 @@ module tx_ctrl
    input logic [63:0]                 tx_pkt_mask,
    input logic [63:0]                 tx_dne_mask,
    input logic [63:0]                 rx_dsc_mask,
+   input logic [15:0]                 tx_cut_lines,
 
    // pcie read queue interface
    output logic                       rd_q_enq_en,
@@ -152,6 +168,9 @@ module tx_ctrl
    output logic [63:0]                stat_mac_tx_ts,
    output logic [31:0]                stat_mac_tx_word_cnt,
    output logic [31:0]                stat_mac_tx_pkt_cnt,
+   // cycle count launch times are compared against, nicpic timecount
+   output logic [63:0]                stat_tx_time,
+   output logic [31:0]                stat_doorbell_stall_cnt,
 
    // misc
    input logic                        clk,
@@ -185,6 +204,8 @@ module tx_ctrl
    logic [31:0]                      stat_mac_tx_word_cnt_nxt;
    logic [31:0]                      stat_mac_tx_pkt_cnt_nxt;
 
+   assign stat_tx_time = time_stamp;
+
    logic [63:0]                      dma_start_nxt;
    logic [63:0]                      dma_end_nxt;
 
@@ -238,27 +259,42 @@ module tx_ctrl
    logic pkt_cm_counter_full;
    logic pkt_cm_counter_empty;
 
-   counter_fifo #(.MAX(2)) in_flight_counter(.wr_en(in_flight_counter_wr_en),
+   logic inline_counter_wr_en;
+   logic inline_counter_rd_en;
+   logic inline_counter_empty;
+
+   // completions may come back in any order, they land at their own address
+   // and the readers wait on the valid bits, so only the number is tracked
+   counter_fifo #(.MAX(`TX_RD_IN_FLIGHT)) in_flight_counter(.wr_en(in_flight_counter_wr_en),
                                              .rd_en(in_flight_counter_rd_en),
                                              .full(in_flight_counter_full),
                                              .empty(in_flight_counter_empty),
                                              .rst(rst),
                                              .clk(clk));
 
-   counter_fifo #(.MAX(8)) dsc_cm_counter(.wr_en(dsc_cm_counter_wr_en),
+   counter_fifo #(.MAX(`TX_RD_IN_FLIGHT)) dsc_cm_counter(.wr_en(dsc_cm_counter_wr_en),
                                           .rd_en(dsc_cm_counter_rd_en),
                                           .full(dsc_cm_counter_full),
                                           .empty(dsc_cm_counter_empty),
                                           .rst(rst),
                                           .clk(clk));
 
-   counter_fifo #(.MAX(8)) pkt_cm_counter(.wr_en(pkt_cm_counter_wr_en),
+   counter_fifo #(.MAX(`TX_RD_IN_FLIGHT)) pkt_cm_counter(.wr_en(pkt_cm_counter_wr_en),
                                           .rd_en(pkt_cm_counter_rd_en),
                                           .full(pkt_cm_counter_full),
                                           .empty(pkt_cm_counter_empty),
                                           .rst(rst),
                                           .clk(clk));
 
+   // inline packets queued and not sent yet. The driver reuses their memory
+   // once it has the tx completion, so that waits for them
+   counter_fifo #(.MAX(`TX_PENDING_DEPTH)) inline_counter(.wr_en(inline_counter_wr_en),
+                                          .rd_en(inline_counter_rd_en),
+                                          .full(),
+                                          .empty(inline_counter_empty),
+                                          .rst(rst),
+                                          .clk(clk));
+
    always_comb begin
 
       dsc_cm_counter_rd_en = 0;
@@ -286,21 +322,48 @@ module tx_ctrl
    logic [15:0]                      dma_rd_len;
    logic [`MEM_ADDR_BITS-1:0]        dma_rd_local_addr;
    logic [15:0]                      dma_rd_pkt_port;
+   logic [32:0]                      dma_rd_launch;
    
    logic                             rd_q_enq_en_nxt;
    logic [`RD_Q_WIDTH-1:0]           rd_q_enq_data_nxt;
 
+   // ----------------------------------
+   // -- bulk parameter table reads
+   // ----------------------------------
+   localparam MEM_TX_BULK_MASK = `MEM_N_TX_BULK*64-1;
+
+   logic [63:0]                      bulk_rd_host_addr, bulk_rd_host_addr_nxt;
+   logic [`MEM_ADDR_BITS-7:0]        bulk_rd_lines, bulk_rd_lines_nxt;
+   logic [`MEM_ADDR_BITS-1:0]        mem_tx_bulk_tail, mem_tx_bulk_tail_nxt;
+   logic [`MEM_ADDR_BITS-7:0]        bulk_lines_used, bulk_lines_used_nxt;
+   logic [`MEM_ADDR_BITS-7:0]        bulk_lines_to_end;
+   logic [3:0]                       bulk_rd_chunk;
+   logic                             bulk_rd_req;
+   logic                             bulk_rd_grant;
+
+   // read at most 8 lines at a time and never wrap the memory in one read
+   always_comb begin
+      bulk_lines_to_end = `MEM_N_TX_BULK - mem_tx_bulk_tail[`MEM_ADDR_BITS-1:6];
+      bulk_rd_chunk = 4'd8;
+      if(bulk_rd_lines < bulk_rd_chunk)
+        bulk_rd_chunk = bulk_rd_lines[3:0];
+      if(bulk_lines_to_end < bulk_rd_chunk)
+        bulk_rd_chunk = bulk_lines_to_end[3:0];
+      bulk_rd_req = (bulk_rd_lines != 0) && ((bulk_lines_used + bulk_rd_chunk) <= `MEM_N_TX_BULK);
+   end
+
    // ----------------------------------
    // -- tx pending queue
    // ----------------------------------
+   // {inline, port, start, end}
    logic                           tx_pend_q_enq_en;
-   logic [2*`MEM_ADDR_BITS+16-1:0] tx_pend_q_enq_data;
+   logic [2*`MEM_ADDR_BITS+16:0]   tx_pend_q_enq_data;
    logic                           tx_pend_q_deq_en;
-   logic [2*`MEM_ADDR_BITS+16-1:0] tx_pend_q_deq_data;
+   logic [2*`MEM_ADDR_BITS+16:0]   tx_pend_q_deq_data;
    logic                           tx_pend_q_empty;                        
    logic                           tx_pend_q_full;
    
-   fifo #(.WIDTH(`MEM_ADDR_BITS*2+16), .DEPTH(`TX_PENDING_DEPTH))
+   fifo #(.WIDTH(`MEM_ADDR_BITS*2+17), .DEPTH(`TX_PENDING_DEPTH))
    u_tx_pending_q(.enq_en(tx_pend_q_enq_en),
                   .enq_data(tx_pend_q_enq_data),
                   .deq_en(tx_pend_q_deq_en),
@@ -322,11 +385,16 @@ module tx_ctrl
    localparam SEND_DMA_RD_STATE_END = 3;
    localparam SEND_DMA_RD_STATE_WAIT = 4;
    localparam SEND_DMA_RD_STATE_DEAD = 5;
+   localparam SEND_DMA_RD_STATE_DRAIN = 6;
    
    logic [2:0] send_dma_rd_state, send_dma_rd_state_nxt;
    logic [9:0] class_index, class_index_nxt;
    logic [63:0] tokens, tokens_l, tokens_nxt;
    logic [63:0] rate, rate_nxt;
+   logic parent_vld, parent_vld_nxt;
+   logic [9:0] parent_index, parent_index_nxt;
+   logic [63:0] parent_tokens, parent_tokens_l, parent_tokens_nxt;
+   logic [23:0] parent_rate, parent_rate_nxt;
    logic [63:0] dsc_buffer_host_addr, dsc_buffer_host_addr_nxt;
    logic [31:0] dsc_buffer_mask, dsc_buffer_mask_nxt;
    logic [25:0] dsc_head_index, dsc_head_index_l, dsc_head_index_nxt;
@@ -335,6 +403,7 @@ module tx_ctrl
    logic [19:0] pkt_local_addr_first, pkt_local_addr_first_nxt;
    logic [15:0] pkt_len_first, pkt_len_first_nxt;
    logic [15:0] pkt_port_first, pkt_port_first_nxt;
+   logic [32:0] pkt_launch_first, pkt_launch_first_nxt;
 
    logic use_mem_tx_dsc, use_mem_tx_dsc_nxt;
    logic [63:0] pkt_host_addr;
@@ -342,11 +411,67 @@ module tx_ctrl
    logic [19:0] pkt_end_addr;
    logic [15:0] pkt_len;
    logic [15:0] pkt_port;
-
-   logic dsc_in_fly, dsc_in_fly_nxt;
+   logic [32:0] pkt_launch;
+
+   // host address bit 63 marks a packet the driver wrote to the inline
+   // memory, the offset in there is below it
+   localparam MEM_TX_INLINE_MASK = `MEM_N_TX_INLINE*64-1;
+   logic pkt_inline;
+
+   // descriptors requested from the host and not yet released to the
+   // descriptor reader, up to `TX_DSC_PREFETCH while a class is sending
+   logic [$clog2(`TX_DSC_PREFETCH+1)-1:0] dsc_in_fly, dsc_in_fly_nxt;
+   // what the batch put on the wire, for the per class counters
+   logic [31:0] batch_bytes, batch_bytes_nxt;
+   logic [15:0] batch_pkts, batch_pkts_nxt;
+   // tx completion held back to merge with the next batches of its class
+   logic dne_held, dne_held_nxt;
+   logic dne_merge;
+   logic dne_wr;
+   logic [9:0] dne_class, dne_class_nxt;
+   logic [25:0] dne_head, dne_head_nxt;
+   logic [15:0] dne_pkts, dne_pkts_nxt;
+   logic [15:0] dne_age, dne_age_nxt;
+   logic dsc_more;
+   assign dsc_more = (dsc_head_index_l != dsc_tail_index);
+   // descriptors the next read fetches, up to `TX_DSC_BATCH: no more than
+   // are queued or the prefetch allows, and not past the end of the host
+   // ring or of mem_tx_dsc, so one read fills consecutive lines
+   localparam DSC_LINE_BITS = $clog2(`MEM_N_TX_DSC);
+   logic [25:0] dsc_batch;
+   logic [25:0] dsc_queued;
+   logic [25:0] dsc_ring_left;
+   logic [25:0] dsc_mem_left;
+   // mem_tx_dsc lines that end a read, the descriptor reader releases the
+   // read when it gets there
+   logic [`MEM_N_TX_DSC-1:0] dsc_batch_last, dsc_batch_last_set, dsc_batch_last_clear;
+   always_comb begin
+      dsc_queued    = (dsc_tail_index - dsc_head_index_l) & dsc_buffer_mask[31:6];
+      dsc_ring_left = dsc_buffer_mask[31:6] - dsc_head_index_l + 1;
+      dsc_mem_left  = {{(26-DSC_LINE_BITS){1'b0}}, tx_dsc_mask[DSC_LINE_BITS+5:6] - mem_tx_dsc_tail[DSC_LINE_BITS+5:6]} + 1;
+      dsc_batch = `TX_DSC_BATCH;
+      if(dsc_queued < dsc_batch)
+        dsc_batch = dsc_queued;
+      if(`TX_DSC_PREFETCH - dsc_in_fly < dsc_batch)
+        dsc_batch = `TX_DSC_PREFETCH - dsc_in_fly;
+      if(dsc_ring_left < dsc_batch)
+        dsc_batch = dsc_ring_left;
+      if(dsc_mem_left < dsc_batch)
+        dsc_batch = dsc_mem_left;
+   end
+   // rates are fixed point with 8 fractional bits, see nicpic.v
    logic [63:0] tokens_needed;
-   assign tokens_needed[63:27] = 0;
-   assign tokens_needed[26:0] = pkt_len[10:0] * rate[15:0];
+   assign tokens_needed[63:40] = 0;
+   assign tokens_needed[39:0] = pkt_len[15:0] * rate[23:0];
+   logic [63:0] parent_tokens_needed;
+   assign parent_tokens_needed[63:40] = 0;
+   assign parent_tokens_needed[39:0] = pkt_len[15:0] * parent_rate[23:0];
+   // a packet with a launch time is held until the low 32 bits of
+   // time_stamp pass it, see nicpic.v
+   logic [31:0] launch_ahead;
+   assign launch_ahead = pkt_launch[31:0] - time_stamp[31:0];
+   logic launch_due;
+   assign launch_due = !pkt_launch[32] || (launch_ahead == 0) || launch_ahead[31];
 
    logic tx_dne_ready;
    assign tx_dne_ready = (((mem_tx_dne_tail + 64*8) & tx_dne_mask[`MEM_ADDR_BITS-1:0]) != mem_tx_dne_head[`MEM_ADDR_BITS-1:0]);
@@ -361,6 +486,11 @@ module tx_ctrl
       tokens = tokens_l;
       tokens_nxt = tokens_l;
       rate_nxt = rate;
+      parent_vld_nxt = parent_vld;
+      parent_index_nxt = parent_index;
+      parent_tokens = parent_tokens_l;
+      parent_tokens_nxt = parent_tokens_l;
+      parent_rate_nxt = parent_rate;
       dsc_buffer_host_addr_nxt = dsc_buffer_host_addr;
       dsc_buffer_mask_nxt = dsc_buffer_mask;
       dsc_head_index = dsc_head_index_l;
@@ -370,16 +500,29 @@ module tx_ctrl
       pkt_local_addr_first_nxt = pkt_local_addr_first;
       pkt_len_first_nxt = pkt_len_first;
       pkt_port_first_nxt = pkt_port_first;
+      pkt_launch_first_nxt = pkt_launch_first;
       mem_tx_dsc_tail_nxt = mem_tx_dsc_tail;
       mem_tx_pkt_tail_nxt = mem_tx_pkt_tail;
       use_mem_tx_dsc_nxt = use_mem_tx_dsc;
       dsc_in_fly_nxt = dsc_in_fly;
+      batch_bytes_nxt = batch_bytes;
+      batch_pkts_nxt = batch_pkts;
       dma_rd_done = 0;
       tx_pend_q_enq_data = 0;
       tx_pend_q_enq_en   = 0;
       tx_task_q_deq_en = 0;
 
       in_flight_counter_wr_en = 0;
+      inline_counter_wr_en = 0;
+      dsc_batch_last_set = 0;
+
+      dne_held_nxt = dne_held;
+      dne_merge = 0;
+      dne_wr = 0;
+      dne_class_nxt = dne_class;
+      dne_head_nxt = dne_head;
+      dne_pkts_nxt = dne_pkts;
+      dne_age_nxt = (dne_held && (dne_age != 16'hffff)) ? dne_age + 1 : dne_age;
 
       if(~rd_q_full) begin
          rd_q_enq_en_nxt = 0;
@@ -396,6 +539,7 @@ module tx_ctrl
          pkt_end_addr = dma_rd_local_addr + {{(`MEM_ADDR_BITS-$bits(dma_rd_len)){1'b0}}, dma_rd_len};
          pkt_len = dma_rd_len;
          pkt_port = dma_rd_pkt_port;
+         pkt_launch = dma_rd_launch;
       end
       else begin
          pkt_host_addr = pkt_host_addr_first;
@@ -403,6 +547,13 @@ module tx_ctrl
          pkt_end_addr = pkt_local_addr_first + {{(`MEM_ADDR_BITS-$bits(pkt_len_first)){1'b0}}, pkt_len_first};
          pkt_len = pkt_len_first;
          pkt_port = pkt_port_first;
+         pkt_launch = pkt_launch_first;
+      end
+
+      pkt_inline = pkt_host_addr[63];
+      if(pkt_inline) begin
+         pkt_local_addr = pkt_host_addr[`MEM_ADDR_BITS-1:0] & MEM_TX_INLINE_MASK;
+         pkt_end_addr = pkt_local_addr + {4'b0, pkt_len};
       end
 
       mem_tx_dne_clear        = (mem_tx_dne_tail + 64*8) & tx_dne_mask[`MEM_ADDR_BITS-1:0];
@@ -421,6 +572,8 @@ module tx_ctrl
       feedback_task_q_enq_data = 0;
 
       dma_start_nxt = dma_start;
+
+      bulk_rd_grant = 0;
       
       case(send_dma_rd_state)
          SEND_DMA_RD_STATE_IDLE: begin
@@ -428,7 +581,11 @@ module tx_ctrl
                // read tokens, buffer information and first descriptor from task queue
                tx_task_q_deq_en = 1;
 
-               {class_index_nxt,
+               {parent_vld_nxt,
+               parent_index_nxt,
+               parent_tokens,
+               parent_rate_nxt,
+               class_index_nxt,
                tokens,
                rate_nxt,
                dsc_buffer_host_addr_nxt,
@@ -437,11 +594,14 @@ module tx_ctrl
                dsc_tail_index_nxt,
                pkt_host_addr_first_nxt,
                pkt_len_first_nxt,
-               pkt_port_first_nxt} = tx_task_q_data;
+               pkt_port_first_nxt,
+               pkt_launch_first_nxt} = tx_task_q_data;
 
                pkt_local_addr_first_nxt = mem_tx_pkt_tail + pkt_host_addr_first_nxt[5:0];
                // scheduler should inforce initial bigger relationship
-               tokens_nxt = tokens - pkt_len_first_nxt[10:0] * rate_nxt[15:0];
+               tokens_nxt = tokens - pkt_len_first_nxt[15:0] * rate_nxt[23:0];
+               // the parent rate is 0 for classes without a parent
+               parent_tokens_nxt = parent_tokens - pkt_len_first_nxt[15:0] * parent_rate_nxt[23:0];
                use_mem_tx_dsc_nxt = 0;
 
                /*
@@ -458,12 +618,13 @@ module tx_ctrl
                */
                
 
+               dsc_in_fly_nxt = 0;
+               batch_bytes_nxt = 0;
+               batch_pkts_nxt = 0;
                if(dsc_head_index_nxt != dsc_tail_index_nxt) begin
-                  dsc_in_fly_nxt = 1;
                   send_dma_rd_state_nxt = SEND_DMA_RD_STATE_DSC;
                end
                else begin
-                  dsc_in_fly_nxt = 0;
                   send_dma_rd_state_nxt = SEND_DMA_RD_STATE_PKT;
                end
             end
@@ -475,15 +636,18 @@ module tx_ctrl
             // 64 bytes long on host. Acutal length is 16 bytes.
             if(~rd_q_full && /*!mem_vld_tx_dne_wr_stall && tx_dne_ready &&*/ !in_flight_counter_full) begin
 
+               // read a batch of descriptors at once
                rd_q_enq_en_nxt = 1;
-               rd_q_enq_data_nxt[15:0] = 16'd64;
+               rd_q_enq_data_nxt[15:0] = {dsc_batch[9:0], 6'b0};
                rd_q_enq_data_nxt[19:16] = `ID_MEM_TX_DSC; // mem_select
                rd_q_enq_data_nxt[83:20] = dsc_buffer_host_addr + {{(58-$bits(dsc_head_index)){1'b0}},dsc_head_index, 6'b0}; // host addr
                rd_q_enq_data_nxt[84+:`MEM_ADDR_BITS] = mem_tx_dsc_tail; // addr
+               dsc_batch_last_set[mem_tx_dsc_tail[DSC_LINE_BITS+5:6] + dsc_batch[DSC_LINE_BITS-1:0] - 1'b1] = 1;
                // move host dsc head ahead
-               dsc_head_index_nxt = (dsc_head_index + 1) & dsc_buffer_mask[31:6];
+               dsc_head_index_nxt = (dsc_head_index + dsc_batch) & dsc_buffer_mask[31:6];
                // move mem dsc tail ahead
-               mem_tx_dsc_tail_nxt = (mem_tx_dsc_tail + 64) & tx_dsc_mask[`MEM_ADDR_BITS-1:0];
+               mem_tx_dsc_tail_nxt = (mem_tx_dsc_tail + {dsc_batch[`MEM_ADDR_BITS-7:0], 6'b0}) & tx_dsc_mask[`MEM_ADDR_BITS-1:0];
+               dsc_in_fly_nxt = dsc_in_fly + dsc_batch;
                // go to next state
                send_dma_rd_state_nxt = SEND_DMA_RD_STATE_PKT;
                // count in flight mem read request
@@ -510,27 +674,40 @@ module tx_ctrl
          end
 
          SEND_DMA_RD_STATE_PKT: begin
-            if((~rd_q_full) && (~tx_pend_q_full) && /*!mem_vld_tx_dne_wr_stall && tx_dne_ready &&*/ !in_flight_counter_full && ((mem_tx_pkt_head_bk[14:0]-mem_tx_pkt_tail[14:0]-15'd64)>=15'd1664)) begin
-               // dma rd pkt
-               rd_q_enq_en_nxt = 1;
-               if(pkt_local_addr[5:0] + pkt_len[5:0] == 6'b0) begin
-                  rd_q_enq_data_nxt[15:0] = pkt_len[15:0];
+            if((~tx_pend_q_full) && (pkt_inline || ((~rd_q_full) && /*!mem_vld_tx_dne_wr_stall && tx_dne_ready &&*/ !in_flight_counter_full && (((mem_tx_pkt_head_bk-mem_tx_pkt_tail-64) & tx_pkt_mask[`MEM_ADDR_BITS-1:0])>=1664)))) begin
+               if(pkt_inline) begin
+                  // already on the card, nothing to read
+                  inline_counter_wr_en = 1;
                end
                else begin
-                  rd_q_enq_data_nxt[15:0] = pkt_len[15:0] + {10'b0, 6'd0 - (pkt_local_addr[5:0] + pkt_len[5:0])};
-                  rd_q_enq_data_nxt[19:16] = `ID_MEM_TX_PKT; // mem_select
-                  rd_q_enq_data_nxt[83:20] = pkt_host_addr; // host addr
-                  rd_q_enq_data_nxt[84+:`MEM_ADDR_BITS] = pkt_local_addr; // addr
+                  // dma rd pkt
+                  rd_q_enq_en_nxt = 1;
+                  if(pkt_local_addr[5:0] + pkt_len[5:0] == 6'b0) begin
+                     rd_q_enq_data_nxt[15:0] = pkt_len[15:0];
+                  end
+                  else begin
+                     rd_q_enq_data_nxt[15:0] = pkt_len[15:0] + {10'b0, 6'd0 - (pkt_local_addr[5:0] + pkt_len[5:0])};
+                     rd_q_enq_data_nxt[19:16] = `ID_MEM_TX_PKT; // mem_select
+                     rd_q_enq_data_nxt[83:20] = pkt_host_addr; // host addr
+                     rd_q_enq_data_nxt[84+:`MEM_ADDR_BITS] = pkt_local_addr; // addr
+                  end
+                  // count in flight mem read request
+                  in_flight_counter_wr_en = 1;
                end
 
                // push pkt to pending queue
+               tx_pend_q_enq_data[2*`MEM_ADDR_BITS+16] = pkt_inline;
                tx_pend_q_enq_data[2*`MEM_ADDR_BITS+:16] = pkt_port;
                tx_pend_q_enq_data[`MEM_ADDR_BITS+:`MEM_ADDR_BITS] = pkt_local_addr;
                tx_pend_q_enq_data[0+:`MEM_ADDR_BITS] = pkt_end_addr;
                tx_pend_q_enq_en = 1;
+               batch_bytes_nxt = batch_bytes + pkt_len;
+               batch_pkts_nxt = batch_pkts + 1;
               
                // move mem_tx_pkt_tail pointer
-               if(pkt_end_addr[5:0] == 0) begin
+               if(pkt_inline) begin
+               end
+               else if(pkt_end_addr[5:0] == 0) begin
                   mem_tx_pkt_tail_nxt = pkt_end_addr & tx_pkt_mask[`MEM_ADDR_BITS-1:0];
                end
                else begin
@@ -540,19 +717,17 @@ module tx_ctrl
                use_mem_tx_dsc_nxt = 1;
                if(use_mem_tx_dsc) begin
                   dma_rd_done = 1;
+                  dsc_in_fly_nxt = dsc_in_fly - 1;
                end
             
                // move to next state
-               if(dsc_in_fly) begin
+               if((dsc_in_fly_nxt != 0) || dsc_more) begin
                   send_dma_rd_state_nxt = SEND_DMA_RD_STATE_WAIT;
                end
                else begin
                   send_dma_rd_state_nxt = SEND_DMA_RD_STATE_END;
                end
 
-               // count in flight mem read request
-               in_flight_counter_wr_en = 1;
-
                /*
                // debug begin
                mem_tx_dne_wr_en = 1;
@@ -571,49 +746,97 @@ module tx_ctrl
          end
 
          SEND_DMA_RD_STATE_WAIT: begin
-            if(dma_rd_go) begin
-               if(tokens >= tokens_needed) begin
+            // keep the descriptor prefetch topped up, so the packets of one
+            // class do not each wait a host round trip for their descriptor
+            if(dsc_more && (dsc_in_fly < `TX_DSC_PREFETCH) && ~rd_q_full && !in_flight_counter_full) begin
+               rd_q_enq_en_nxt = 1;
+               rd_q_enq_data_nxt[15:0] = {dsc_batch[9:0], 6'b0};
+               rd_q_enq_data_nxt[19:16] = `ID_MEM_TX_DSC; // mem_select
+               rd_q_enq_data_nxt[83:20] = dsc_buffer_host_addr + {{(58-$bits(dsc_head_index)){1'b0}},dsc_head_index, 6'b0}; // host addr
+               rd_q_enq_data_nxt[84+:`MEM_ADDR_BITS] = mem_tx_dsc_tail; // addr
+               dsc_batch_last_set[mem_tx_dsc_tail[DSC_LINE_BITS+5:6] + dsc_batch[DSC_LINE_BITS-1:0] - 1'b1] = 1;
+               dsc_head_index_nxt = (dsc_head_index + dsc_batch) & dsc_buffer_mask[31:6];
+               mem_tx_dsc_tail_nxt = (mem_tx_dsc_tail + {dsc_batch[`MEM_ADDR_BITS-7:0], 6'b0}) & tx_dsc_mask[`MEM_ADDR_BITS-1:0];
+               dsc_in_fly_nxt = dsc_in_fly + dsc_batch;
+               in_flight_counter_wr_en = 1;
+            end
+            else if(dma_rd_go) begin
+               if((tokens >= tokens_needed) && (parent_tokens >= parent_tokens_needed) && launch_due) begin
                   tokens_nxt = tokens - tokens_needed;
-                  if(dsc_head_index != dsc_tail_index) begin
-                     dsc_in_fly_nxt = 1;
-                     send_dma_rd_state_nxt = SEND_DMA_RD_STATE_DSC;
+                  parent_tokens_nxt = parent_tokens - parent_tokens_needed;
+                  send_dma_rd_state_nxt = SEND_DMA_RD_STATE_PKT;
+               end
+               else begin
+                  // this packet goes back to the scheduler as the pending
+                  // one, prefetched descriptors behind it are dropped
+                  pkt_host_addr_first_nxt = dma_rd_host_addr;
+                  pkt_len_first_nxt = dma_rd_len;
+                  pkt_port_first_nxt = dma_rd_pkt_port;
+                  pkt_launch_first_nxt = dma_rd_launch;
+                  use_mem_tx_dsc_nxt = 0;
+                  dma_rd_done = 1;
+                  dsc_in_fly_nxt = dsc_in_fly - 1;
+                  if(dsc_in_fly_nxt != 0) begin
+                     send_dma_rd_state_nxt = SEND_DMA_RD_STATE_DRAIN;
                   end
                   else begin
-                     dsc_in_fly_nxt = 0;
-                     send_dma_rd_state_nxt = SEND_DMA_RD_STATE_PKT;
+                     send_dma_rd_state_nxt = SEND_DMA_RD_STATE_END;
                   end
                end
-               else begin
+            end
+            else if((dsc_in_fly == 0) && !dsc_more) begin
+               send_dma_rd_state_nxt = SEND_DMA_RD_STATE_END;
+            end
+         end
+
+         SEND_DMA_RD_STATE_DRAIN: begin
+            // hand the host index back for every descriptor dropped
+            if(dma_rd_go) begin
+               dma_rd_done = 1;
+               dsc_in_fly_nxt = dsc_in_fly - 1;
+               dsc_head_index_nxt = (dsc_head_index - 1) & dsc_buffer_mask[31:6];
+               if(dsc_in_fly_nxt == 0) begin
                   send_dma_rd_state_nxt = SEND_DMA_RD_STATE_END;
                end
             end
          end
 
          SEND_DMA_RD_STATE_END: begin
-            if(!mem_vld_tx_dne_wr_stall && !feedback_task_q_full && tx_dne_ready) begin
-               // interrupt host
-               mem_tx_dne_wr_en = 1;
-               mem_tx_dne_wr_mask = 8'hff;
-               mem_tx_dne_wr_data[15:0] = 'd1;
-               mem_tx_dne_wr_data[25:16] = class_index;
-               mem_tx_dne_wr_data[63:32] = {6'b0, dsc_head_index};
-               mem_tx_dne_wr_addr = mem_tx_dne_tail;
-               mem_tx_dne_tail_nxt = (mem_tx_dne_tail + 64) & tx_dne_mask[`MEM_ADDR_BITS-1:0];
-               mem_vld_tx_dne_wr_clear = 1;
+            // the completion frees the inline memory of the batch
+            if(!mem_vld_tx_dne_wr_stall && !feedback_task_q_full && tx_dne_ready && inline_counter_empty) begin
+               // merge the completion into the held one of the same class,
+               // another class has the held one written first
+               dne_merge = 1;
+               if(dne_held && (dne_class != class_index)) begin
+                  dne_wr = 1;
+                  dne_pkts_nxt = batch_pkts;
+                  dne_age_nxt = 0;
+               end
+               else if(dne_held) begin
+                  dne_pkts_nxt = dne_pkts + batch_pkts;
+               end
+               else begin
+                  dne_pkts_nxt = batch_pkts;
+                  dne_age_nxt = 0;
+               end
+               dne_held_nxt = 1;
+               dne_class_nxt = class_index;
+               dne_head_nxt = dsc_head_index;
 
                // feedback to scheduler
                feedback_task_q_enq_en = 1;
-               feedback_task_q_enq_data = {class_index,
+               feedback_task_q_enq_data = {batch_bytes,
+                                           batch_pkts,
+                                           parent_vld,
+                                           parent_index,
+                                           parent_tokens,
+                                           class_index,
                                            tokens,
                                            dsc_head_index,
                                            pkt_host_addr,
                                            pkt_port,
-                                           pkt_len};
-
-               // clear the last descriptor
-               if(dsc_in_fly) begin
-                  dma_rd_done = 1;
-               end
+                                           pkt_len,
+                                           pkt_launch};
 
                // move to idle state
                send_dma_rd_state_nxt = SEND_DMA_RD_STATE_IDLE;
@@ -624,6 +847,37 @@ module tx_ctrl
             send_dma_rd_state_nxt = SEND_DMA_RD_STATE_DEAD;
          end
       endcase
+
+      // bulk parameter table reads take the read queue when the task path does not
+      if(bulk_rd_req && ~rd_q_full && !rd_q_enq_en_nxt) begin
+         rd_q_enq_en_nxt = 1;
+         rd_q_enq_data_nxt[15:0] = {6'b0, bulk_rd_chunk, 6'b0};
+         rd_q_enq_data_nxt[19:16] = `ID_MEM_TX_BULK; // mem_select
+         rd_q_enq_data_nxt[83:20] = bulk_rd_host_addr; // host addr
+         rd_q_enq_data_nxt[84+:`MEM_ADDR_BITS] = mem_tx_bulk_tail; // addr
+         bulk_rd_grant = 1;
+      end
+
+      // the held completion goes out once it is big or old enough, and
+      // before any doorbell completion: an eviction report has to follow
+      // the completions of the evicted class
+      if(dne_held && !dne_merge && !mem_vld_tx_dne_wr_stall && tx_dne_ready &&
+         ((dne_pkts >= `TX_DNE_COALESCE) || (dne_age >= `TX_DNE_TIMEOUT) || !doorbell_dne_q_empty)) begin
+         dne_wr = 1;
+         dne_held_nxt = 0;
+      end
+
+      if(dne_wr) begin
+         // interrupt host
+         mem_tx_dne_wr_en = 1;
+         mem_tx_dne_wr_mask = 8'hff;
+         mem_tx_dne_wr_data[15:0] = 'd1;
+         mem_tx_dne_wr_data[25:16] = dne_class;
+         mem_tx_dne_wr_data[63:32] = {6'b0, dne_head};
+         mem_tx_dne_wr_addr = mem_tx_dne_tail;
+         mem_tx_dne_tail_nxt = (mem_tx_dne_tail + 64) & tx_dne_mask[`MEM_ADDR_BITS-1:0];
+         mem_vld_tx_dne_wr_clear = 1;
+      end
    
    end
    
@@ -633,6 +887,10 @@ module tx_ctrl
          class_index <= 0;
          tokens_l <= 0;
          rate <= 0;
+         parent_vld <= 0;
+         parent_index <= 0;
+         parent_tokens_l <= 0;
+         parent_rate <= 0;
          dsc_buffer_host_addr <= 0;
          dsc_buffer_mask <= 0;
          dsc_head_index_l <= 0;
@@ -641,10 +899,17 @@ module tx_ctrl
          pkt_local_addr_first <= 0;
          pkt_len_first <= 0;
          pkt_port_first <= 0;
+         pkt_launch_first <= 0;
          use_mem_tx_dsc <= 0;
          mem_tx_dsc_tail <= 0;
          mem_tx_pkt_tail <= 0;
          dsc_in_fly <= 0;
+         dsc_batch_last <= 0;
+         dne_held <= 0;
+         dne_pkts <= 0;
+         dne_age <= 0;
+         batch_bytes <= 0;
+         batch_pkts <= 0;
          rd_q_enq_en <= 0;
          mem_tx_dne_tail <= 0;
       end
@@ -653,6 +918,10 @@ module tx_ctrl
          class_index <= class_index_nxt;
          tokens_l <= tokens_nxt;
          rate <= rate_nxt;
+         parent_vld <= parent_vld_nxt;
+         parent_index <= parent_index_nxt;
+         parent_tokens_l <= parent_tokens_nxt;
+         parent_rate <= parent_rate_nxt;
          dsc_buffer_host_addr <= dsc_buffer_host_addr_nxt;
          dsc_buffer_mask <= dsc_buffer_mask_nxt;
          dsc_head_index_l <= dsc_head_index_nxt;
@@ -661,10 +930,19 @@ module tx_ctrl
          pkt_local_addr_first <= pkt_local_addr_first_nxt;
          pkt_len_first <= pkt_len_first_nxt;
          pkt_port_first <= pkt_port_first_nxt;
+         pkt_launch_first <= pkt_launch_first_nxt;
          use_mem_tx_dsc <= use_mem_tx_dsc_nxt;
          mem_tx_dsc_tail <= mem_tx_dsc_tail_nxt;
          mem_tx_pkt_tail <= mem_tx_pkt_tail_nxt;
          dsc_in_fly <= dsc_in_fly_nxt;
+         dsc_batch_last <= (dsc_batch_last | dsc_batch_last_set) & ~dsc_batch_last_clear;
+         dne_held <= dne_held_nxt;
+         dne_class <= dne_class_nxt;
+         dne_head <= dne_head_nxt;
+         dne_pkts <= dne_pkts_nxt;
+         dne_age <= dne_age_nxt;
+         batch_bytes <= batch_bytes_nxt;
+         batch_pkts <= batch_pkts_nxt;
          rd_q_enq_en <= rd_q_enq_en_nxt;
          mem_tx_dne_tail <= mem_tx_dne_tail_nxt;
       end
@@ -676,13 +954,17 @@ module tx_ctrl
    // -------------------------------------------
    logic [15:0]               dma_rd_len_nxt;
    logic [15:0]               dma_rd_pkt_port_nxt;
+   logic [63:0]               dma_rd_host_addr_reg, dma_rd_host_addr_reg_nxt;
    
+   // descriptor: [63:48] len, [47:32] port in the first word, host address
+   // in the second, launch time ([32] valid) in the third
    localparam READ_TX_DSC_STATE_IDLE      = 0;
    localparam READ_TX_DSC_STATE_L1        = 1;
    localparam READ_TX_DSC_STATE_L2        = 2;
    localparam READ_TX_DSC_STATE_WAIT      = 3;   
+   localparam READ_TX_DSC_STATE_L3        = 4;
 
-   logic [1:0]                 read_tx_dsc_state, read_tx_dsc_state_nxt;
+   logic [2:0]                 read_tx_dsc_state, read_tx_dsc_state_nxt;
 
    logic [`MEM_ADDR_BITS-1:0]  mem_tx_dsc_head_reg, mem_tx_dsc_head_reg_nxt;
    
@@ -700,22 +982,26 @@ module tx_ctrl
       dma_rd_len_nxt        = dma_rd_len;
 
       dma_rd_host_addr = 0;
+      dma_rd_launch    = 0;
       dma_rd_go        = 0;
       dma_rd_local_addr = 0;
+      dma_rd_host_addr_reg_nxt = dma_rd_host_addr_reg;
 
       dma_rd_pkt_port_nxt = dma_rd_pkt_port;
 
       mem_tx_dsc_head_reg_nxt = mem_tx_dsc_head_reg;
 
       dsc_cm_counter_wr_en = 0;
+      dsc_batch_last_clear = 0;
 
       dma_end_nxt = dma_end;
 
       case(read_tx_dsc_state)
         READ_TX_DSC_STATE_IDLE: begin
            if(mem_vld_tx_dsc_rd_bit && !dsc_cm_counter_full) begin
-              // count dscriptor completion
-              dsc_cm_counter_wr_en = 1;
+              // count dscriptor completion, once for every read
+              dsc_cm_counter_wr_en = dsc_batch_last[mem_tx_dsc_head[DSC_LINE_BITS+5:6]];
+              dsc_batch_last_clear[mem_tx_dsc_head[DSC_LINE_BITS+5:6]] = 1;
               // move head pointer
               mem_tx_dsc_head_nxt = (mem_tx_dsc_head + 8) & tx_dsc_mask[`MEM_ADDR_BITS-1:0];
               mem_tx_dsc_head_reg_nxt = mem_tx_dsc_head;
@@ -730,13 +1016,24 @@ module tx_ctrl
            dma_rd_len_nxt = mem_tx_dsc_rd_data[63:48];
            dma_rd_pkt_port_nxt   = mem_tx_dsc_rd_data[47:32];
 
+           // move head pointer
+           mem_tx_dsc_head_nxt = (mem_tx_dsc_head + 8) & tx_dsc_mask[`MEM_ADDR_BITS-1:0];
+
            // advance state
            read_tx_dsc_state_nxt = READ_TX_DSC_STATE_L2;
         end
         READ_TX_DSC_STATE_L2: begin
+           // store host address
+           dma_rd_host_addr_reg_nxt = mem_tx_dsc_rd_data;
+
+           // advance state
+           read_tx_dsc_state_nxt = READ_TX_DSC_STATE_L3;
+        end
+        READ_TX_DSC_STATE_L3: begin
            
            //if((mem_tx_dsc_rd_data != 0)) begin // data not already in mem_tx_pkt, dma_read
-              dma_rd_host_addr = mem_tx_dsc_rd_data;
+              dma_rd_host_addr = dma_rd_host_addr_reg;
+              dma_rd_launch = mem_tx_dsc_rd_data[32:0];
               dma_rd_local_addr = mem_tx_pkt_tail + {14'd0, dma_rd_host_addr[5:0]};
               dma_rd_go = 1;
            //end
@@ -746,7 +1043,7 @@ module tx_ctrl
               read_tx_dsc_state_nxt = READ_TX_DSC_STATE_WAIT;
               
               // move head pointer
-              mem_tx_dsc_head_nxt = (mem_tx_dsc_head + 56) & tx_dsc_mask[`MEM_ADDR_BITS-1:0];
+              mem_tx_dsc_head_nxt = (mem_tx_dsc_head + 48) & tx_dsc_mask[`MEM_ADDR_BITS-1:0];
            end
         end
 
@@ -773,19 +1070,46 @@ module tx_ctrl
 
       mem_tx_dsc_head_reg <= mem_tx_dsc_head_reg_nxt;
       dma_rd_pkt_port <= dma_rd_pkt_port_nxt;
+      dma_rd_host_addr_reg <= dma_rd_host_addr_reg_nxt;
    end
 
    // -------------------------------------------
    // -- read new doorbells and process it
    // -------------------------------------------
    localparam READ_TX_DOORBELL_STATE_IDLE      = 0;
-   localparam READ_TX_DOORBELL_STATE_L1        = 1;
    localparam READ_TX_DOORBELL_STATE_L2        = 2;
    localparam READ_TX_DOORBELL_STATE_WAIT      = 3;
-
-   logic [1:0]                 read_tx_doorbell_state, read_tx_doorbell_state_nxt;
+   localparam READ_TX_DOORBELL_STATE_BULK_IDLE = 4;
+   localparam READ_TX_DOORBELL_STATE_BULK_L1   = 5;
+   localparam READ_TX_DOORBELL_STATE_BULK_L2   = 6;
+   localparam READ_TX_DOORBELL_STATE_BULK_WAIT = 7;
+   localparam READ_TX_DOORBELL_STATE_L3        = 8;
+
+   // SET_PARAMS_BULK is expanded here into one SET_PARAMS per class.
+   // doorbell: [5:0] inst, [15:6] first class, [16] list mode, [47:32] count,
+   //           [127:64] host address of the 64 byte aligned parameter table.
+   // table entry (16 bytes): [63:0] rate, [103:64] tokens_max, [127:112] class
+   // (class only used in list mode, otherwise classes are first, first+1, ...)
+   localparam DOORBELL_SET_PARAMS      = 7;
+   localparam DOORBELL_SET_PARAMS_BULK = 8;
+
+   logic [3:0]                 read_tx_doorbell_state, read_tx_doorbell_state_nxt;
    logic [`MEM_ADDR_BITS-1:0]  mem_tx_doorbell_head_reg, mem_tx_doorbell_head_reg_nxt;
    logic [63:0]                doorbell_lo_reg, doorbell_lo_reg_nxt;
+   logic [63:0]                doorbell_hi_reg, doorbell_hi_reg_nxt;
+
+   logic [`MEM_ADDR_BITS-1:0]  mem_tx_bulk_head, mem_tx_bulk_head_nxt;
+   logic [`MEM_ADDR_BITS-1:0]  mem_tx_bulk_head_reg, mem_tx_bulk_head_reg_nxt;
+   logic [15:0]                bulk_entries, bulk_entries_nxt;
+   logic [9:0]                 bulk_class_index, bulk_class_index_nxt;
+   logic                       bulk_list, bulk_list_nxt;
+   logic [63:0]                bulk_rate, bulk_rate_nxt;
+   logic [16:0]                bulk_entries_round;
+   assign bulk_entries_round = {1'b0, doorbell_lo_reg[47:32]} + 17'd3;
+
+   // doorbells are read back to back, a line every three cycles. Cycles
+   // one waits on a full nicpic doorbell queue are counted
+   logic [31:0]                stat_doorbell_stall_cnt_nxt;
    
    always_comb begin
       read_tx_doorbell_state_nxt = read_tx_doorbell_state;      
@@ -800,45 +1124,175 @@ module tx_ctrl
 
       mem_tx_doorbell_head_reg_nxt = mem_tx_doorbell_head_reg;
       doorbell_lo_reg_nxt = doorbell_lo_reg;
+      doorbell_hi_reg_nxt = doorbell_hi_reg;
 
       doorbell_task_q_enq_en = 0;
       doorbell_task_q_data = 0;
 
+      mem_tx_bulk_rd_en = 1;
+      mem_tx_bulk_rd_addr = mem_tx_bulk_head;
+
+      mem_vld_tx_bulk_wr_addr  = mem_tx_bulk_head_reg[`MEM_ADDR_BITS-1:11];
+      mem_vld_tx_bulk_wr_mask  = 1 << mem_tx_bulk_head_reg[10:6];
+      mem_vld_tx_bulk_wr_clear = 0;
+
+      mem_tx_bulk_head_nxt = mem_tx_bulk_head;
+      mem_tx_bulk_head_reg_nxt = mem_tx_bulk_head_reg;
+      bulk_entries_nxt = bulk_entries;
+      bulk_class_index_nxt = bulk_class_index;
+      bulk_list_nxt = bulk_list;
+      bulk_rate_nxt = bulk_rate;
+
+      stat_doorbell_stall_cnt_nxt = stat_doorbell_stall_cnt;
+
+      bulk_rd_host_addr_nxt = bulk_rd_host_addr;
+      bulk_rd_lines_nxt = bulk_rd_lines;
+      mem_tx_bulk_tail_nxt = mem_tx_bulk_tail;
+      bulk_lines_used_nxt = bulk_lines_used;
+
+      // table read issued by the send dma rd block
+      if(bulk_rd_grant) begin
+         bulk_rd_host_addr_nxt = bulk_rd_host_addr + {54'b0, bulk_rd_chunk, 6'b0};
+         bulk_rd_lines_nxt = bulk_rd_lines - bulk_rd_chunk;
+         mem_tx_bulk_tail_nxt = (mem_tx_bulk_tail + {bulk_rd_chunk, 6'b0}) & MEM_TX_BULK_MASK;
+         bulk_lines_used_nxt = bulk_lines_used + bulk_rd_chunk;
+      end
+
       case(read_tx_doorbell_state)
         READ_TX_DOORBELL_STATE_IDLE: begin
            if(mem_vld_tx_doorbell_rd_bit) begin
-              // move head pointer
+              // the first word comes with the valid bit, store it
+              doorbell_lo_reg_nxt = mem_tx_doorbell_rd_data;
+              // move head pointer, the next word is read right away
               mem_tx_doorbell_head_nxt = (mem_tx_doorbell_head + 8) & tx_doorbell_mask[`MEM_ADDR_BITS-1:0];
+              mem_tx_doorbell_rd_addr = mem_tx_doorbell_head_nxt;
               mem_tx_doorbell_head_reg_nxt = mem_tx_doorbell_head;
               // advance state
-              read_tx_doorbell_state_nxt = READ_TX_DSC_STATE_L1;
+              read_tx_doorbell_state_nxt = READ_TX_DOORBELL_STATE_L2;
            end
         end
-        READ_TX_DOORBELL_STATE_L1: begin
-           // store read line
-           doorbell_lo_reg_nxt = mem_tx_doorbell_rd_data;
-
-           // advance state
-           read_tx_doorbell_state_nxt = READ_TX_DSC_STATE_L2;
-        end
         READ_TX_DOORBELL_STATE_L2: begin
-           if(~doorbell_task_q_full) begin
+           if(doorbell_lo_reg[5:0] == DOORBELL_SET_PARAMS_BULK) begin
+              // start fetching the parameter table
+              bulk_class_index_nxt = doorbell_lo_reg[15:6];
+              bulk_list_nxt = doorbell_lo_reg[16];
+              bulk_entries_nxt = doorbell_lo_reg[47:32];
+              bulk_rd_host_addr_nxt = mem_tx_doorbell_rd_data;
+              bulk_rd_lines_nxt = bulk_entries_round[16:2];
+
               // advance state
-              read_tx_doorbell_state_nxt = READ_TX_DSC_STATE_WAIT;
+              read_tx_doorbell_state_nxt = READ_TX_DOORBELL_STATE_WAIT;
+
+              // move head pointer
+              mem_tx_doorbell_head_nxt = (mem_tx_doorbell_head + 56) & tx_doorbell_mask[`MEM_ADDR_BITS-1:0];
+           end
+           else begin
+              // store read line
+              doorbell_hi_reg_nxt = mem_tx_doorbell_rd_data;
+
+              // move head pointer, read the third word
+              mem_tx_doorbell_head_nxt = (mem_tx_doorbell_head + 8) & tx_doorbell_mask[`MEM_ADDR_BITS-1:0];
+              mem_tx_doorbell_rd_addr = mem_tx_doorbell_head_nxt;
 
-              // push doorbell task queue
+              // advance state
+              read_tx_doorbell_state_nxt = READ_TX_DOORBELL_STATE_L3;
+           end
+        end
+        READ_TX_DOORBELL_STATE_L3: begin
+           if(~doorbell_task_q_full) begin
+              // push doorbell task queue, the third word is the launch
+              // time of ADD_DSC
               doorbell_task_q_enq_en = 1;
-              doorbell_task_q_data = {mem_tx_doorbell_rd_data, doorbell_lo_reg};
+              doorbell_task_q_data = {mem_tx_doorbell_rd_data, doorbell_hi_reg, doorbell_lo_reg};
               
               // move head pointer
-              mem_tx_doorbell_head_nxt = (mem_tx_doorbell_head + 56) & tx_doorbell_mask[`MEM_ADDR_BITS-1:0];
+              mem_tx_doorbell_head_nxt = (mem_tx_doorbell_head + 48) & tx_doorbell_mask[`MEM_ADDR_BITS-1:0];
+
+              // clear the valid bit now and look at the next line, unless
+              // the clear has to wait
+              if(~mem_vld_tx_doorbell_wr_stall) begin
+                 mem_vld_tx_doorbell_wr_clear = 1;
+                 mem_tx_doorbell_rd_addr = mem_tx_doorbell_head_nxt;
+                 read_tx_doorbell_state_nxt = READ_TX_DOORBELL_STATE_IDLE;
+              end
+              else begin
+                 read_tx_doorbell_state_nxt = READ_TX_DOORBELL_STATE_WAIT;
+              end
+           end
+           else begin
+              stat_doorbell_stall_cnt_nxt = stat_doorbell_stall_cnt + 1;
            end
         end
 
         READ_TX_DOORBELL_STATE_WAIT: begin
            if(~mem_vld_tx_doorbell_wr_stall) begin
               mem_vld_tx_doorbell_wr_clear = 1;
-              read_tx_doorbell_state_nxt = READ_TX_DOORBELL_STATE_IDLE;
+              if(bulk_entries != 0)
+                read_tx_doorbell_state_nxt = READ_TX_DOORBELL_STATE_BULK_IDLE;
+              else
+                read_tx_doorbell_state_nxt = READ_TX_DOORBELL_STATE_IDLE;
+           end
+        end
+
+        READ_TX_DOORBELL_STATE_BULK_IDLE: begin
+           if(mem_vld_tx_bulk_rd_bit) begin
+              // move head pointer
+              mem_tx_bulk_head_nxt = (mem_tx_bulk_head + 8) & MEM_TX_BULK_MASK;
+              mem_tx_bulk_head_reg_nxt = mem_tx_bulk_head;
+              // advance state
+              read_tx_doorbell_state_nxt = READ_TX_DOORBELL_STATE_BULK_L1;
+           end
+        end
+
+        READ_TX_DOORBELL_STATE_BULK_L1: begin
+           // store rate
+           bulk_rate_nxt = mem_tx_bulk_rd_data;
+
+           // advance state
+           read_tx_doorbell_state_nxt = READ_TX_DOORBELL_STATE_BULK_L2;
+        end
+
+        READ_TX_DOORBELL_STATE_BULK_L2: begin
+           if(~doorbell_task_q_full) begin
+              // push one SET_PARAMS, the last one asks for a doorbell completion
+              doorbell_task_q_enq_en = 1;
+              doorbell_task_q_data[127:64] = bulk_rate;
+              doorbell_task_q_data[63:24] = mem_tx_bulk_rd_data[39:0];
+              doorbell_task_q_data[16] = (bulk_entries == 1);
+              doorbell_task_q_data[15:6] = bulk_list ? mem_tx_bulk_rd_data[57:48] : bulk_class_index;
+              doorbell_task_q_data[5:0] = DOORBELL_SET_PARAMS;
+
+              bulk_class_index_nxt = bulk_class_index + 1;
+              bulk_entries_nxt = bulk_entries - 1;
+
+              // move head pointer, skip the padding after the last entry
+              if(bulk_entries == 1) begin
+                 mem_tx_bulk_head_nxt = ({mem_tx_bulk_head[`MEM_ADDR_BITS-1:6], 6'b0} + 64) & MEM_TX_BULK_MASK;
+              end
+              else begin
+                 mem_tx_bulk_head_nxt = (mem_tx_bulk_head + 8) & MEM_TX_BULK_MASK;
+              end
+
+              // advance state
+              if(mem_tx_bulk_head_nxt[5:0] == 6'b0)
+                read_tx_doorbell_state_nxt = READ_TX_DOORBELL_STATE_BULK_WAIT;
+              else
+                read_tx_doorbell_state_nxt = READ_TX_DOORBELL_STATE_BULK_IDLE;
+           end
+           else begin
+              stat_doorbell_stall_cnt_nxt = stat_doorbell_stall_cnt + 1;
+           end
+        end
+
+        READ_TX_DOORBELL_STATE_BULK_WAIT: begin
+           if(~mem_vld_tx_bulk_wr_stall) begin
+              // done with this line
+              mem_vld_tx_bulk_wr_clear = 1;
+              bulk_lines_used_nxt = bulk_lines_used_nxt - 1;
+              if(bulk_entries != 0)
+                read_tx_doorbell_state_nxt = READ_TX_DOORBELL_STATE_BULK_IDLE;
+              else
+                read_tx_doorbell_state_nxt = READ_TX_DOORBELL_STATE_IDLE;
            end
         end
       endcase
@@ -848,22 +1302,46 @@ module tx_ctrl
       if(rst) begin
          read_tx_doorbell_state <= READ_TX_DOORBELL_STATE_IDLE;
          mem_tx_doorbell_head  <= 0; 
+         mem_tx_bulk_head <= 0;
+         mem_tx_bulk_tail <= 0;
+         bulk_entries <= 0;
+         bulk_rd_lines <= 0;
+         bulk_lines_used <= 0;
+         stat_doorbell_stall_cnt <= 0;
       end
       else begin
          read_tx_doorbell_state <= read_tx_doorbell_state_nxt;
          mem_tx_doorbell_head   <= mem_tx_doorbell_head_nxt;
+         mem_tx_bulk_head <= mem_tx_bulk_head_nxt;
+         mem_tx_bulk_tail <= mem_tx_bulk_tail_nxt;
+         bulk_entries <= bulk_entries_nxt;
+         bulk_rd_lines <= bulk_rd_lines_nxt;
+         bulk_lines_used <= bulk_lines_used_nxt;
+         stat_doorbell_stall_cnt <= stat_doorbell_stall_cnt_nxt;
       end
 
       mem_tx_doorbell_head_reg <= mem_tx_doorbell_head_reg_nxt;
       doorbell_lo_reg <= doorbell_lo_reg_nxt;
+      doorbell_hi_reg <= doorbell_hi_reg_nxt;
+      mem_tx_bulk_head_reg <= mem_tx_bulk_head_reg_nxt;
+      bulk_class_index <= bulk_class_index_nxt;
+      bulk_list <= bulk_list_nxt;
+      bulk_rate <= bulk_rate_nxt;
+      bulk_rd_host_addr <= bulk_rd_host_addr_nxt;
    end
 
    // ----------------------------------
    // -- Doorbell completion queue
    // ----------------------------------
 
+   // an entry is five words: status, then the class state spilled by an
+   // evict doorbell or the counters of a stats snapshot (zero otherwise).
+   // The last word sets the valid bit.
+   logic [2:0]                 doorbell_dne_word, doorbell_dne_word_nxt;
+
    always_comb begin
       doorbell_dne_q_deq_en = 0;
+      doorbell_dne_word_nxt = doorbell_dne_word;
 
       // clear 7 entries ahead, make sure buffer is at least 16 lines deep
       mem_tx_doorbell_dne_clear        = (mem_tx_doorbell_dne_tail + 64*8) & tx_doorbell_dne_mask[`MEM_ADDR_BITS-1:0];
@@ -877,25 +1355,41 @@ module tx_ctrl
       mem_tx_doorbell_dne_wr_addr   = 0;
       mem_tx_doorbell_dne_tail_nxt  = mem_tx_doorbell_dne_tail;
 
-      if(!doorbell_dne_q_empty && !mem_vld_tx_doorbell_dne_wr_stall && tx_doorbell_dne_ready) begin
-         doorbell_dne_q_deq_en = 1;
-
-         // interrupt host
+      // tx completions held back are written first, see dne_held
+      if(!doorbell_dne_q_empty && !dne_held && !mem_vld_tx_doorbell_dne_wr_stall && tx_doorbell_dne_ready) begin
          mem_tx_doorbell_dne_wr_en = 1;
          mem_tx_doorbell_dne_wr_mask = 8'hff;
-         mem_tx_doorbell_dne_wr_data[31:0] = doorbell_dne_q_deq_data;
-         mem_tx_doorbell_dne_wr_addr = mem_tx_doorbell_dne_tail;
-         mem_tx_doorbell_dne_tail_nxt = (mem_tx_doorbell_dne_tail + 64) & tx_doorbell_dne_mask[`MEM_ADDR_BITS-1:0];
-         mem_vld_tx_doorbell_dne_wr_clear = 1;
+         mem_tx_doorbell_dne_wr_addr = mem_tx_doorbell_dne_tail + {{(`MEM_ADDR_BITS-6){1'b0}}, doorbell_dne_word, 3'b0};
+         case(doorbell_dne_word)
+           3'd0: mem_tx_doorbell_dne_wr_data[31:0] = doorbell_dne_q_deq_data[31:0];
+           3'd1: mem_tx_doorbell_dne_wr_data = doorbell_dne_q_deq_data[95:32];
+           3'd2: mem_tx_doorbell_dne_wr_data = doorbell_dne_q_deq_data[159:96];
+           3'd3: mem_tx_doorbell_dne_wr_data = doorbell_dne_q_deq_data[223:160];
+           default: mem_tx_doorbell_dne_wr_data = doorbell_dne_q_deq_data[287:224];
+         endcase
+
+         if(doorbell_dne_word == 3'd4) begin
+            doorbell_dne_q_deq_en = 1;
+            doorbell_dne_word_nxt = 0;
+
+            // interrupt host
+            mem_tx_doorbell_dne_tail_nxt = (mem_tx_doorbell_dne_tail + 64) & tx_doorbell_dne_mask[`MEM_ADDR_BITS-1:0];
+            mem_vld_tx_doorbell_dne_wr_clear = 1;
+         end
+         else begin
+            doorbell_dne_word_nxt = doorbell_dne_word + 1;
+         end
       end
    end
 
    always_ff @(posedge clk) begin
       if(rst) begin
          mem_tx_doorbell_dne_tail <= 0;
+         doorbell_dne_word <= 0;
       end
       else begin
          mem_tx_doorbell_dne_tail <= mem_tx_doorbell_dne_tail_nxt;
+         doorbell_dne_word <= doorbell_dne_word_nxt;
       end
    end
 
@@ -931,6 +1425,7 @@ module tx_ctrl
    localparam PKT_SEND_STATE_IDLE       = 0;
    localparam PKT_SEND_STATE_PKT_START  = 1;
    localparam PKT_SEND_STATE_LINE_DATA  = 2;
+   localparam PKT_SEND_STATE_PKT_GATE   = 3;
 
    logic [1:0]                 pkt_send_state, pkt_send_state_nxt;
    
@@ -951,7 +1446,31 @@ module tx_ctrl
 
    logic [15:0]                mem_tx_pkt_port, mem_tx_pkt_port_nxt;
 
-   assign mem_tx_pkt_rd_addr = mem_tx_pkt_head;
+   // inline packets are read from the inline memory and leave the tx_pkt
+   // buffer and its valid bits alone
+   logic                       mem_tx_pkt_inline, mem_tx_pkt_inline_nxt;
+   logic [`MEM_ADDR_BITS-1:0]  pkt_send_mask;
+   logic [63:0]                pkt_rd_data;
+   logic                       pkt_rd_vld;
+
+   // a packet starts once every line from its head to its gate line is
+   // valid, the gate being tx_cut_lines lines in or the last line. With
+   // tx_cut_lines 0 the gate is the head, the packet starts on its first
+   // line. Completions come back out of order, lines behind the gate still
+   // stall LINE_DATA if they are late. A valid word covers 32 lines, PKT_GATE
+   // checks the word of the head when the gate lies in the next one
+   logic [`MEM_ADDR_BITS-1:0]  pkt_len;
+   logic [`MEM_ADDR_BITS-1:0]  pkt_gate_addr, pkt_gate_addr_l;
+   logic                       pkt_gate_rd;
+   logic                       pkt_gate_split;
+   logic [31:0]                pkt_gate_need;
+
+   assign mem_tx_pkt_rd_addr = pkt_gate_rd ? pkt_gate_addr : mem_tx_pkt_head;
+   assign mem_tx_inline_rd_addr = mem_tx_pkt_head;
+
+   assign pkt_send_mask = mem_tx_pkt_inline ? MEM_TX_INLINE_MASK : tx_pkt_mask[`MEM_ADDR_BITS-1:0];
+   assign pkt_rd_data = mem_tx_pkt_inline ? mem_tx_inline_rd_data : mem_tx_pkt_rd_data;
+   assign pkt_rd_vld = mem_tx_pkt_inline || mem_vld_tx_pkt_rd_bit;
    
    always_comb begin
       pkt_send_state_nxt = pkt_send_state;
@@ -962,6 +1481,7 @@ module tx_ctrl
       mem_tx_pkt_head_nxt = mem_tx_pkt_head_l;
       mem_tx_pkt_end_nxt  = mem_tx_pkt_end;
       mem_tx_pkt_rd_en    = 1;
+      mem_tx_inline_rd_en = 1;
       mem_tx_pkt_mark_end_nxt = mem_tx_pkt_mark_end;
       
       mem_vld_tx_pkt_wr_addr_nxt  = mem_vld_tx_pkt_wr_addr;
@@ -975,6 +1495,7 @@ module tx_ctrl
       M_AXIS_TUSER_L_nxt  = M_AXIS_TUSER_L;
 
       pkt_cm_counter_wr_en = 0;
+      inline_counter_rd_en = 0;
       
       if(M_AXIS_TREADY_L)
         M_AXIS_TVALID_L_nxt = 0;
@@ -983,25 +1504,69 @@ module tx_ctrl
       
       tx_pend_q_deq_en = 0;
 
+      pkt_len = 0;
+      pkt_gate_addr = pkt_gate_addr_l;
+      pkt_gate_rd = 0;
+      pkt_gate_split = 0;
+      pkt_gate_need = 0;
+
       mem_tx_pkt_port_nxt = mem_tx_pkt_port;
+      mem_tx_pkt_inline_nxt = mem_tx_pkt_inline;
       
       case(pkt_send_state)
         PKT_SEND_STATE_IDLE: begin
            if(~tx_pend_q_empty) begin
+              mem_tx_pkt_inline_nxt = tx_pend_q_deq_data[2*`MEM_ADDR_BITS+16];
               mem_tx_pkt_port_nxt = tx_pend_q_deq_data[2*`MEM_ADDR_BITS+:16];
-              mem_tx_pkt_head_nxt = tx_pend_q_deq_data[`MEM_ADDR_BITS+:`MEM_ADDR_BITS] & tx_pkt_mask[`MEM_ADDR_BITS-1:0];
-              mem_tx_pkt_end_nxt  = tx_pend_q_deq_data[0+:`MEM_ADDR_BITS] & tx_pkt_mask[`MEM_ADDR_BITS-1:0];;
+              if(mem_tx_pkt_inline_nxt) begin
+                 mem_tx_pkt_head_nxt = tx_pend_q_deq_data[`MEM_ADDR_BITS+:`MEM_ADDR_BITS] & MEM_TX_INLINE_MASK;
+                 mem_tx_pkt_end_nxt  = tx_pend_q_deq_data[0+:`MEM_ADDR_BITS] & MEM_TX_INLINE_MASK;
+              end
+              else begin
+                 mem_tx_pkt_head_nxt = tx_pend_q_deq_data[`MEM_ADDR_BITS+:`MEM_ADDR_BITS] & tx_pkt_mask[`MEM_ADDR_BITS-1:0];
+                 mem_tx_pkt_end_nxt  = tx_pend_q_deq_data[0+:`MEM_ADDR_BITS] & tx_pkt_mask[`MEM_ADDR_BITS-1:0];;
+                 // PKT_START sees the valid word of the gate line
+                 pkt_len = (mem_tx_pkt_end_nxt - mem_tx_pkt_head_nxt) & tx_pkt_mask[`MEM_ADDR_BITS-1:0];
+                 if(tx_cut_lines == 0)
+                   pkt_gate_addr = mem_tx_pkt_head_nxt;
+                 else if(pkt_len > {tx_cut_lines, 6'b0})
+                   pkt_gate_addr = (mem_tx_pkt_head_nxt + {tx_cut_lines, 6'b0} - 1) & tx_pkt_mask[`MEM_ADDR_BITS-1:0];
+                 else
+                   pkt_gate_addr = (mem_tx_pkt_end_nxt - 1) & tx_pkt_mask[`MEM_ADDR_BITS-1:0];
+                 pkt_gate_rd = 1;
+              end
               mem_tx_pkt_head     = mem_tx_pkt_head_nxt; // save a cycle by doing this
               pkt_send_state_nxt  = PKT_SEND_STATE_PKT_START;
            end
         end
 
-        PKT_SEND_STATE_PKT_START: begin
-           if(mem_vld_tx_pkt_rd_bit) begin
+        PKT_SEND_STATE_PKT_START, PKT_SEND_STATE_PKT_GATE: begin
+           // lines of the gate word up to the gate, from the head if it is
+           // in the same word. Then those of the head word from the head on
+           if(pkt_send_state == PKT_SEND_STATE_PKT_START) begin
+              pkt_gate_split = (pkt_gate_addr_l[`MEM_ADDR_BITS-1:11] != mem_tx_pkt_head[`MEM_ADDR_BITS-1:11]);
+              pkt_gate_need = 32'hffffffff >> (5'd31 - pkt_gate_addr_l[10:6]);
+              if(!pkt_gate_split)
+                pkt_gate_need = pkt_gate_need & (32'hffffffff << mem_tx_pkt_head[10:6]);
+           end
+           else begin
+              pkt_gate_need = 32'hffffffff << mem_tx_pkt_head[10:6];
+           end
+
+           if(mem_tx_pkt_inline) begin
+              pkt_gate_split = 0;
+              pkt_gate_need = 0;
+           end
+
+           if(((mem_vld_tx_pkt_rd_bits & pkt_gate_need) == pkt_gate_need) && pkt_gate_split) begin
+              // the head line is read for the word of the head
+              pkt_send_state_nxt = PKT_SEND_STATE_PKT_GATE;
+           end
+           else if((mem_vld_tx_pkt_rd_bits & pkt_gate_need) == pkt_gate_need) begin
               // dequeue pending transmit
               tx_pend_q_deq_en = 1;
               // move head pointer
-              mem_tx_pkt_head_nxt = (mem_tx_pkt_head + 8) & tx_pkt_mask[`MEM_ADDR_BITS-1:0];
+              mem_tx_pkt_head_nxt = (mem_tx_pkt_head + 8) & pkt_send_mask;
               // advance state
               pkt_send_state_nxt = PKT_SEND_STATE_LINE_DATA;
               // prepare vld_tx_pkt clear mask and address
@@ -1009,7 +1574,7 @@ module tx_ctrl
               mem_vld_tx_pkt_wr_mask_nxt = 32'hffffffff << mem_tx_pkt_head[10:6];
               // prepare M_AXIS_TUSER
               M_AXIS_TUSER_L_nxt[31:16] = mem_tx_pkt_port;
-              M_AXIS_TUSER_L_nxt[15:0]  = (mem_tx_pkt_end[15:0] - mem_tx_pkt_head[15:0]) & tx_pkt_mask[15:0];
+              M_AXIS_TUSER_L_nxt[15:0]  = (mem_tx_pkt_end[15:0] - mem_tx_pkt_head[15:0]) & pkt_send_mask[15:0];
            end
            else begin
               pkt_send_state_nxt = PKT_SEND_STATE_IDLE;
@@ -1017,7 +1582,7 @@ module tx_ctrl
         end
 
         PKT_SEND_STATE_LINE_DATA: begin
-           if(!mem_vld_tx_pkt_rd_bit || !M_AXIS_TREADY_L || mem_vld_tx_pkt_wr_stall || pkt_cm_counter_full) begin
+           if(!pkt_rd_vld || !M_AXIS_TREADY_L || mem_vld_tx_pkt_wr_stall || pkt_cm_counter_full) begin
               mem_tx_pkt_head = mem_tx_pkt_head_reg;
               mem_vld_tx_pkt_wr_clear = 0;
               mem_vld_tx_pkt_wr_clear_nxt = mem_vld_tx_pkt_wr_clear_l;
@@ -1028,44 +1593,44 @@ module tx_ctrl
                  case(mem_tx_pkt_head[2:0])
                    3'h0: begin
                       M_AXIS_TSTRB_L_nxt = 8'hff;
-                      M_AXIS_TDATA_L_nxt = mem_tx_pkt_rd_data;
+                      M_AXIS_TDATA_L_nxt = pkt_rd_data;
                    end
                    3'h1: begin
                       M_AXIS_TSTRB_L_nxt = 8'h7f;
-                      M_AXIS_TDATA_L_nxt = {8'b0, mem_tx_pkt_rd_data[63:8]};
+                      M_AXIS_TDATA_L_nxt = {8'b0, pkt_rd_data[63:8]};
                    end
                    3'h2: begin
                       M_AXIS_TSTRB_L_nxt = 8'h3f;
-                      M_AXIS_TDATA_L_nxt = {16'b0, mem_tx_pkt_rd_data[63:16]};
+                      M_AXIS_TDATA_L_nxt = {16'b0, pkt_rd_data[63:16]};
                    end
                    3'h3: begin 
                       M_AXIS_TSTRB_L_nxt = 8'h1f;
-                      M_AXIS_TDATA_L_nxt = {24'b0, mem_tx_pkt_rd_data[63:24]};
+                      M_AXIS_TDATA_L_nxt = {24'b0, pkt_rd_data[63:24]};
                    end
                    3'h4: begin 
                       M_AXIS_TSTRB_L_nxt = 8'h0f;
-                      M_AXIS_TDATA_L_nxt = {32'b0, mem_tx_pkt_rd_data[63:32]};
+                      M_AXIS_TDATA_L_nxt = {32'b0, pkt_rd_data[63:32]};
                    end
                    3'h5: begin 
                       M_AXIS_TSTRB_L_nxt = 8'h07;
-                      M_AXIS_TDATA_L_nxt = {40'b0, mem_tx_pkt_rd_data[63:40]};
+                      M_AXIS_TDATA_L_nxt = {40'b0, pkt_rd_data[63:40]};
                    end
                    3'h6: begin 
                       M_AXIS_TSTRB_L_nxt = 8'h03;
-                      M_AXIS_TDATA_L_nxt = {48'b0, mem_tx_pkt_rd_data[63:48]};
+                      M_AXIS_TDATA_L_nxt = {48'b0, pkt_rd_data[63:48]};
                    end
                    3'h7: begin 
                       M_AXIS_TSTRB_L_nxt = 8'h01;
-                      M_AXIS_TDATA_L_nxt = {56'b0, mem_tx_pkt_rd_data[63:56]};
+                      M_AXIS_TDATA_L_nxt = {56'b0, pkt_rd_data[63:56]};
                    end
                  endcase
                  M_AXIS_TLAST_L_nxt = 0;
 
                  // read next line
-                 if(((mem_tx_pkt_end - mem_tx_pkt_head) & tx_pkt_mask[`MEM_ADDR_BITS-1:0]) > 8) begin
-                    mem_tx_pkt_head_nxt = ({mem_tx_pkt_head[`MEM_ADDR_BITS-1:3],3'b0} + 8) & tx_pkt_mask[`MEM_ADDR_BITS-1:0];
+                 if(((mem_tx_pkt_end - mem_tx_pkt_head) & pkt_send_mask) > 8) begin
+                    mem_tx_pkt_head_nxt = ({mem_tx_pkt_head[`MEM_ADDR_BITS-1:3],3'b0} + 8) & pkt_send_mask;
                     // done with this batch of lines, clear valid bits
-                    if((mem_tx_pkt_head[10:6] == 5'b11111) && (mem_tx_pkt_head_nxt[10:6] == 5'b00000)) begin
+                    if(!mem_tx_pkt_inline && (mem_tx_pkt_head[10:6] == 5'b11111) && (mem_tx_pkt_head_nxt[10:6] == 5'b00000)) begin
                        mem_vld_tx_pkt_wr_clear_nxt = 1;
                     end
                  end
@@ -1084,45 +1649,47 @@ module tx_ctrl
                  case(mem_tx_pkt_end[2:0])
                    3'd0: begin
                       M_AXIS_TSTRB_L_nxt = 8'hff;
-                      M_AXIS_TDATA_L_nxt = mem_tx_pkt_rd_data;
+                      M_AXIS_TDATA_L_nxt = pkt_rd_data;
                    end
                    3'd1: begin
                       M_AXIS_TSTRB_L_nxt = 8'h01;
-                      M_AXIS_TDATA_L_nxt = {56'b0, mem_tx_pkt_rd_data[7:0]};
+                      M_AXIS_TDATA_L_nxt = {56'b0, pkt_rd_data[7:0]};
                    end
                    3'd2: begin 
                       M_AXIS_TSTRB_L_nxt = 8'h03;
-                      M_AXIS_TDATA_L_nxt = {48'b0, mem_tx_pkt_rd_data[15:0]};
+                      M_AXIS_TDATA_L_nxt = {48'b0, pkt_rd_data[15:0]};
                    end
                    3'd3: begin
                       M_AXIS_TSTRB_L_nxt = 8'h07;
-                      M_AXIS_TDATA_L_nxt = {40'b0, mem_tx_pkt_rd_data[23:0]};
+                      M_AXIS_TDATA_L_nxt = {40'b0, pkt_rd_data[23:0]};
                    end
                    3'd4: begin
                       M_AXIS_TSTRB_L_nxt = 8'h0f;
-                      M_AXIS_TDATA_L_nxt = {32'b0, mem_tx_pkt_rd_data[31:0]};
+                      M_AXIS_TDATA_L_nxt = {32'b0, pkt_rd_data[31:0]};
                    end
                    3'd5: begin
                       M_AXIS_TSTRB_L_nxt = 8'h1f;
-                      M_AXIS_TDATA_L_nxt = {24'b0, mem_tx_pkt_rd_data[39:0]};
+                      M_AXIS_TDATA_L_nxt = {24'b0, pkt_rd_data[39:0]};
                    end
                    3'd6: begin
                       M_AXIS_TSTRB_L_nxt = 8'h3f;
-                      M_AXIS_TDATA_L_nxt = {16'b0, mem_tx_pkt_rd_data[47:0]};
+                      M_AXIS_TDATA_L_nxt = {16'b0, pkt_rd_data[47:0]};
                    end
                    3'd7: begin
                       M_AXIS_TSTRB_L_nxt = 8'h7f;
-                      M_AXIS_TDATA_L_nxt = {8'b0, mem_tx_pkt_rd_data[55:0]};
+                      M_AXIS_TDATA_L_nxt = {8'b0, pkt_rd_data[55:0]};
                    end
                    default: begin
                       M_AXIS_TSTRB_L_nxt = 8'hff;
-                      M_AXIS_TDATA_L_nxt = mem_tx_pkt_rd_data;
+                      M_AXIS_TDATA_L_nxt = pkt_rd_data;
                    end
                  endcase
                  M_AXIS_TLAST_L_nxt = 1;
                  
                  // clear the tx_pkt buffer
-                 if(mem_tx_pkt_end[5:0] == 6'b0) begin
+                 if(mem_tx_pkt_inline) begin
+                 end
+                 else if(mem_tx_pkt_end[5:0] == 6'b0) begin
                     mem_tx_pkt_head_bk_nxt = mem_tx_pkt_end & tx_pkt_mask[`MEM_ADDR_BITS-1:0];
                     mem_vld_tx_pkt_wr_mask_nxt = mem_vld_tx_pkt_wr_mask & (32'hffffffff >> (5'd32 - mem_tx_pkt_end[10:6]));
                  end
@@ -1130,7 +1697,7 @@ module tx_ctrl
                     mem_tx_pkt_head_bk_nxt = ({mem_tx_pkt_end[19:6], 6'b0} + 20'd64) & tx_pkt_mask[`MEM_ADDR_BITS-1:0];
                     mem_vld_tx_pkt_wr_mask_nxt = mem_vld_tx_pkt_wr_mask & (32'hffffffff >> (5'd31 - mem_tx_pkt_end[10:6]));
                  end
-                 mem_vld_tx_pkt_wr_clear_nxt = 1;
+                 mem_vld_tx_pkt_wr_clear_nxt = !mem_tx_pkt_inline;
 
                  // clear the end mark
                  mem_tx_pkt_mark_end_nxt = 0;
@@ -1139,7 +1706,8 @@ module tx_ctrl
                  pkt_send_state_nxt = PKT_SEND_STATE_IDLE;
 
                  // count pkt completion
-                 pkt_cm_counter_wr_en = 1;
+                 pkt_cm_counter_wr_en = !mem_tx_pkt_inline;
+                 inline_counter_rd_en = mem_tx_pkt_inline;
                  
               end             
            end
@@ -1161,6 +1729,10 @@ module tx_ctrl
          M_AXIS_TVALID_L <= 0;
 
          mem_tx_pkt_head_bk <= 0;
+
+         mem_tx_pkt_inline <= 0;
+
+         pkt_gate_addr_l <= 0;
       end
       else begin
          pkt_send_state <= pkt_send_state_nxt;       
@@ -1175,6 +1747,10 @@ module tx_ctrl
          M_AXIS_TVALID_L <= M_AXIS_TVALID_L_nxt;
 
          mem_tx_pkt_head_bk <= mem_tx_pkt_head_bk_nxt;
+
+         mem_tx_pkt_inline <= mem_tx_pkt_inline_nxt;
+
+         pkt_gate_addr_l <= pkt_gate_addr;
       end
 
       mem_vld_tx_pkt_wr_addr <= mem_vld_tx_pkt_wr_addr_nxt;
@@ -0,0 +1,15 @@
+
+cd $(dirname $0)
+rm -rf unittest_build
+mkdir  unittest_build
+cd     unittest_build
+fuse -incremental -i .. -prj ../tx_ctrl_rd_tb.prj -o tx_ctrl_rd_tb.exe testbench
+./tx_ctrl_rd_tb.exe -tclbatch ../tx_ctrl_rd_tb.tcl
+# other read depths and tx pending queue depths only print their throughput
+for pair in 24:32 48:32 64:32 64:64 128:128; do
+    depth=${pair%:*}
+    pend=${pair#*:}
+    fuse -i .. -d TX_RD_IN_FLIGHT=$depth -d TX_PENDING_DEPTH=$pend -d TX_RD_SWEEP \
+         -prj ../tx_ctrl_rd_tb.prj -o tx_ctrl_rd_tb_${depth}_$pend.exe testbench
+    ./tx_ctrl_rd_tb_${depth}_$pend.exe -tclbatch ../tx_ctrl_rd_tb.tcl
+done
@@ -0,0 +1,527 @@
+/*******************************************************************************
+ *
+ *  NetFPGA-10G http://www.netfpga.org
+ *
+ *  File:
+ *        tx_ctrl_rd_tb.v
+ *
+ *  Library:
+ *        hw/contrib/pcores/dma_v1_00_a
+ *
+ *  Module:
+ *        testbench
+ *
+ *  Description:
+ *        Throughput of tx_ctrl against TX_RD_IN_FLIGHT and TX_PENDING_DEPTH,
+ *        which caps the packet reads among them. One class sends 64
+ *        byte packets from an endless descriptor ring. tx_ctrl reads
+ *        descriptors and packets into the tx_dsc and tx_pkt memories of
+ *        iface, the host answers every read after LATENCY ns plus up to
+ *        JITTER ns on the 64 bit pcie write bus, so completions come back
+ *        out of order. The MAC takes a word per cycle and adds the FCS,
+ *        preamble and gap. nicpic is replaced by handing the class back
+ *        FEEDBACK_DELAY cycles after its feedback. Prints the share of line
+ *        rate and checks it against LINE_RATE_MIN, with TX_RD_SWEEP defined
+ *        only prints it. tx_ctrl_rd_tb.sh builds it for several depths.
+ *        Not run yet, there are no numbers behind the default depths.
+ *
+ *  Copyright notice:
+ *        Copyright (C) 2010, 2011 The Board of Trustees of The Leland Stanford
+ *                                 Junior University
+ *
+ *  Licence:
+ *        This file is part of the NetFPGA 10G development base package.
+ *
+ *        This file is free code: you can redistribute it and/or modify it under
+ *        the terms of the GNU Lesser General Public License version 2.1 as
+ *        published by the Free Software Foundation.
+ *
+ *        This package is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *        Lesser General Public License for more details.
+ *
+ *        You should have received a copy of the GNU Lesser General Public
+ *        License along with the NetFPGA source package.  If not, see
+ *        http://www.gnu.org/licenses/.
+ *
+ */
+
+`timescale 1 ns / 1ps
+`include "dma_defs.vh"
+
+module testbench();
+
+    localparam WARMUP_CYCLES = 16000;   // 100 us before measuring
+    localparam RUN_CYCLES = 200000;     // 1.25 ms measured
+    localparam LATENCY = 1000;          // host read latency in ns
+    localparam JITTER = 400;            // random part on top, in ns
+    localparam [15:0] PKT_LEN = 60;     // 64 bytes on the wire with the FCS
+    localparam MAC_GAP = 3;             // words of FCS, preamble and gap
+    localparam RING = 4096;             // host descriptor ring
+    localparam REQS = 256;              // reads the host serves at once, extended tags
+    localparam FEEDBACK_DELAY = 16;     // cycles until nicpic sends the class again
+    localparam LINE_RATE_MIN = 0.85;
+
+    localparam [63:0] DSC_BASE = 64'h10000000;
+    localparam [63:0] PKT_BASE = 64'h20000000;
+    localparam [63:0] RING_MASK = RING*64-1;
+
+    reg clk, pcie_clk, reset;
+    reg [31:0] cycle;
+
+    always @(posedge clk) begin
+       if(reset)
+          cycle <= 0;
+       else
+          cycle <= cycle + 1;
+    end
+
+    // ---------------------------------------------
+    // tx_ctrl
+    // ---------------------------------------------
+    wire                        feedback_task_q_enq_en;
+    wire [351:0]                feedback_task_q_enq_data;
+
+    wire                        tx_task_q_deq_en;
+    reg [513:0]                 tx_task_q_data;
+    reg                         tx_task_q_empty;
+
+    wire [`MEM_ADDR_BITS-1:0]   mem_tx_dsc_rd_addr;
+    wire [63:0]                 mem_tx_dsc_rd_data;
+    wire                        mem_tx_dsc_rd_en;
+    wire [`MEM_ADDR_BITS-1:0]   mem_tx_pkt_rd_addr;
+    wire [63:0]                 mem_tx_pkt_rd_data;
+    wire                        mem_tx_pkt_rd_en;
+
+    wire [`MEM_ADDR_BITS-1:0]   mem_tx_dne_wr_addr;
+    wire                        mem_tx_dne_wr_en;
+    reg [63:0]                  mem_tx_dne_head;
+
+    wire [`MEM_ADDR_BITS-12:0]  mem_vld_tx_dsc_wr_addr;
+    wire [31:0]                 mem_vld_tx_dsc_wr_mask;
+    wire                        mem_vld_tx_dsc_wr_clear;
+    wire                        mem_vld_tx_dsc_wr_stall;
+    wire                        mem_vld_tx_dsc_rd_bit;
+    wire [`MEM_ADDR_BITS-12:0]  mem_vld_tx_pkt_wr_addr;
+    wire [31:0]                 mem_vld_tx_pkt_wr_mask;
+    wire                        mem_vld_tx_pkt_wr_clear;
+    wire                        mem_vld_tx_pkt_wr_stall;
+    wire                        mem_vld_tx_pkt_rd_bit;
+    wire [31:0]                 mem_vld_tx_pkt_rd_bits;
+
+    wire                        rd_q_enq_en;
+    wire [`RD_Q_WIDTH-1:0]      rd_q_enq_data;
+    wire                        rd_q_full;
+
+    wire [63:0]                 M_AXIS_TDATA;
+    wire [7:0]                  M_AXIS_TSTRB;
+    wire                        M_AXIS_TVALID;
+    wire                        M_AXIS_TREADY;
+    wire                        M_AXIS_TLAST;
+
+    localparam [63:0] TX_DSC_MASK = `MEM_N_TX_DSC*64-1;
+    localparam [63:0] TX_PKT_MASK = `MEM_N_TX_PKT*64-1;
+    localparam [63:0] TX_DNE_MASK = `MEM_N_TX_DNE*64-1;
+    localparam [63:0] TX_DOORBELL_MASK = `MEM_N_TX_DOORBELL*64-1;
+    localparam [63:0] TX_DOORBELL_DNE_MASK = `MEM_N_TX_DOORBELL_DNE*64-1;
+    localparam [63:0] RX_DSC_MASK = `MEM_N_RX_DSC*64-1;
+
+    tx_ctrl u_tx_ctrl(
+       .mem_tx_dne_head(mem_tx_dne_head),
+       .mem_tx_doorbell_dne_head(64'b0),
+       .dma_start(),
+       .dma_end(),
+       .mem_tx_doorbell_head(),
+       .feedback_task_q_enq_en(feedback_task_q_enq_en),
+       .feedback_task_q_enq_data(feedback_task_q_enq_data),
+       .feedback_task_q_full(1'b0),
+       .doorbell_dne_q_deq_en(),
+       .doorbell_dne_q_deq_data(288'b0),
+       .doorbell_dne_q_empty(1'b1),
+       .tx_task_q_deq_en(tx_task_q_deq_en),
+       .tx_task_q_data(tx_task_q_data),
+       .tx_task_q_empty(tx_task_q_empty),
+       .doorbell_task_q_enq_en(),
+       .doorbell_task_q_data(),
+       .doorbell_task_q_full(1'b0),
+       .mem_tx_dsc_rd_addr(mem_tx_dsc_rd_addr),
+       .mem_tx_dsc_rd_data(mem_tx_dsc_rd_data),
+       .mem_tx_dsc_rd_en(mem_tx_dsc_rd_en),
+       .mem_tx_doorbell_rd_addr(),
+       .mem_tx_doorbell_rd_data(64'b0),
+       .mem_tx_doorbell_rd_en(),
+       .mem_tx_pkt_rd_addr(mem_tx_pkt_rd_addr),
+       .mem_tx_pkt_rd_data(mem_tx_pkt_rd_data),
+       .mem_tx_pkt_rd_en(mem_tx_pkt_rd_en),
+       .mem_tx_bulk_rd_addr(),
+       .mem_tx_bulk_rd_data(64'b0),
+       .mem_tx_bulk_rd_en(),
+       .mem_tx_inline_rd_addr(),
+       .mem_tx_inline_rd_data(64'b0),
+       .mem_tx_inline_rd_en(),
+       .mem_tx_doorbell_dne_wr_addr(),
+       .mem_tx_doorbell_dne_wr_data(),
+       .mem_tx_doorbell_dne_wr_mask(),
+       .mem_tx_doorbell_dne_wr_en(),
+       .mem_tx_dne_wr_addr(mem_tx_dne_wr_addr),
+       .mem_tx_dne_wr_data(),
+       .mem_tx_dne_wr_mask(),
+       .mem_tx_dne_wr_en(mem_tx_dne_wr_en),
+       .mem_vld_tx_doorbell_wr_addr(),
+       .mem_vld_tx_doorbell_wr_mask(),
+       .mem_vld_tx_doorbell_wr_clear(),
+       .mem_vld_tx_doorbell_wr_stall(1'b0),
+       .mem_vld_tx_doorbell_rd_bit(1'b0),
+       .mem_vld_tx_doorbell_dne_wr_addr(),
+       .mem_vld_tx_doorbell_dne_wr_mask(),
+       .mem_vld_tx_doorbell_dne_wr_clear(),
+       .mem_vld_tx_doorbell_dne_wr_stall(1'b0),
+       .mem_vld_tx_dsc_wr_addr(mem_vld_tx_dsc_wr_addr),
+       .mem_vld_tx_dsc_wr_mask(mem_vld_tx_dsc_wr_mask),
+       .mem_vld_tx_dsc_wr_clear(mem_vld_tx_dsc_wr_clear),
+       .mem_vld_tx_dsc_wr_stall(mem_vld_tx_dsc_wr_stall),
+       .mem_vld_tx_dsc_rd_bit(mem_vld_tx_dsc_rd_bit),
+       .mem_vld_tx_pkt_wr_addr(mem_vld_tx_pkt_wr_addr),
+       .mem_vld_tx_pkt_wr_mask(mem_vld_tx_pkt_wr_mask),
+       .mem_vld_tx_pkt_wr_clear(mem_vld_tx_pkt_wr_clear),
+       .mem_vld_tx_pkt_wr_stall(mem_vld_tx_pkt_wr_stall),
+       .mem_vld_tx_pkt_rd_bit(mem_vld_tx_pkt_rd_bit),
+       .mem_vld_tx_pkt_rd_bits(mem_vld_tx_pkt_rd_bits),
+       .mem_vld_tx_bulk_wr_addr(),
+       .mem_vld_tx_bulk_wr_mask(),
+       .mem_vld_tx_bulk_wr_clear(),
+       .mem_vld_tx_bulk_wr_stall(1'b0),
+       .mem_vld_tx_bulk_rd_bit(1'b0),
+       .mem_vld_tx_dne_wr_addr(),
+       .mem_vld_tx_dne_wr_mask(),
+       .mem_vld_tx_dne_wr_clear(),
+       .mem_vld_tx_dne_wr_stall(1'b0),
+       .tx_doorbell_mask(TX_DOORBELL_MASK),
+       .tx_doorbell_dne_mask(TX_DOORBELL_DNE_MASK),
+       .tx_dsc_mask(TX_DSC_MASK),
+       .tx_pkt_mask(TX_PKT_MASK),
+       .tx_dne_mask(TX_DNE_MASK),
+       .rx_dsc_mask(RX_DSC_MASK),
+       .tx_cut_lines(16'd0),
+       .rd_q_enq_en(rd_q_enq_en),
+       .rd_q_enq_data(rd_q_enq_data),
+       .rd_q_full(rd_q_full),
+       .M_AXIS_TDATA(M_AXIS_TDATA),
+       .M_AXIS_TSTRB(M_AXIS_TSTRB),
+       .M_AXIS_TVALID(M_AXIS_TVALID),
+       .M_AXIS_TREADY(M_AXIS_TREADY),
+       .M_AXIS_TLAST(M_AXIS_TLAST),
+       .M_AXIS_TUSER(),
+       .stat_mac_tx_ts(),
+       .stat_mac_tx_word_cnt(),
+       .stat_mac_tx_pkt_cnt(),
+       .stat_tx_time(),
+       .stat_doorbell_stall_cnt(),
+       .clk(clk),
+       .rst(reset));
+
+    // ---------------------------------------------
+    // tx_dsc and tx_pkt memories, as in iface
+    // ---------------------------------------------
+    reg [3:0]                   wr_mem_select;
+    reg [`MEM_ADDR_BITS-1:0]    wr_addr;
+    reg [63:0]                  wr_data;
+    reg                         wr_en;
+
+    mem #(.DEPTH(`MEM_N_TX_DSC), .WIDTH(24), .VALID_MODE(1), .HAS_WR_MASK(1))
+    u_mem_tx_dsc (.wr_mem_valid(wr_mem_select == `ID_MEM_TX_DSC),
+                  .rd_mem_valid(1'b1),
+                  .wr_addr_hi(wr_addr),
+                  .wr_data_hi(wr_data[63:32]),
+                  .wr_mask_hi(4'hf),
+                  .wr_en_hi(wr_en),
+                  .wr_addr_lo(wr_addr),
+                  .wr_data_lo(wr_data[31:0]),
+                  .wr_mask_lo(4'hf),
+                  .wr_en_lo(wr_en),
+                  .rd_addr_hi(mem_tx_dsc_rd_addr),
+                  .rd_data_hi(mem_tx_dsc_rd_data[63:32]),
+                  .rd_en_hi(mem_tx_dsc_rd_en),
+                  .rd_addr_lo(mem_tx_dsc_rd_addr),
+                  .rd_data_lo(mem_tx_dsc_rd_data[31:0]),
+                  .rd_en_lo(mem_tx_dsc_rd_en),
+                  .rd_vld_lo(mem_vld_tx_dsc_rd_bit),
+                  .valid_wr_addr(mem_vld_tx_dsc_wr_addr),
+                  .valid_wr_mask(mem_vld_tx_dsc_wr_mask),
+                  .valid_wr_clear(mem_vld_tx_dsc_wr_clear),
+                  .valid_wr_stall(mem_vld_tx_dsc_wr_stall),
+                  .valid_rd_addr({(`MEM_ADDR_BITS-11){1'b0}}),
+                  .valid_rd_bits(),
+                  .valid_rd_addr_x({(`MEM_ADDR_BITS-11){1'b0}}),
+                  .valid_rd_bits_x(),
+                  .valid_rd_clk(1'b0),
+                  .valid_wr_clk(clk),
+                  .wr_clk(pcie_clk),
+                  .rd_clk(clk),
+                  .rst(reset));
+
+    mem #(.DEPTH(`MEM_N_TX_PKT), .WIDTH(64), .VALID_MODE(1), .HAS_WR_MASK(1))
+    u_mem_tx_pkt (.wr_mem_valid(wr_mem_select == `ID_MEM_TX_PKT),
+                  .rd_mem_valid(1'b1),
+                  .wr_addr_hi(wr_addr),
+                  .wr_data_hi(wr_data[63:32]),
+                  .wr_mask_hi(4'hf),
+                  .wr_en_hi(wr_en),
+                  .wr_addr_lo(wr_addr),
+                  .wr_data_lo(wr_data[31:0]),
+                  .wr_mask_lo(4'hf),
+                  .wr_en_lo(wr_en),
+                  .rd_addr_hi(mem_tx_pkt_rd_addr),
+                  .rd_data_hi(mem_tx_pkt_rd_data[63:32]),
+                  .rd_en_hi(mem_tx_pkt_rd_en),
+                  .rd_addr_lo(mem_tx_pkt_rd_addr),
+                  .rd_data_lo(mem_tx_pkt_rd_data[31:0]),
+                  .rd_en_lo(mem_tx_pkt_rd_en),
+                  .rd_vld_lo(mem_vld_tx_pkt_rd_bit),
+                  .valid_wr_addr(mem_vld_tx_pkt_wr_addr),
+                  .valid_wr_mask(mem_vld_tx_pkt_wr_mask),
+                  .valid_wr_clear(mem_vld_tx_pkt_wr_clear),
+                  .valid_wr_stall(mem_vld_tx_pkt_wr_stall),
+                  .valid_rd_addr({(`MEM_ADDR_BITS-11){1'b0}}),
+                  .valid_rd_bits(mem_vld_tx_pkt_rd_bits),
+                  .valid_rd_addr_x({(`MEM_ADDR_BITS-11){1'b0}}),
+                  .valid_rd_bits_x(),
+                  .valid_rd_clk(1'b0),
+                  .valid_wr_clk(clk),
+                  .wr_clk(pcie_clk),
+                  .rd_clk(clk),
+                  .rst(reset));
+
+    // ---------------------------------------------
+    // host: reads are served in any order, a 64 bit word per pcie cycle
+    // ---------------------------------------------
+    // a slot is busy while its issue and completion toggles differ
+    reg [REQS-1:0]              req_issue;
+    reg [REQS-1:0]              req_cmpl;
+    reg [63:0]                  req_due [0:REQS-1];
+    reg [3:0]                   req_sel [0:REQS-1];
+    reg [15:0]                  req_len [0:REQS-1];
+    reg [63:0]                  req_host [0:REQS-1];
+    reg [`MEM_ADDR_BITS-1:0]    req_addr [0:REQS-1];
+
+    wire [REQS-1:0]             req_busy = req_issue ^ req_cmpl;
+    assign rd_q_full = &req_busy;
+
+    integer i, j, k, free, due, strb_bytes;
+
+    always @(posedge clk) begin
+       if(reset) begin
+          req_issue <= 0;
+       end
+       else if(rd_q_enq_en && !rd_q_full) begin
+          free = -1;
+          for(i = 0; i < REQS; i = i + 1)
+             if(!req_busy[i] && (free < 0))
+                free = i;
+          req_due[free]  <= $time + LATENCY + {$random} % JITTER;
+          req_len[free]  <= rd_q_enq_data[15:0];
+          req_sel[free]  <= rd_q_enq_data[19:16];
+          req_host[free] <= rd_q_enq_data[83:20];
+          req_addr[free] <= rd_q_enq_data[84+:`MEM_ADDR_BITS];
+          req_issue[free] <= ~req_issue[free];
+       end
+    end
+
+    // descriptor i points at the packet at PKT_BASE + 64*i, no launch time
+    function [63:0] cm_word;
+       input [3:0]  sel;
+       input [63:0] host;
+       reg [63:0]   index;
+       begin
+          index = ((host - DSC_BASE) >> 6) & (RING-1);
+          cm_word = host;
+          if(sel == `ID_MEM_TX_DSC) begin
+             case(host[5:3])
+               3'd0:    cm_word = {PKT_LEN, 16'd0, 32'd0};
+               3'd1:    cm_word = PKT_BASE + (index << 6);
+               default: cm_word = 0;
+             endcase
+          end
+       end
+    endfunction
+
+    reg                         cm_busy;
+    reg [7:0]                   cm_slot;
+    reg [3:0]                   cm_sel;
+    reg [63:0]                  cm_host;
+    reg [`MEM_ADDR_BITS-1:0]    cm_addr;
+    reg [`MEM_ADDR_BITS-1:0]    cm_end;
+
+    // a cycle goes to the completion header before the data of each read
+    always @(posedge pcie_clk) begin
+       wr_en <= 0;
+       if(reset) begin
+          req_cmpl <= 0;
+          cm_busy <= 0;
+          wr_mem_select <= 0;
+       end
+       else if(!cm_busy) begin
+          due = -1;
+          for(j = 0; j < REQS; j = j + 1)
+             if(req_busy[j] && (req_due[j] <= $time) && (due < 0))
+                due = j;
+          if(due >= 0) begin
+             cm_busy <= 1;
+             cm_slot <= due;
+             cm_sel  <= req_sel[due];
+             cm_host <= req_host[due];
+             cm_addr <= req_addr[due];
+             cm_end  <= req_addr[due] + req_len[due];
+          end
+       end
+       else begin
+          wr_mem_select <= cm_sel;
+          wr_addr <= cm_addr;
+          wr_data <= cm_word(cm_sel, cm_host);
+          wr_en <= 1;
+          cm_addr <= cm_addr + 8;
+          cm_host <= cm_host + 8;
+          if(cm_addr + 8 >= cm_end) begin
+             req_cmpl[cm_slot] <= ~req_cmpl[cm_slot];
+             cm_busy <= 0;
+          end
+       end
+    end
+
+    // the driver takes every tx completion right away
+    always @(posedge clk) begin
+       if(reset)
+          mem_tx_dne_head <= 0;
+       else if(mem_tx_dne_wr_en)
+          mem_tx_dne_head <= (mem_tx_dne_wr_addr + 64) & TX_DNE_MASK;
+    end
+
+    // ---------------------------------------------
+    // nicpic: the class goes back to tx_ctrl after its feedback with all
+    // but one descriptor of the ring posted
+    // ---------------------------------------------
+    function [513:0] tx_task;
+       input [25:0] first;
+       reg [25:0]   head;
+       begin
+          head = first + 1;
+          head = head & (RING-1);
+          tx_task = {1'b0,                          // parent_vld
+                     10'd0,                         // parent_index
+                     64'd0,                         // parent_tokens
+                     24'd0,                         // parent_rate
+                     10'd0,                         // class_index
+                     64'd0,                         // tokens
+                     64'd0,                         // rate, nothing to pay
+                     DSC_BASE,                      // dsc_buffer_host_addr
+                     RING_MASK[31:0],               // dsc_buffer_mask
+                     head,                          // dsc_head_index
+                     first,                         // dsc_tail_index
+                     PKT_BASE + (first << 6),       // pkt_host_addr
+                     PKT_LEN,                       // pkt_len
+                     16'd0,                         // pkt_port
+                     33'd0};                        // pkt_launch
+       end
+    endfunction
+
+    reg [25:0]  task_first;
+    reg         task_pend;
+    reg [31:0]  task_due;
+
+    always @(posedge clk) begin
+       if(reset) begin
+          tx_task_q_empty <= 1;
+          task_first <= 0;
+          task_pend <= 1;
+          task_due <= 0;
+       end
+       else begin
+          if(tx_task_q_deq_en)
+             tx_task_q_empty <= 1;
+          if(feedback_task_q_enq_en) begin
+             // dsc_head_index of the feedback
+             task_first <= feedback_task_q_enq_data[154:129];
+             task_pend <= 1;
+             task_due <= cycle + FEEDBACK_DELAY;
+          end
+          else if(task_pend && tx_task_q_empty && (cycle >= task_due)) begin
+             tx_task_q_data <= tx_task(task_first);
+             tx_task_q_empty <= 0;
+             task_pend <= 0;
+          end
+       end
+    end
+
+    // ---------------------------------------------
+    // MAC
+    // ---------------------------------------------
+    reg [3:0]   mac_gap;
+    reg [15:0]  mac_bytes;
+    reg [31:0]  sent;
+    reg         bad_len;
+
+    assign M_AXIS_TREADY = (mac_gap == 0);
+
+    always @(posedge clk) begin
+       if(reset) begin
+          mac_gap <= 0;
+          mac_bytes <= 0;
+          sent <= 0;
+          bad_len <= 0;
+       end
+       else if(mac_gap != 0) begin
+          mac_gap <= mac_gap - 1;
+       end
+       else if(M_AXIS_TVALID) begin
+          strb_bytes = 0;
+          for(k = 0; k < 8; k = k + 1)
+             strb_bytes = strb_bytes + M_AXIS_TSTRB[k];
+          mac_bytes <= mac_bytes + strb_bytes;
+          if(M_AXIS_TLAST) begin
+             mac_gap <= MAC_GAP;
+             mac_bytes <= 0;
+             if(mac_bytes + strb_bytes != PKT_LEN)
+                bad_len <= 1;
+             if(cycle >= WARMUP_CYCLES)
+                sent <= sent + 1;
+          end
+       end
+    end
+
+    // ---------------------------------------------
+    // result
+    // ---------------------------------------------
+    real pkt_cycles, share;
+
+    initial begin
+       clk = 0;
+       pcie_clk = 0;
+       reset = 1;
+       #100 reset = 0;
+
+       wait(cycle == WARMUP_CYCLES + RUN_CYCLES);
+
+       pkt_cycles = (PKT_LEN + 4 + 20) / 8.0;
+       share = sent * pkt_cycles / RUN_CYCLES;
+       $display("depth %0d, pending %0d: %0d packets, %f of line rate at 64 bytes",
+                `TX_RD_IN_FLIGHT, `TX_PENDING_DEPTH, sent, share);
+
+       if(bad_len)
+          $display("Test Failed: packet of the wrong length");
+`ifdef TX_RD_SWEEP
+       else
+          $display("Test Done");
+`else
+       else if(share < LINE_RATE_MIN)
+          $display("Test Failed");
+       else
+          $display("Test Passed");
+`endif
+       $finish;
+    end
+
+    always #3.125 clk = ~clk;
+    always #2 pcie_clk = ~pcie_clk;
+
+endmodule
@@ -381,22 +381,22 @@ wire [2:0] state_output;
 
    // feedback task queue
    wire                       feedback_task_q_enq_en;
-   wire [195:0]               feedback_task_q_enq_data;
+   wire [351:0]               feedback_task_q_enq_data;
    wire                       feedback_task_q_full;
 
    // doorbell dne queue
    wire                       doorbell_dne_q_deq_en;
-   wire [31:0]                doorbell_dne_q_deq_data;
+   wire [287:0]               doorbell_dne_q_deq_data;
    wire                       doorbell_dne_q_empty;
 
    // tx task queue inputs
    wire                       tx_task_q_deq_en;
-   wire [381:0]               tx_task_q_data;
+   wire [513:0]               tx_task_q_data;
    wire                       tx_task_q_empty;
 
    // doorbell task queue output
    wire                       doorbell_task_q_enq_en;
-   wire [127:0]               doorbell_task_q_data;
+   wire [191:0]               doorbell_task_q_data;
    wire                       doorbell_task_q_full;
 
    // soft reset for nicpic
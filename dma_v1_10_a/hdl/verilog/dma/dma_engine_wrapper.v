@@ -47,22 +47,22 @@ module dma_engine
 
    // feedback task queue
    output         feedback_task_q_enq_en,
-   output [195:0] feedback_task_q_enq_data,
+   output [351:0] feedback_task_q_enq_data,
    input          feedback_task_q_full,
 
    // doorbell dne queue
    output         doorbell_dne_q_deq_en,
-   input [31:0]   doorbell_dne_q_deq_data,
+   input [287:0]  doorbell_dne_q_deq_data,
    input          doorbell_dne_q_empty,
 
    // tx task queue inputs
    output         tx_task_q_deq_en,
-   input [381:0]  tx_task_q_data,
+   input [513:0]  tx_task_q_data,
    input          tx_task_q_empty,
 
    // doorbell task queue output
    output         doorbell_task_q_enq_en,
-   output [127:0] doorbell_task_q_data,
+   output [191:0] doorbell_task_q_data,
    input          doorbell_task_q_full,
 
    // Tx
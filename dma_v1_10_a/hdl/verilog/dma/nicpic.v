@@ -43,22 +43,22 @@ module nicpic
    (
    // tx task queue
    input                   tx_task_q_deq_en,
-   output  [381:0]         tx_task_q_data,
+   output  [513:0]         tx_task_q_data,
    output                  tx_task_q_empty,
 
    // doorbell task queue
    input                   doorbell_task_q_enq_en,
-   input  [127:0]          doorbell_task_q_data,
+   input  [191:0]          doorbell_task_q_data,
    output                  doorbell_task_q_full,
 
    // doorbell dne queue
    input                   doorbell_dne_q_deq_en,
-   output [31:0]           doorbell_dne_q_deq_data,
+   output [287:0]          doorbell_dne_q_deq_data,
    output                  doorbell_dne_q_empty,
 
    // feedback task queue
    input                   feedback_task_q_enq_en,
-   input [195:0]           feedback_task_q_enq_data,
+   input [351:0]           feedback_task_q_enq_data,
    output                  feedback_task_q_full,
 
    // misc
@@ -73,10 +73,20 @@ module nicpic
    localparam DOORBELL_ADD_DSC = 4;
    localparam DOORBELL_STOP_CLASS = 5;
    localparam DOORBELL_DELETE_CLASS = 6;
+   localparam DOORBELL_SET_PARAMS = 7;
+   localparam DOORBELL_SET_PARENT = 9;
+   localparam DOORBELL_EVICT_CLASS = 10;
+   localparam DOORBELL_LOAD_CLASS = 11;
+   localparam DOORBELL_LOAD_STATE = 12;
+   localparam DOORBELL_SET_DRR = 13;
+   localparam DOORBELL_SET_MIN = 14;
+   localparam DOORBELL_READ_STATS = 15;
+   localparam DOORBELL_SET_PRIO = 16;
+   localparam DOORBELL_SET_STARVE = 17;
 
    // doorbell task queue signals
    reg doorbell_task_q_deq_en;
-   wire [127:0] doorbell_task_q_deq_data;
+   wire [191:0] doorbell_task_q_deq_data;
    wire doorbell_task_q_empty;
    wire [5:0] inst_doorbell;
    assign inst_doorbell = doorbell_task_q_deq_data[5:0];
@@ -119,11 +129,53 @@ module nicpic
    assign pkt_len_doorbell = doorbell_task_q_deq_data[31:16];
    wire [25:0] dsc_tail_index_doorbell;
    assign dsc_tail_index_doorbell = doorbell_task_q_deq_data[63:38];
+   // launch time of the packet, [32] valid and [31:0] the low bits of
+   // timecount. Host descriptors carry the same in their third word
+   wire [32:0] pkt_launch_doorbell;
+   assign pkt_launch_doorbell = doorbell_task_q_deq_data[160:128];
+   // DOORBELL_SET_PARAMS (rate in [127:64], same as DOORBELL_SET_RATE)
+   // also generated by the dma engine when it expands a bulk update
+   wire [39:0] tokens_max_params_doorbell;
+   assign tokens_max_params_doorbell = doorbell_task_q_deq_data[63:24];
+   wire notify_params_doorbell;
+   assign notify_params_doorbell = doorbell_task_q_deq_data[16];
+   // DOORBELL_SET_PARENT
+   wire parent_vld_doorbell;
+   assign parent_vld_doorbell = doorbell_task_q_deq_data[16];
+   wire [9:0] parent_index_doorbell;
+   assign parent_index_doorbell = doorbell_task_q_deq_data[73:64];
+   // DOORBELL_LOAD_CLASS uses the DOORBELL_ADD_CLASS fields
+   // DOORBELL_LOAD_STATE
+   wire [63:0] tokens_load_doorbell;
+   assign tokens_load_doorbell = doorbell_task_q_deq_data[127:64];
+   wire [25:0] dsc_head_index_load_doorbell;
+   assign dsc_head_index_load_doorbell = doorbell_task_q_deq_data[57:32];
+   // DOORBELL_SET_DRR
+   wire drr_doorbell;
+   assign drr_doorbell = doorbell_task_q_deq_data[16];
+   // DOORBELL_SET_MIN
+   wire [24:0] min_fill_doorbell;
+   assign min_fill_doorbell = doorbell_task_q_deq_data[40:16];
+   wire [39:0] min_tokens_max_doorbell;
+   assign min_tokens_max_doorbell = doorbell_task_q_deq_data[103:64];
+   // DOORBELL_READ_STATS, classes from class_index_doorbell on. DOORBELL_EVICT_CLASS
+   // sends the counters of its class the same way, [9] of the status word set
+   wire [9:0] stats_count_doorbell;       // minus one
+   assign stats_count_doorbell = doorbell_task_q_deq_data[25:16];
+   wire [5:0] stats_seq_doorbell;         // echoed in [15:10] of the entries
+   assign stats_seq_doorbell = doorbell_task_q_deq_data[31:26];
+   // DOORBELL_SET_PRIO
+   wire [1:0] prio_doorbell;
+   assign prio_doorbell = doorbell_task_q_deq_data[17:16];
+   // DOORBELL_SET_STARVE, for all classes
+   wire [15:0] starve_max_doorbell;
+   assign starve_max_doorbell = doorbell_task_q_deq_data[31:16];
 
 
    // doorbell done signals tell the host when it can free
-   // old dsc buffers
-   wire [31:0] doorbell_dne_q_enq_data;
+   // old dsc buffers, an evicted class also hands its state back.
+   // Stats snapshots share the queue, see below
+   wire [287:0] doorbell_dne_q_enq_data;
    reg    doorbell_dne_q_enq_en;
    wire    doorbell_dne_q_full;
    reg [9:0] class_index_doorbell_dne;
@@ -134,33 +186,58 @@ module nicpic
    assign doorbell_dne_q_enq_data[15:9] = 0;
    assign doorbell_dne_q_enq_data[21:16] = inst_doorbell_dne;
    assign doorbell_dne_q_enq_data[31:22] = class_index_doorbell_dne;
+   reg [63:0] spill_tokens_doorbell_dne;
+   reg [25:0] spill_dsc_head_index_doorbell_dne;
+   reg spill_pending_doorbell_dne;
+   assign doorbell_dne_q_enq_data[95:32] = spill_tokens_doorbell_dne;
+   assign doorbell_dne_q_enq_data[121:96] = spill_dsc_head_index_doorbell_dne;
+   assign doorbell_dne_q_enq_data[122] = spill_pending_doorbell_dne;
+   assign doorbell_dne_q_enq_data[287:123] = 0;
+   wire [287:0] snap_dne_data;
+   reg snap_enq;
 
    // tx task queue signals
-   wire [381:0] tx_task_q_enq_data;
+   wire [513:0] tx_task_q_enq_data;
    reg tx_task_q_enq_en;
    wire tx_task_q_full;
 
    // feedback task queue signals
    reg feedback_task_q_deq_en;
-   wire [195:0] feedback_task_q_deq_data;
+   wire [351:0] feedback_task_q_deq_data;
    wire feedback_task_q_empty;
+   wire [31:0] bytes_feedback;
+   wire [15:0] pkts_feedback;
+   wire parent_vld_feedback;
+   wire [9:0] parent_index_feedback;
+   wire [63:0] parent_tokens_feedback;
    wire [9:0] class_index_feedback;
    wire [63:0] tokens_feedback;
    wire [25:0] dsc_head_index_feedback;
    wire [63:0] pkt_host_addr_feedback;
    wire [15:0] pkt_port_feedback;
    wire [15:0] pkt_len_feedback;
-   assign {class_index_feedback,
+   wire [32:0] pkt_launch_feedback;
+   assign {bytes_feedback,
+           pkts_feedback,
+           parent_vld_feedback,
+           parent_index_feedback,
+           parent_tokens_feedback,
+           class_index_feedback,
            tokens_feedback,
            dsc_head_index_feedback,
            pkt_host_addr_feedback,
            pkt_port_feedback,
-           pkt_len_feedback} = feedback_task_q_deq_data;
+           pkt_len_feedback,
+           pkt_launch_feedback} = feedback_task_q_deq_data;
    
 
-   // doorbell task queue
+   // doorbell task queue, deep enough to take a burst of doorbells while
+   // the state machine is busy
+   localparam DOORBELL_Q_DEPTH_BITS = 5;
+
    fallthrough_small_fifo
-   #(.WIDTH(128)
+   #(.WIDTH(192),
+     .MAX_DEPTH_BITS(DOORBELL_Q_DEPTH_BITS)
     )
    doorbell_task_q
    (.din(doorbell_task_q_data),
@@ -177,11 +254,11 @@ module nicpic
 
    // doorbell dne queue
    fallthrough_small_fifo
-   #(.WIDTH(32)
+   #(.WIDTH(288)
     )
    doorbell_dne_q
-   (.din(doorbell_dne_q_enq_data),
-    .wr_en(doorbell_dne_q_enq_en),
+   (.din(snap_enq ? snap_dne_data : doorbell_dne_q_enq_data),
+    .wr_en(doorbell_dne_q_enq_en || snap_enq),
     .rd_en(doorbell_dne_q_deq_en),
     .dout(doorbell_dne_q_deq_data),
     .full(),
@@ -194,7 +271,7 @@ module nicpic
 
    // tx task queue
    fallthrough_small_fifo
-   #(.WIDTH(382)
+   #(.WIDTH(514)
     )
    tx_task_q
    (.din(tx_task_q_enq_data),
@@ -211,7 +288,7 @@ module nicpic
 
    // feedback task queue
    fallthrough_small_fifo
-   #(.WIDTH(196)
+   #(.WIDTH(352)
     )
    feedback_task_q
    (.din(feedback_task_q_enq_data),
@@ -228,17 +305,24 @@ module nicpic
 
    reg          ram_wr_en;
    reg [9:0]    ram_addr;
-   wire [511:0]  ram_din;
-   wire [511:0] ram_dout;
+   wire [545:0] ram_din;
+   wire [545:0] ram_douta;
+   // what the state machine reads, the class being dispatched comes
+   // from sched_row since port a is busy writing back the one before
+   wire [545:0] ram_dout;
+   // port b only reads, for the scheduler prefetch
+   reg [9:0]    ram_addrb;
+   wire [545:0] ram_doutb;
 
    // has to be write first
    nicpic_ram u_ram
-   (.clka(clk),
-    .rsta(rst),
+   (.clk(clk),
     .wea(ram_wr_en),
     .addra(ram_addr),
     .dina(ram_din),
-    .douta(ram_dout)
+    .douta(ram_douta),
+    .addrb(ram_addrb),
+    .doutb(ram_doutb)
    );
 
    reg [63:0] ram_din_dsc_buffer_host_addr;
@@ -248,19 +332,26 @@ module nicpic
    reg [63:0] ram_din_pkt_host_addr;
    reg [15:0] ram_din_pkt_port;
    reg [15:0] ram_din_pkt_len;
+   reg [32:0] ram_din_pkt_launch;
    reg [63:0] ram_din_rate;
    reg [63:0] ram_din_tokens;
    reg [63:0] ram_din_tokens_max;
    reg [63:0] ram_din_timestamp;
    reg ram_din_dirty;
-   assign ram_din[511:500] = 0;
-   assign ram_din[499:0] = {ram_din_dsc_buffer_host_addr,
+   reg ram_din_parent_vld;
+   reg [9:0] ram_din_parent_index;
+   reg ram_din_drr;
+   assign ram_din = {ram_din_drr,
+                     ram_din_parent_vld,
+                     ram_din_parent_index,
+                     ram_din_dsc_buffer_host_addr,
                      ram_din_dsc_buffer_mask,
                      ram_din_dsc_head_index,
                      ram_din_dsc_tail_index,
                      ram_din_pkt_host_addr,
                      ram_din_pkt_port,
                      ram_din_pkt_len,
+                     ram_din_pkt_launch,
                      ram_din_rate,
                      ram_din_tokens,
                      ram_din_tokens_max,
@@ -274,30 +365,80 @@ module nicpic
    wire [63:0] ram_dout_pkt_host_addr;
    wire [15:0] ram_dout_pkt_port;
    wire [15:0] ram_dout_pkt_len;
+   wire [32:0] ram_dout_pkt_launch;
    wire [63:0] ram_dout_rate;
    wire [63:0] ram_dout_tokens;
    wire [63:0] ram_dout_tokens_max;
    wire [63:0] ram_dout_timestamp;
    wire ram_dout_dirty;
-   assign {ram_dout_dsc_buffer_host_addr,
+   wire ram_dout_parent_vld;
+   wire [9:0] ram_dout_parent_index;
+   // deficit round robin class: tokens hold the deficit and tokens_max the
+   // quantum, rate is the cost per byte. It is not paced, only shared
+   wire ram_dout_drr;
+   assign {ram_dout_drr,
+           ram_dout_parent_vld,
+           ram_dout_parent_index,
+           ram_dout_dsc_buffer_host_addr,
            ram_dout_dsc_buffer_mask,
            ram_dout_dsc_head_index,
            ram_dout_dsc_tail_index,
            ram_dout_pkt_host_addr,
            ram_dout_pkt_port,
            ram_dout_pkt_len,
+           ram_dout_pkt_launch,
            ram_dout_rate,
            ram_dout_tokens,
            ram_dout_tokens_max,
            ram_dout_timestamp,
-           ram_dout_dirty} = ram_dout[499:0];
+           ram_dout_dirty} = ram_dout;
+
+   // committed (min) bucket of each class, next to the class ram and
+   // written with it. It counts in the same units as the peak bucket, so
+   // sending charges both alike, and fills min_fill/4096 tokens per cycle
+   localparam MIN_FRAC_BITS = 12;
+
+   reg [128:0] min_ram [0:1023];
+   reg [128:0] min_ram_douta;
+   reg [128:0] min_ram_doutb;
+   wire [128:0] min_ram_dout;
+   wire [128:0] min_ram_din;
+
+   always @(posedge clk) begin
+      if(ram_wr_en) begin
+         min_ram[ram_addr] <= min_ram_din;
+         min_ram_douta <= min_ram_din;
+      end
+      else begin
+         min_ram_douta <= min_ram[ram_addr];
+      end
+      min_ram_doutb <= min_ram[ram_addrb];
+   end
+
+   reg [24:0] min_din_fill;
+   reg [39:0] min_din_tokens_max;
+   reg [63:0] min_din_tokens;
+   assign min_ram_din = {min_din_fill,
+                         min_din_tokens_max,
+                         min_din_tokens};
+
+   wire [24:0] min_dout_fill;
+   wire [39:0] min_dout_tokens_max;
+   wire [63:0] min_dout_tokens;
+   assign {min_dout_fill,
+           min_dout_tokens_max,
+           min_dout_tokens} = min_ram_dout;
 
    localparam STATE_IDLE = 0;
    localparam STATE_FEEDBACK = 1;
    localparam STATE_DOORBELL = 2;
-   localparam STATE_TOKENS_L1 = 3;
+   //localparam STATE_TOKENS_L1 = 3;
    localparam STATE_TOKENS_L2 = 4;
    //localparam STATE_TOKENS_L3 = 5;
+   localparam STATE_PARENT_L1 = 6;
+   //localparam STATE_PARENT_L2 = 7;
+   localparam STATE_FEEDBACK_PARENT_L1 = 8;
+   localparam STATE_FEEDBACK_PARENT_L2 = 9;
 
    reg [63:0] timestamp_reg, timestamp_reg_nxt;
    //reg [63:0] timestamp_old_reg, timestamp_old_reg_nxt;
@@ -305,30 +446,392 @@ module nicpic
    //reg [63:0] tokens_max_reg, tokens_max_reg_nxt;
    reg [63:0] pkt_host_addr_reg, pkt_host_addr_reg_nxt;
    reg [15:0] pkt_len_reg, pkt_len_reg_nxt;
+   reg [31:0] launch_wait_reg, launch_wait_reg_nxt;
    reg [63:0] rate_reg, rate_reg_nxt;
    reg [63:0] tokens_reg, tokens_reg_nxt;
+   reg        drr_reg, drr_reg_nxt;
+   reg [63:0] min_tokens_reg, min_tokens_reg_nxt;
+   reg        excess_reg, excess_reg_nxt;
    //reg        tokens_enough_reg, tokens_enough_reg_nxt;
+   // parent class of a two level hierarchy, its tokens are reserved at
+   // dispatch and what the child leaves is refunded on feedback
+   reg [9:0] parent_index_reg, parent_index_reg_nxt;
+   reg [63:0] parent_tokens_reg, parent_tokens_reg_nxt;
+   reg [23:0] parent_rate_reg, parent_rate_reg_nxt;
 
    reg [3:0] state, state_nxt;
    reg doorbell_stall, doorbell_stall_nxt;
+
+   // row of the class between its evaluation and STATE_TOKENS_L2
+   reg [545:0] sched_row;
+   reg [128:0] sched_min_row;
+   assign ram_dout = (state == STATE_TOKENS_L2) ? sched_row : ram_douta;
+   assign min_ram_dout = (state == STATE_TOKENS_L2) ? sched_min_row : min_ram_douta;
    reg [63:0] timecount;
    wire [63:0] timecount_nxt;
    assign timecount_nxt = timecount + 1;
    reg [9:0] class_index, class_index_nxt;
-   wire [9:0] class_index_plus_1;
-   assign class_index_plus_1 = class_index + 1;
    reg [9:0] class_num, class_num_nxt;
    wire [9:0] class_num_plus_1;
    assign class_num_plus_1 = class_num + 1;
    wire [9:0] class_num_minus_1;
    assign class_num_minus_1 = class_num - 1;
+   // token buckets gain 2^TOKENS_SHIFT tokens per cycle and a byte costs
+   // rate tokens. Against the old 16 tokens per cycle this gives rate 8
+   // fractional bits: 24 bit rates cover 312 kbps to 20 Gbps at 160 MHz,
+   // for any 16 bit packet length. A step is 1/rate, 0.19% at 10 Gbps (rate
+   // 524) and below 0.1% up to 5.2 Gbps. The nearest rate is at most half a
+   // step off, within 0.1% up to 10 Gbps
+   localparam TOKENS_SHIFT = 12;
    wire [63:0] tokens_nxt;
-   assign tokens_nxt = ((timecount - ram_dout_timestamp)<<4) + ram_dout_tokens;
+   assign tokens_nxt = ((timecount - ram_dout_timestamp)<<TOKENS_SHIFT) + ram_dout_tokens;
    wire [63:0] tokens_needed;
-   assign tokens_needed[63:27] = 0;
-   assign tokens_needed[26:0] = pkt_len_reg[10:0] * rate_reg[15:0];
+   assign tokens_needed[63:40] = 0;
+   assign tokens_needed[39:0] = pkt_len_reg[15:0] * rate_reg[23:0];
+   wire [63:0] tokens_capped;
+   assign tokens_capped = (tokens_nxt < ram_dout_tokens_max) ? tokens_nxt : ram_dout_tokens_max;
+   wire [63:0] parent_tokens_needed;
+   assign parent_tokens_needed[63:40] = 0;
+   assign parent_tokens_needed[39:0] = pkt_len_reg[15:0] * ram_dout_rate[23:0];
+   // a packet with a launch time waits for it like for tokens, in the
+   // calendar. Launch times are the low 32 bits of timecount, so they
+   // reach 13 s ahead at 160 MHz
+   wire launch_due;
+   assign launch_due = (launch_wait_reg == 0);
+   wire [63:0] launch_deficit;
+   assign launch_deficit = {20'b0, launch_wait_reg, {TOKENS_SHIFT{1'b0}}};
+   wire [63:0] tokens_deficit;
+   assign tokens_deficit = (tokens_reg >= tokens_needed) ? 0 : (tokens_needed - tokens_reg);
+   // a round robin class only waits for the launch time
+   wire [63:0] wait_deficit;
+   assign wait_deficit = (drr_reg || (launch_deficit > tokens_deficit)) ? launch_deficit : tokens_deficit;
+   wire child_ready;
+   assign child_ready = (pkt_host_addr_reg != 0) && (tokens_reg >= tokens_needed) && (rate_reg != 0) &&
+                        launch_due;
+
+   wire [63:0] min_elapsed;
+   assign min_elapsed = timecount - ram_dout_timestamp;
+   wire [63:0] min_tokens_nxt;
+   assign min_tokens_nxt = min_dout_tokens + min_elapsed[31:0] * min_dout_fill;
+   wire [63:0] min_tokens_cap;
+   assign min_tokens_cap = {12'b0, min_dout_tokens_max, {MIN_FRAC_BITS{1'b0}}};
+   wire [63:0] min_tokens_capped;
+   assign min_tokens_capped = ((min_elapsed[63:32] != 0) || (min_tokens_nxt >= min_tokens_cap)) ?
+                              min_tokens_cap : min_tokens_nxt;
+   // within its committed rate, such a class goes ahead of excess traffic.
+   // A class without a min rate has no committed bucket to run out of and
+   // is dispatched as it comes, read in STATE_TOKENS_L2 from sched_min_row
+   wire committed;
+   assign committed = (min_dout_fill == 0) ||
+                      (min_tokens_reg >= {tokens_needed[63-MIN_FRAC_BITS:0], {MIN_FRAC_BITS{1'b0}}});
+   // what a batch spent, charged to the committed bucket on feedback
+   wire [63:0] tokens_spent_feedback;
+   assign tokens_spent_feedback = (ram_dout_tokens > tokens_feedback) ? (ram_dout_tokens - tokens_feedback) : 0;
+   wire [63:0] min_spent_feedback;
+   assign min_spent_feedback = {tokens_spent_feedback[63-MIN_FRAC_BITS:0], {MIN_FRAC_BITS{1'b0}}};
+
+   // calendar queue. A backlogged class that cannot send yet waits in the
+   // bucket of its next eligible time, buckets are spliced into the ready
+   // list as time passes and the scheduler only pops the ready list.
+   // Eligibility is checked again on pop, so a bucket may fire early
+   localparam CAL_BITS = 8;                  // 256 buckets
+   localparam CAL_SLOT_BITS = 8;             // of 256 cycles each
+   localparam CAL_N = 1 << CAL_BITS;
+   localparam CAL_SLOT_CYCLES = 1 << CAL_SLOT_BITS;
+
+   reg [9:0] class_next [0:1023];
+   reg [1023:0] class_queued;
+   // classes with a packet, a rate and nothing in flight, kept from every
+   // class ram write. A list entry whose class is no longer backlogged
+   // (stopped, evicted, deleted) is dropped on pop and never evaluated
+   reg [1023:0] class_backlog;
+   wire backlog_din;
+   assign backlog_din = (ram_din_pkt_host_addr != 0) && !ram_din_dirty && (ram_din_rate != 0);
+   // strict priority, one ready and one excess list per level and level 0
+   // goes first. A level skipped prio_starve_max times while it waits is
+   // served next, 0 turns that off. New classes are at level 0
+   localparam PRIO_BITS = 2;
+   localparam PRIO_LEVELS = 1 << PRIO_BITS;
+   reg [PRIO_BITS-1:0] class_prio [0:1023];
+   reg [15:0] prio_starve_max;
+   reg [15:0] prio_skip [0:PRIO_LEVELS-1];
+   integer prio_i;
+   initial begin
+      for(prio_i = 0; prio_i < 1024; prio_i = prio_i + 1)
+         class_prio[prio_i] = 0;
+   end
+   reg prio_wr_en;
+   reg [9:0] prio_wr_index;
+   reg [PRIO_BITS-1:0] prio_wr_level;
+   reg starve_wr_en;
+
+   reg [9:0] ready_head [0:PRIO_LEVELS-1];
+   reg [9:0] ready_tail [0:PRIO_LEVELS-1];
+   reg [PRIO_LEVELS-1:0] ready_vld;
+   // classes under their ceiling but out of committed tokens, served when
+   // the ready list of their level is empty
+   reg [9:0] excess_head [0:PRIO_LEVELS-1];
+   reg [9:0] excess_tail [0:PRIO_LEVELS-1];
+   reg [PRIO_LEVELS-1:0] excess_vld;
+   wire [PRIO_LEVELS-1:0] prio_vld;
+   assign prio_vld = ready_vld | excess_vld;
+   // a calendar per level, bucket b of level l at {l, b}
+   reg [9:0] cal_head [0:CAL_N*PRIO_LEVELS-1];
+   reg [9:0] cal_tail [0:CAL_N*PRIO_LEVELS-1];
+   reg [CAL_N*PRIO_LEVELS-1:0] cal_vld;
+   reg [CAL_BITS-1:0] cal_ptr;
+   reg [PRIO_BITS-1:0] cal_lvl;    // level of the bucket spliced next
+   reg [63:0] cal_time;
+   wire cal_due;
+   assign cal_due = (timecount >= cal_time);
+
+   // list operations. The state machine pushes at most once per cycle, a
+   // due bucket is spliced when it does not, and the prefetch pops
+   reg ready_pop;
+   reg ready_push;
+   reg excess_pop;
+   reg excess_push;
+   reg cal_push;
+   wire cal_splice;
+   assign cal_splice = cal_due && !ready_push && !excess_push && !cal_push;
+   reg [9:0] push_class_index;
+   wire [PRIO_BITS-1:0] push_lvl;
+   assign push_lvl = class_prio[push_class_index];
+   // level of the class in the state machine
+   wire [PRIO_BITS-1:0] class_lvl;
+   assign class_lvl = class_prio[class_index];
+   reg [63:0] cal_deficit;
+   // level the prefetch pops from
+   reg [PRIO_BITS-1:0] pop_lvl;
+   wire [9:0] ready_head_pop;
+   assign ready_head_pop = ready_head[pop_lvl];
+   wire [9:0] excess_head_pop;
+   assign excess_head_pop = excess_head[pop_lvl];
+   // what is left of the lists after this cycle's pop, and the levels
+   // that waited too long
+   wire [PRIO_LEVELS-1:0] ready_left;
+   wire [PRIO_LEVELS-1:0] excess_left;
+   wire [PRIO_LEVELS-1:0] prio_starved;
+   genvar gl;
+   generate
+      for(gl = 0; gl < PRIO_LEVELS; gl = gl + 1) begin: prio_level
+         assign ready_left[gl] = ready_vld[gl] &&
+                                 !(ready_pop && (pop_lvl == gl) && (ready_head[gl] == ready_tail[gl]));
+         assign excess_left[gl] = excess_vld[gl] &&
+                                  !(excess_pop && (pop_lvl == gl) && (excess_head[gl] == excess_tail[gl]));
+         assign prio_starved[gl] = prio_vld[gl] && (prio_starve_max != 0) &&
+                                   (prio_skip[gl] >= prio_starve_max);
+      end
+   endgenerate
+
+   // scheduler prefetch. The next class is popped and read on port b while
+   // the state machine is busy, so a class can be evaluated every cycle.
+   // It counts as queued until then, and port a writes to it are forwarded
+   reg pf_vld;
+   reg pf_rd;                 // its row is on port b this cycle
+   reg [9:0] pf_index;
+   reg pf_excess;             // popped from the excess list
+   reg [545:0] pf_row;
+   reg [128:0] pf_min_row;
+   wire [PRIO_BITS-1:0] pf_lvl;
+   assign pf_lvl = class_prio[pf_index];
+   wire [545:0] pf_dout;
+   assign pf_dout = pf_rd ? ram_doutb : pf_row;
+   wire [128:0] pf_min_dout;
+   assign pf_min_dout = pf_rd ? min_ram_doutb : pf_min_row;
+   wire [9:0] pop_class_index;
+   assign pop_class_index = ready_pop ? ready_head_pop : excess_head_pop;
+   wire pop_backlog;
+   assign pop_backlog = (ram_wr_en && (ram_addr == pop_class_index)) ? backlog_din : class_backlog[pop_class_index];
+   // the state machine takes the prefetched class
+   reg sched_go;
+
+   wire [63:0] pf_dout_dsc_buffer_host_addr;
+   wire [31:0] pf_dout_dsc_buffer_mask;
+   wire [25:0] pf_dout_dsc_head_index;
+   wire [25:0] pf_dout_dsc_tail_index;
+   wire [63:0] pf_dout_pkt_host_addr;
+   wire [15:0] pf_dout_pkt_port;
+   wire [15:0] pf_dout_pkt_len;
+   wire [32:0] pf_dout_pkt_launch;
+   wire [63:0] pf_dout_rate;
+   wire [63:0] pf_dout_tokens;
+   wire [63:0] pf_dout_tokens_max;
+   wire [63:0] pf_dout_timestamp;
+   wire pf_dout_dirty;
+   wire pf_dout_parent_vld;
+   wire [9:0] pf_dout_parent_index;
+   wire pf_dout_drr;
+   assign {pf_dout_drr,
+           pf_dout_parent_vld,
+           pf_dout_parent_index,
+           pf_dout_dsc_buffer_host_addr,
+           pf_dout_dsc_buffer_mask,
+           pf_dout_dsc_head_index,
+           pf_dout_dsc_tail_index,
+           pf_dout_pkt_host_addr,
+           pf_dout_pkt_port,
+           pf_dout_pkt_len,
+           pf_dout_pkt_launch,
+           pf_dout_rate,
+           pf_dout_tokens,
+           pf_dout_tokens_max,
+           pf_dout_timestamp,
+           pf_dout_dirty} = pf_dout;
+   wire [24:0] pf_min_dout_fill;
+   wire [39:0] pf_min_dout_tokens_max;
+   wire [63:0] pf_min_dout_tokens;
+   assign {pf_min_dout_fill,
+           pf_min_dout_tokens_max,
+           pf_min_dout_tokens} = pf_min_dout;
+
+   wire [63:0] pf_tokens_nxt;
+   assign pf_tokens_nxt = ((timecount - pf_dout_timestamp)<<TOKENS_SHIFT) + pf_dout_tokens;
+   wire [31:0] pf_launch_ahead;
+   assign pf_launch_ahead = pf_dout_pkt_launch[31:0] - timecount[31:0];
+   wire [31:0] pf_launch_wait;
+   assign pf_launch_wait = (pf_dout_pkt_launch[32] && !pf_launch_ahead[31]) ? pf_launch_ahead : 0;
+   wire [63:0] pf_min_elapsed;
+   assign pf_min_elapsed = timecount - pf_dout_timestamp;
+   wire [63:0] pf_min_tokens_nxt;
+   assign pf_min_tokens_nxt = pf_min_dout_tokens + pf_min_elapsed[31:0] * pf_min_dout_fill;
+   wire [63:0] pf_min_tokens_cap;
+   assign pf_min_tokens_cap = {12'b0, pf_min_dout_tokens_max, {MIN_FRAC_BITS{1'b0}}};
+   wire [63:0] pf_min_tokens_capped;
+   assign pf_min_tokens_capped = ((pf_min_elapsed[63:32] != 0) || (pf_min_tokens_nxt >= pf_min_tokens_cap)) ?
+                                 pf_min_tokens_cap : pf_min_tokens_nxt;
+   // tokens still missing are earned at 2^TOKENS_SHIFT per cycle, waits beyond
+   // the horizon park in the farthest bucket and are checked again there
+   wire [63:0] cal_slots;
+   assign cal_slots = cal_deficit >> (TOKENS_SHIFT + CAL_SLOT_BITS);
+   wire [CAL_BITS-1:0] cal_bucket;
+   assign cal_bucket = cal_ptr + 1 + ((cal_slots >= CAL_N - 2) ? (CAL_N - 2) : cal_slots[CAL_BITS-1:0]);
+   wire [PRIO_BITS+CAL_BITS-1:0] cal_push_slot;
+   assign cal_push_slot = {push_lvl, cal_bucket};
+   wire [PRIO_BITS+CAL_BITS-1:0] cal_splice_slot;
+   assign cal_splice_slot = {cal_lvl, cal_ptr};
+
+   // next packet of a class coming back from the tx engine
+   wire feedback_skip_dsc;
+   assign feedback_skip_dsc = (pkt_host_addr_feedback == 0) &&
+                              (dsc_head_index_feedback != ram_dout_dsc_tail_index);
+   wire [63:0] pkt_host_addr_pending_feedback;
+   assign pkt_host_addr_pending_feedback = feedback_skip_dsc ? ram_dout_pkt_host_addr : pkt_host_addr_feedback;
+   wire [15:0] pkt_len_pending_feedback;
+   assign pkt_len_pending_feedback = feedback_skip_dsc ? ram_dout_pkt_len : pkt_len_feedback;
+   wire [63:0] tokens_now_feedback;
+   assign tokens_now_feedback = ((timecount - ram_dout_timestamp)<<TOKENS_SHIFT) + tokens_feedback;
+   wire [63:0] tokens_needed_feedback;
+   assign tokens_needed_feedback[63:40] = 0;
+   assign tokens_needed_feedback[39:0] = pkt_len_pending_feedback[15:0] * ram_dout_rate[23:0];
+   wire [32:0] pkt_launch_pending_feedback;
+   assign pkt_launch_pending_feedback = feedback_skip_dsc ? ram_dout_pkt_launch : pkt_launch_feedback;
+   wire [31:0] launch_ahead_feedback;
+   assign launch_ahead_feedback = pkt_launch_pending_feedback[31:0] - timecount[31:0];
+   wire [63:0] launch_deficit_feedback;
+   assign launch_deficit_feedback = (pkt_launch_pending_feedback[32] && !launch_ahead_feedback[31]) ?
+                                    {20'b0, launch_ahead_feedback, {TOKENS_SHIFT{1'b0}}} : 0;
+   wire [63:0] tokens_deficit_feedback;
+   assign tokens_deficit_feedback = (ram_dout_drr || (tokens_now_feedback >= tokens_needed_feedback)) ? 0 :
+                                    (tokens_needed_feedback - tokens_now_feedback);
+   // what the requeued class waits for, nothing if it can go now
+   wire [63:0] wait_deficit_feedback;
+   assign wait_deficit_feedback = (launch_deficit_feedback > tokens_deficit_feedback) ?
+                                  launch_deficit_feedback : tokens_deficit_feedback;
 
-   assign tx_task_q_enq_data = {class_index,
+   // per class counters, apart from the class ram so they widen no
+   // scheduler path. The state machine posts at most one update per cycle,
+   // it is read and added in the two cycles after
+   reg [255:0] stats_ram [0:1023];
+   reg [255:0] stats_ram_dout;
+   reg [9:0] stats_raddr;
+   reg [9:0] stats_rd_index;
+   reg stats_upd;
+   reg stats_clear;                  // the slot gets a new class
+   reg [9:0] stats_index;
+   reg [31:0] stats_bytes;
+   reg [15:0] stats_pkts;
+   reg [63:0] stats_starved;
+   reg stats_doorbell;
+
+   reg stats_s1_vld;
+   reg stats_s1_clear;
+   reg [9:0] stats_s1_index;
+   reg [31:0] stats_s1_bytes;
+   reg [15:0] stats_s1_pkts;
+   reg [63:0] stats_s1_starved;
+   reg stats_s1_doorbell;
+   reg stats_wr_vld;
+   reg [9:0] stats_wr_index;
+   reg [255:0] stats_wr_data;
+
+   integer stats_i;
+   initial begin
+      for(stats_i = 0; stats_i < 1024; stats_i = stats_i + 1)
+         stats_ram[stats_i] = 0;
+   end
+
+   // the read misses the write of the same cycle
+   wire [255:0] stats_fwd_dout;
+   assign stats_fwd_dout = (stats_wr_vld && (stats_wr_index == stats_rd_index)) ? stats_wr_data : stats_ram_dout;
+   wire [63:0] stats_dout_bytes;
+   wire [63:0] stats_dout_pkts;
+   wire [63:0] stats_dout_starved;
+   wire [63:0] stats_dout_doorbells;
+   assign {stats_dout_doorbells,
+           stats_dout_starved,
+           stats_dout_pkts,
+           stats_dout_bytes} = stats_s1_clear ? 256'b0 : stats_fwd_dout;
+   wire [255:0] stats_din;
+   assign stats_din = {stats_dout_doorbells + stats_s1_doorbell,
+                       stats_dout_starved + stats_s1_starved,
+                       stats_dout_pkts + stats_s1_pkts,
+                       stats_dout_bytes + stats_s1_bytes};
+
+   // a class parked in the calendar is backlogged but out of tokens until
+   // its bucket fires, that wait is counted when it is parked
+   wire [CAL_BITS-1:0] cal_ahead;
+   assign cal_ahead = cal_bucket - cal_ptr;
+   wire [63:0] cal_fire;
+   assign cal_fire = cal_time + (cal_ahead << CAL_SLOT_BITS);
+   wire [63:0] cal_wait;
+   assign cal_wait = (cal_fire > timecount) ? (cal_fire - timecount) : 0;
+
+   // stats snapshot, DOORBELL_READ_STATS copies the counters of a range of
+   // classes to the doorbell dne queue, one entry per class. Rows are read
+   // when no update is and queued when the state machine does not enqueue
+   reg snap_busy;
+   reg snap_rd;
+   reg snap_hold;
+   reg snap_issue;
+   reg snap_start;
+   reg [9:0] snap_index;
+   reg [9:0] snap_last;
+   reg [255:0] snap_data;
+   reg snap_evict;                   // the counters of an evicted class
+   reg snap_evict_start;
+   reg [5:0] snap_seq;
+   wire [10:0] snap_last_doorbell;
+   assign snap_last_doorbell = class_index_doorbell + stats_count_doorbell;
+   assign snap_dne_data[7:0] = 8'd1;
+   assign snap_dne_data[8] = 1'b1;
+   assign snap_dne_data[9] = snap_evict;
+   assign snap_dne_data[15:10] = snap_seq;
+   assign snap_dne_data[21:16] = DOORBELL_READ_STATS;
+   assign snap_dne_data[31:22] = snap_index;
+   assign snap_dne_data[287:32] = snap_data;
+   // a snapshot waits behind the one running, other work goes on. So does
+   // an eviction, it hands back the counters of its class as a snapshot
+   wire doorbell_ready;
+   assign doorbell_ready = !doorbell_task_q_empty && !doorbell_stall &&
+                           !(snap_busy && ((inst_doorbell == DOORBELL_READ_STATS) ||
+                                           (inst_doorbell == DOORBELL_EVICT_CLASS)));
+
+   assign tx_task_q_enq_data = {ram_dout_parent_vld,
+                                ram_dout_parent_index,
+                                parent_tokens_reg,
+                                parent_rate_reg,
+                                class_index,
                                 tokens_reg,
                                 ram_dout_rate,
                                 ram_dout_dsc_buffer_host_addr,
@@ -337,7 +840,8 @@ module nicpic
                                 ram_dout_dsc_tail_index,
                                 ram_dout_pkt_host_addr,
                                 ram_dout_pkt_len,
-                                ram_dout_pkt_port};
+                                ram_dout_pkt_port,
+                                ram_dout_pkt_launch};
 
    always @(*) begin
       state_nxt = state;
@@ -351,9 +855,16 @@ module nicpic
       //tokens_max_reg_nxt = tokens_max_reg;
       pkt_host_addr_reg_nxt = pkt_host_addr_reg;
       pkt_len_reg_nxt = pkt_len_reg;
+      launch_wait_reg_nxt = launch_wait_reg;
       rate_reg_nxt = rate_reg;
       tokens_reg_nxt = tokens_reg;
+      drr_reg_nxt = drr_reg;
+      min_tokens_reg_nxt = min_tokens_reg;
+      excess_reg_nxt = excess_reg;
       //tokens_enough_reg_nxt = tokens_enough_reg;
+      parent_index_reg_nxt = parent_index_reg;
+      parent_tokens_reg_nxt = parent_tokens_reg;
+      parent_rate_reg_nxt = parent_rate_reg;
 
       ram_din_dsc_buffer_host_addr = ram_dout_dsc_buffer_host_addr;
       ram_din_dsc_buffer_mask      = ram_dout_dsc_buffer_mask;
@@ -362,11 +873,18 @@ module nicpic
       ram_din_pkt_host_addr        = ram_dout_pkt_host_addr;
       ram_din_pkt_port             = ram_dout_pkt_port;
       ram_din_pkt_len              = ram_dout_pkt_len;
+      ram_din_pkt_launch           = ram_dout_pkt_launch;
       ram_din_rate                 = ram_dout_rate;
       ram_din_tokens               = ram_dout_tokens;
       ram_din_tokens_max           = ram_dout_tokens_max;
       ram_din_timestamp            = ram_dout_timestamp;
       ram_din_dirty                = ram_dout_dirty;
+      ram_din_parent_vld           = ram_dout_parent_vld;
+      ram_din_parent_index         = ram_dout_parent_index;
+      ram_din_drr                  = ram_dout_drr;
+      min_din_fill                 = min_dout_fill;
+      min_din_tokens_max           = min_dout_tokens_max;
+      min_din_tokens               = min_dout_tokens;
 
       ram_wr_en = 0;
       ram_addr = 0;
@@ -379,10 +897,35 @@ module nicpic
       class_index_doorbell_dne = 0;
       inst_doorbell_dne = 0;
       success_doorbell_dne = 0;
+      spill_tokens_doorbell_dne = 0;
+      spill_dsc_head_index_doorbell_dne = 0;
+      spill_pending_doorbell_dne = 0;
+
+      ready_push = 0;
+      excess_push = 0;
+      cal_push = 0;
+      push_class_index = 0;
+      cal_deficit = 0;
+      sched_go = 0;
+
+      stats_upd = 0;
+      stats_clear = 0;
+      stats_index = 0;
+      stats_bytes = 0;
+      stats_pkts = 0;
+      stats_starved = 0;
+      stats_doorbell = 0;
+      snap_start = 0;
+      snap_evict_start = 0;
+
+      prio_wr_en = 0;
+      prio_wr_index = 0;
+      prio_wr_level = 0;
+      starve_wr_en = 0;
 
       case(state)
          STATE_IDLE: begin
-            if(!doorbell_task_q_empty && !doorbell_stall) begin
+            if(doorbell_ready) begin
                ram_addr = class_index_doorbell;
                state_nxt = STATE_DOORBELL;
             end
@@ -390,50 +933,68 @@ module nicpic
                ram_addr = class_index_feedback;
                state_nxt = STATE_FEEDBACK;
             end
-            else if(class_num != 0) begin
-               ram_addr = class_index;
-               state_nxt = STATE_TOKENS_L1;
+            else if(pf_vld) begin
+               sched_go = 1;
             end
          end
 
-         STATE_TOKENS_L1: begin
-            ram_addr = class_index;
-            if(ram_dout_dirty) begin
-               // skip to next class
-               if(class_index >= class_num_minus_1) begin
-                  class_index_nxt = 0;
-               end
-               else begin
-                  class_index_nxt = class_index_plus_1;
-               end
-               state_nxt = STATE_IDLE;
+         STATE_PARENT_L1: begin
+            ram_addr = parent_index_reg;
+            // the parent must afford the first packet too. A parent that is
+            // in flight itself holds its tokens, so its children wait
+            if(child_ready && !ram_dout_dirty && (ram_dout_rate != 0) &&
+               (tokens_capped >= parent_tokens_needed)) begin
+               // reserve all parent tokens
+               ram_wr_en = 1;
+               ram_din_tokens = 0;
+               ram_din_timestamp = timecount;
+               min_din_tokens = min_tokens_capped;
+               parent_tokens_reg_nxt = tokens_capped;
+               parent_rate_reg_nxt = ram_dout_rate[23:0];
+               state_nxt = STATE_TOKENS_L2;
+            end
+            else if(drr_reg && !child_ready && (pkt_host_addr_reg != 0) && (rate_reg != 0) && launch_due) begin
+               // a round robin class short of deficit takes its quantum in
+               // L2, the parent is only charged for packets
+               state_nxt = STATE_TOKENS_L2;
             end
             else begin
-               if(tokens_nxt < ram_dout_tokens_max) begin
-                  tokens_reg_nxt = tokens_nxt;
+               // wait for whichever bucket is short, a busy parent is
+               // retried in the next slot and a stopped one at the horizon
+               if(child_ready) begin
+                  cal_push = 1;
+                  if(ram_dout_dirty) begin
+                     cal_deficit = 0;
+                  end
+                  else if(ram_dout_rate == 0) begin
+                     cal_deficit = {64{1'b1}};
+                  end
+                  else begin
+                     cal_deficit = parent_tokens_needed - tokens_capped;
+                  end
                end
-               else begin
-                  tokens_reg_nxt = ram_dout_tokens_max;
+               else if((pkt_host_addr_reg != 0) && (rate_reg != 0)) begin
+                  cal_push = 1;
+                  cal_deficit = wait_deficit;
                end
-
-               timestamp_reg_nxt = timecount;
-               //timestamp_old_reg_nxt = ram_dout_timestamp;
-               //tokens_old_reg_nxt = ram_dout_tokens;
-               //tokens_max_reg_nxt = ram_dout_tokens_max;
-               pkt_host_addr_reg_nxt = ram_dout_pkt_host_addr;
-               pkt_len_reg_nxt = ram_dout_pkt_len;
-               rate_reg_nxt = ram_dout_rate;
-
-               state_nxt = STATE_TOKENS_L2;
+               push_class_index = class_index;
+               state_nxt = STATE_IDLE;
             end
          end
 
          STATE_TOKENS_L2: begin
             ram_addr = class_index;
-            // send tx task
-            if((pkt_host_addr_reg != 0) && 
-               (tokens_reg >= tokens_needed) &&
-               (rate_reg != 0)) begin
+            // send tx task. Out of committed tokens a class yields to the
+            // ones still waiting on the ready list of its level and sends
+            // from spare capacity later, never to a lower level
+            if(child_ready && !committed && !excess_reg &&
+               (ready_vld[class_lvl] || (pf_vld && !pf_excess && (pf_lvl == class_lvl))) &&
+               !ram_dout_parent_vld) begin
+               excess_push = 1;
+               push_class_index = class_index;
+               state_nxt = STATE_IDLE;
+            end
+            else if(child_ready) begin
                if(!tx_task_q_full) begin
                   tx_task_q_enq_en = 1;
 
@@ -441,24 +1002,27 @@ module nicpic
                   ram_wr_en = 1;
                   ram_din_tokens = tokens_reg;
                   ram_din_timestamp = timestamp_reg;
+                  min_din_tokens = min_tokens_reg;
                   ram_din_dirty = 1;
-                  // move to next class and state
-                  if(class_index >= class_num_minus_1) begin
-                     class_index_nxt = 0;
-                  end
-                  else begin
-                     class_index_nxt = class_index_plus_1;
-                  end
                   state_nxt = STATE_IDLE;
                end
             end
             else begin
-               // move to next class and state
-               if(class_index >= class_num_minus_1) begin
-                  class_index_nxt = 0;
-               end
-               else begin
-                  class_index_nxt = class_index_plus_1;
+               // still backlogged, wait until the tokens are there.
+               // A round robin class keeps its grown deficit and goes to
+               // the back of the ready list. A class without a packet or
+               // rate leaves the scheduler
+               if((pkt_host_addr_reg != 0) && (rate_reg != 0)) begin
+                  push_class_index = class_index;
+                  if(drr_reg && launch_due) begin
+                     ram_wr_en = 1;
+                     ram_din_tokens = tokens_reg;
+                     ready_push = 1;
+                  end
+                  else begin
+                     cal_push = 1;
+                     cal_deficit = wait_deficit;
+                  end
                end
                state_nxt = STATE_IDLE;
             end
@@ -468,10 +1032,19 @@ module nicpic
             feedback_task_q_deq_en = 1;
             ram_addr = class_index_feedback;
             ram_wr_en = 1;
-            ram_din_tokens = tokens_feedback;
+            stats_upd = 1;
+            stats_index = class_index_feedback;
+            stats_bytes = bytes_feedback;
+            stats_pkts = pkts_feedback;
+            // an emptied round robin class loses its deficit
+            if(ram_dout_drr && (pkt_host_addr_pending_feedback == 0)) begin
+               ram_din_tokens = 0;
+            end
+            else begin
+               ram_din_tokens = tokens_feedback;
+            end
             // avoid stalls in consuming doorbells
-            if((pkt_host_addr_feedback == 0) &&
-               (dsc_head_index_feedback != ram_dout_dsc_tail_index)) begin
+            if(feedback_skip_dsc) begin
                ram_din_dsc_head_index = (dsc_head_index_feedback + 1) & 
                                         ram_dout_dsc_buffer_mask[31:6];
             end
@@ -480,13 +1053,54 @@ module nicpic
                ram_din_pkt_host_addr = pkt_host_addr_feedback;
                ram_din_pkt_port = pkt_port_feedback;
                ram_din_pkt_len = pkt_len_feedback;
+               ram_din_pkt_launch = pkt_launch_feedback;
             end
+            min_din_tokens = (min_dout_tokens > min_spent_feedback) ? (min_dout_tokens - min_spent_feedback) : 0;
             ram_din_dirty = 0;
             doorbell_stall_nxt = 0;
+            // requeue while backlogged
+            if((pkt_host_addr_pending_feedback != 0) && (ram_dout_rate != 0) &&
+               !class_queued[class_index_feedback]) begin
+               push_class_index = class_index_feedback;
+               if(wait_deficit_feedback == 0) begin
+                  ready_push = 1;
+               end
+               else begin
+                  cal_push = 1;
+                  cal_deficit = wait_deficit_feedback;
+               end
+            end
+            if(parent_vld_feedback) begin
+               parent_index_reg_nxt = parent_index_feedback;
+               parent_tokens_reg_nxt = parent_tokens_feedback;
+               state_nxt = STATE_FEEDBACK_PARENT_L1;
+            end
+            else begin
+               state_nxt = STATE_IDLE;
+            end
+         end
+
+         STATE_FEEDBACK_PARENT_L1: begin
+            ram_addr = parent_index_reg;
+            state_nxt = STATE_FEEDBACK_PARENT_L2;
+         end
+
+         STATE_FEEDBACK_PARENT_L2: begin
+            ram_addr = parent_index_reg;
+            // refund what the child did not spend, capped on the next read.
+            // A parent that went in flight meanwhile overwrites its tokens
+            // on its own feedback, so the refund is dropped
+            if(!ram_dout_dirty) begin
+               ram_wr_en = 1;
+               ram_din_tokens = ram_dout_tokens + parent_tokens_reg;
+            end
             state_nxt = STATE_IDLE;
          end
 
          STATE_DOORBELL: begin
+            // keep reading the class while the dne queue is full, its row
+            // is the default for the write
+            ram_addr = class_index_doorbell;
 
             case(inst_doorbell)
                DOORBELL_ADD_CLASS: begin
@@ -502,11 +1116,18 @@ module nicpic
                         ram_din_pkt_host_addr        = 0;
                         ram_din_pkt_port             = 0;
                         ram_din_pkt_len              = 0;
+                        ram_din_pkt_launch           = 0;
                         ram_din_rate                 = 0;
                         ram_din_tokens               = 0;
                         ram_din_tokens_max           = 0;
                         ram_din_timestamp            = timecount;
                         ram_din_dirty                = 0;
+                        ram_din_parent_vld           = 0;
+                        ram_din_parent_index         = 0;
+                        ram_din_drr                  = 0;
+                        min_din_fill                 = 0;
+                        min_din_tokens_max           = 0;
+                        min_din_tokens               = 0;
 
                         success_doorbell_dne = 1;
                      end
@@ -527,6 +1148,12 @@ module nicpic
                      ram_addr = class_index_doorbell;
                      ram_wr_en = 1;
                      ram_din_rate = rate_doorbell;
+                     // a class that was held at rate 0 starts again
+                     if(!ram_dout_dirty && (ram_dout_pkt_host_addr != 0) &&
+                        !class_queued[class_index_doorbell]) begin
+                        ready_push = 1;
+                        push_class_index = class_index_doorbell;
+                     end
 
                      inst_doorbell_dne = inst_doorbell;
                      class_index_doorbell_dne = class_index_doorbell;
@@ -554,6 +1181,98 @@ module nicpic
                   end
                end
 
+               DOORBELL_SET_PARAMS: begin
+                  if(!doorbell_dne_q_full) begin
+                     ram_addr = class_index_doorbell;
+                     ram_wr_en = 1;
+                     ram_din_rate = rate_doorbell;
+                     ram_din_tokens_max = {24'b0, tokens_max_params_doorbell};
+                     // a class that was held at rate 0 starts again
+                     if(!ram_dout_dirty && (ram_dout_pkt_host_addr != 0) &&
+                        !class_queued[class_index_doorbell]) begin
+                        ready_push = 1;
+                        push_class_index = class_index_doorbell;
+                     end
+
+                     inst_doorbell_dne = inst_doorbell;
+                     class_index_doorbell_dne = class_index_doorbell;
+                     success_doorbell_dne = 1;
+                     // only the last class of a bulk update tells the host
+                     doorbell_dne_q_enq_en = notify_params_doorbell;
+
+                     doorbell_task_q_deq_en = 1;
+                     state_nxt = STATE_IDLE;
+                  end
+               end
+
+               DOORBELL_SET_PARENT: begin
+                  if(!doorbell_dne_q_full) begin
+                     // a class cannot be its own parent
+                     if(!parent_vld_doorbell || (parent_index_doorbell != class_index_doorbell)) begin
+                        ram_addr = class_index_doorbell;
+                        ram_wr_en = 1;
+                        ram_din_parent_vld = parent_vld_doorbell;
+                        ram_din_parent_index = parent_index_doorbell;
+                        success_doorbell_dne = 1;
+                     end
+                     else begin
+                        success_doorbell_dne = 0;
+                     end
+
+                     inst_doorbell_dne = inst_doorbell;
+                     class_index_doorbell_dne = class_index_doorbell;
+                     doorbell_dne_q_enq_en = 0;
+
+                     doorbell_task_q_deq_en = 1;
+                     state_nxt = STATE_IDLE;
+                  end
+               end
+
+               // switch between token bucket pacing and round robin sharing,
+               // the quantum is set with DOORBELL_SET_PARAMS as tokens_max
+               DOORBELL_SET_DRR: begin
+                  ram_addr = class_index_doorbell;
+                  if(!doorbell_dne_q_full) begin
+                     ram_wr_en = 1;
+                     ram_din_drr = drr_doorbell;
+                     ram_din_tokens = 0;
+                     ram_din_timestamp = timecount;
+                     min_din_tokens = min_tokens_capped;
+                     // a class in flight writes its tokens back on feedback
+                     if(!ram_dout_dirty && (ram_dout_pkt_host_addr != 0) &&
+                        !class_queued[class_index_doorbell]) begin
+                        ready_push = 1;
+                        push_class_index = class_index_doorbell;
+                     end
+
+                     inst_doorbell_dne = inst_doorbell;
+                     class_index_doorbell_dne = class_index_doorbell;
+                     success_doorbell_dne = 1;
+                     doorbell_dne_q_enq_en = 0;
+
+                     doorbell_task_q_deq_en = 1;
+                     state_nxt = STATE_IDLE;
+                  end
+               end
+
+               // committed rate and burst, the peak bucket stays as it is
+               DOORBELL_SET_MIN: begin
+                  if(!doorbell_dne_q_full) begin
+                     ram_addr = class_index_doorbell;
+                     ram_wr_en = 1;
+                     min_din_fill = min_fill_doorbell;
+                     min_din_tokens_max = min_tokens_max_doorbell;
+
+                     inst_doorbell_dne = inst_doorbell;
+                     class_index_doorbell_dne = class_index_doorbell;
+                     success_doorbell_dne = 1;
+                     doorbell_dne_q_enq_en = 0;
+
+                     doorbell_task_q_deq_en = 1;
+                     state_nxt = STATE_IDLE;
+                  end
+               end
+
                DOORBELL_ADD_DSC: begin
                   ram_addr = class_index_doorbell;
                   if(!doorbell_dne_q_full) begin
@@ -563,6 +1282,7 @@ module nicpic
                         ram_din_pkt_host_addr = pkt_host_addr_doorbell;
                         ram_din_pkt_port = pkt_port_doorbell;
                         ram_din_pkt_len = pkt_len_doorbell;
+                        ram_din_pkt_launch = pkt_launch_doorbell;
                      end
                      else begin
                         if(ram_dout_pkt_host_addr != 0) begin
@@ -575,6 +1295,12 @@ module nicpic
                            ram_din_pkt_host_addr = pkt_host_addr_doorbell;
                            ram_din_pkt_port = pkt_port_doorbell;
                            ram_din_pkt_len = pkt_len_doorbell;
+                           ram_din_pkt_launch = pkt_launch_doorbell;
+                        end
+                        // backlogged now, in flight classes are requeued on feedback
+                        if(!class_queued[class_index_doorbell]) begin
+                           ready_push = 1;
+                           push_class_index = class_index_doorbell;
                         end
                      end
 
@@ -604,11 +1330,18 @@ module nicpic
                         ram_din_pkt_host_addr        = 0;
                         ram_din_pkt_port             = 0;
                         ram_din_pkt_len              = 0;
+                        ram_din_pkt_launch           = 0;
                         ram_din_rate                 = 0;
                         ram_din_tokens               = 0;
                         ram_din_tokens_max           = 0;
                         ram_din_timestamp            = 0;
                         ram_din_dirty                = 0;
+                        ram_din_parent_vld           = 0;
+                        ram_din_parent_index         = 0;
+                        ram_din_drr                  = 0;
+                        min_din_fill                 = 0;
+                        min_din_tokens_max           = 0;
+                        min_din_tokens               = 0;
 
                         inst_doorbell_dne = inst_doorbell;
                         class_index_doorbell_dne = class_index_doorbell;
@@ -621,6 +1354,121 @@ module nicpic
                   end
                end
 
+               // hand the class state to the host and free the slot. Its
+               // counters follow in a second entry, DOORBELL_LOAD_CLASS
+               // clears them, the host waits for both before it reloads
+               DOORBELL_EVICT_CLASS: begin
+                  if(ram_dout_dirty) begin
+                     doorbell_stall_nxt = 1;
+                     state_nxt = STATE_IDLE;
+                  end
+                  else begin
+                     ram_addr = class_index_doorbell;
+                     if(!doorbell_dne_q_full) begin
+                        ram_wr_en = 1;
+                        ram_din_dsc_buffer_host_addr = 0;
+                        ram_din_dsc_buffer_mask      = 0;
+                        ram_din_dsc_head_index       = 0;
+                        ram_din_dsc_tail_index       = 0;
+                        ram_din_pkt_host_addr        = 0;
+                        ram_din_pkt_port             = 0;
+                        ram_din_pkt_len              = 0;
+                        ram_din_pkt_launch           = 0;
+                        ram_din_rate                 = 0;
+                        ram_din_tokens               = 0;
+                        ram_din_tokens_max           = 0;
+                        ram_din_timestamp            = 0;
+                        ram_din_dirty                = 0;
+                        ram_din_parent_vld           = 0;
+                        ram_din_parent_index         = 0;
+                        ram_din_drr                  = 0;
+                        min_din_fill                 = 0;
+                        min_din_tokens_max           = 0;
+                        min_din_tokens               = 0;
+
+                        // tokens as of now, the host ages them while the class is out.
+                        // A round robin deficit does not age
+                        spill_tokens_doorbell_dne = ram_dout_drr ? ram_dout_tokens : tokens_capped;
+                        spill_dsc_head_index_doorbell_dne = ram_dout_dsc_head_index;
+                        spill_pending_doorbell_dne = (ram_dout_pkt_host_addr != 0);
+
+                        inst_doorbell_dne = inst_doorbell;
+                        class_index_doorbell_dne = class_index_doorbell;
+                        success_doorbell_dne = 1;
+                        doorbell_dne_q_enq_en = 1;
+
+                        // the class is not in flight, no count is pending
+                        snap_start = 1;
+                        snap_evict_start = 1;
+
+                        doorbell_task_q_deq_en = 1;
+                        state_nxt = STATE_IDLE;
+                     end
+                  end
+               end
+
+               // bind a host class to a free slot, like DOORBELL_ADD_CLASS
+               DOORBELL_LOAD_CLASS: begin
+                  if(!doorbell_dne_q_full) begin
+                     if(class_index_doorbell < class_num) begin
+                        ram_addr = class_index_doorbell;
+                        ram_wr_en = 1;
+                        ram_din_dsc_buffer_host_addr = dsc_buffer_host_addr_doorbell;
+                        ram_din_dsc_buffer_mask      = dsc_buffer_mask_doorbell;
+                        ram_din_dsc_head_index       = 0;
+                        ram_din_dsc_tail_index       = 0;
+                        ram_din_pkt_host_addr        = 0;
+                        ram_din_pkt_port             = 0;
+                        ram_din_pkt_len              = 0;
+                        ram_din_pkt_launch           = 0;
+                        ram_din_rate                 = 0;
+                        ram_din_tokens               = 0;
+                        ram_din_tokens_max           = 0;
+                        ram_din_timestamp            = timecount;
+                        ram_din_dirty                = 0;
+                        ram_din_parent_vld           = 0;
+                        ram_din_parent_index         = 0;
+                        ram_din_drr                  = 0;
+                        min_din_fill                 = 0;
+                        min_din_tokens_max           = 0;
+                        min_din_tokens               = 0;
+
+                        success_doorbell_dne = 1;
+                     end
+                     else begin
+                        success_doorbell_dne = 0;
+                     end
+                     inst_doorbell_dne = inst_doorbell;
+                     class_index_doorbell_dne = class_index_doorbell;
+                     doorbell_dne_q_enq_en = 0;
+
+                     doorbell_task_q_deq_en = 1;
+                     state_nxt = STATE_IDLE;
+                  end
+               end
+
+               // restore tokens and descriptor position, the host then
+               // rings DOORBELL_ADD_DSC for the first outstanding descriptor
+               DOORBELL_LOAD_STATE: begin
+                  if(!doorbell_dne_q_full) begin
+                     ram_addr = class_index_doorbell;
+                     ram_wr_en = 1;
+                     ram_din_tokens = tokens_load_doorbell;
+                     ram_din_timestamp = timecount;
+                     min_din_tokens = 0;
+                     ram_din_dsc_head_index = dsc_head_index_load_doorbell;
+                     ram_din_dsc_tail_index = dsc_head_index_load_doorbell;
+
+                     inst_doorbell_dne = inst_doorbell;
+                     class_index_doorbell_dne = class_index_doorbell;
+                     success_doorbell_dne = 1;
+                     doorbell_dne_q_enq_en = 0;
+
+                     doorbell_task_q_deq_en = 1;
+                     state_nxt = STATE_IDLE;
+                  end
+               end
+
                DOORBELL_DELETE_CLASS: begin
                   if(!doorbell_dne_q_full) begin
                      if(class_num != 0) begin
@@ -640,6 +1488,44 @@ module nicpic
                   end
                end
 
+               // takes effect the next time the class is queued
+               DOORBELL_SET_PRIO: begin
+                  if(!doorbell_dne_q_full) begin
+                     prio_wr_en = 1;
+                     prio_wr_index = class_index_doorbell;
+                     prio_wr_level = prio_doorbell;
+
+                     inst_doorbell_dne = inst_doorbell;
+                     class_index_doorbell_dne = class_index_doorbell;
+                     success_doorbell_dne = 1;
+                     doorbell_dne_q_enq_en = 0;
+
+                     doorbell_task_q_deq_en = 1;
+                     state_nxt = STATE_IDLE;
+                  end
+               end
+
+               DOORBELL_SET_STARVE: begin
+                  if(!doorbell_dne_q_full) begin
+                     starve_wr_en = 1;
+
+                     inst_doorbell_dne = inst_doorbell;
+                     class_index_doorbell_dne = class_index_doorbell;
+                     success_doorbell_dne = 1;
+                     doorbell_dne_q_enq_en = 0;
+
+                     doorbell_task_q_deq_en = 1;
+                     state_nxt = STATE_IDLE;
+                  end
+               end
+
+               // the counters come back on the dne queue, see snap_busy
+               DOORBELL_READ_STATS: begin
+                  snap_start = 1;
+                  doorbell_task_q_deq_en = 1;
+                  state_nxt = STATE_IDLE;
+               end
+
                default: begin
                   if(!doorbell_dne_q_full) begin
                      success_doorbell_dne = 0;
@@ -650,8 +1536,78 @@ module nicpic
                   end
                end
             endcase
+
+            // count the doorbells that change a class, a new one starts from zero
+            if(doorbell_task_q_deq_en && ram_wr_en) begin
+               stats_upd = 1;
+               stats_index = ram_addr;
+               if((inst_doorbell == DOORBELL_ADD_CLASS) || (inst_doorbell == DOORBELL_LOAD_CLASS)) begin
+                  stats_clear = 1;
+                  prio_wr_en = 1;
+                  prio_wr_index = ram_addr;
+                  prio_wr_level = 0;
+               end
+               else begin
+                  stats_doorbell = 1;
+               end
+            end
          end
       endcase
+
+      if(cal_push) begin
+         stats_upd = 1;
+         stats_index = push_class_index;
+         stats_starved = cal_wait;
+      end
+
+      // the next class is evaluated while the last one is written back,
+      // unless its parent has to be read on port a
+      if((state == STATE_TOKENS_L2) && (state_nxt == STATE_IDLE) && pf_vld && !pf_dout_parent_vld &&
+         !doorbell_ready && feedback_task_q_empty) begin
+         sched_go = 1;
+      end
+
+      // evaluate the prefetched class
+      if(sched_go) begin
+         class_index_nxt = pf_index;
+         excess_reg_nxt = pf_excess;
+         if((pf_index >= class_num) || pf_dout_dirty || (pf_dout_pkt_host_addr == 0) || (pf_dout_rate == 0)) begin
+            // deleted, stopped while prefetched, or in flight and requeued
+            // on its feedback
+            state_nxt = STATE_IDLE;
+         end
+         else begin
+            if(pf_dout_drr) begin
+               // one quantum per turn
+               tokens_reg_nxt = pf_dout_tokens + pf_dout_tokens_max;
+            end
+            else if(pf_tokens_nxt < pf_dout_tokens_max) begin
+               tokens_reg_nxt = pf_tokens_nxt;
+            end
+            else begin
+               tokens_reg_nxt = pf_dout_tokens_max;
+            end
+
+            timestamp_reg_nxt = timecount;
+            pkt_host_addr_reg_nxt = pf_dout_pkt_host_addr;
+            pkt_len_reg_nxt = pf_dout_pkt_len;
+            launch_wait_reg_nxt = pf_launch_wait;
+            rate_reg_nxt = pf_dout_rate;
+            drr_reg_nxt = pf_dout_drr;
+            min_tokens_reg_nxt = pf_min_tokens_capped;
+
+            if(pf_dout_parent_vld) begin
+               ram_addr = pf_dout_parent_index;
+               parent_index_reg_nxt = pf_dout_parent_index;
+               state_nxt = STATE_PARENT_L1;
+            end
+            else begin
+               parent_tokens_reg_nxt = 0;
+               parent_rate_reg_nxt = 0;
+               state_nxt = STATE_TOKENS_L2;
+            end
+         end
+      end
    end
 
    always @(posedge clk) begin
@@ -667,9 +1623,16 @@ module nicpic
          //tokens_max_reg <= 0;
          pkt_host_addr_reg <= 0;
          pkt_len_reg <= 0;
+         launch_wait_reg <= 0;
          rate_reg <= 0;
          tokens_reg <= 0;
+         drr_reg <= 0;
+         min_tokens_reg <= 0;
+         excess_reg <= 0;
          //tokens_enough_reg <= 0;
+         parent_index_reg <= 0;
+         parent_tokens_reg <= 0;
+         parent_rate_reg <= 0;
       end
       else begin
          state <= state_nxt;
@@ -683,9 +1646,294 @@ module nicpic
          //tokens_max_reg <= tokens_max_reg_nxt;
          pkt_host_addr_reg <= pkt_host_addr_reg_nxt;
          pkt_len_reg <= pkt_len_reg_nxt;
+         launch_wait_reg <= launch_wait_reg_nxt;
          rate_reg <= rate_reg_nxt;
          tokens_reg <= tokens_reg_nxt;
+         drr_reg <= drr_reg_nxt;
+         min_tokens_reg <= min_tokens_reg_nxt;
+         excess_reg <= excess_reg_nxt;
          //tokens_enough_reg <= tokens_enough_reg_nxt;
+         parent_index_reg <= parent_index_reg_nxt;
+         parent_tokens_reg <= parent_tokens_reg_nxt;
+         parent_rate_reg <= parent_rate_reg_nxt;
+      end
+   end
+
+   // refill the prefetch slot once it is empty or taken this cycle
+   integer pop_i;
+   always @(*) begin
+      ready_pop = 0;
+      excess_pop = 0;
+      ram_addrb = 0;
+      // highest waiting level, unless a lower one has waited too long
+      pop_lvl = 0;
+      for(pop_i = PRIO_LEVELS - 1; pop_i >= 0; pop_i = pop_i - 1) begin
+         if(prio_vld[pop_i]) begin
+            pop_lvl = pop_i;
+         end
+      end
+      if(prio_starved != 0) begin
+         for(pop_i = PRIO_LEVELS - 1; pop_i >= 0; pop_i = pop_i - 1) begin
+            if(prio_starved[pop_i]) begin
+               pop_lvl = pop_i;
+            end
+         end
+      end
+      // a level sends from its excess list once its ready list is empty
+      if((!pf_vld || sched_go) && (prio_vld != 0)) begin
+         if(ready_vld[pop_lvl]) begin
+            ready_pop = 1;
+            ram_addrb = ready_head_pop;
+         end
+         else begin
+            excess_pop = 1;
+            ram_addrb = excess_head_pop;
+         end
+      end
+   end
+
+   always @(posedge clk) begin
+      if(sched_go) begin
+         sched_row <= pf_dout;
+         sched_min_row <= pf_min_dout;
+      end
+
+      if(rst) begin
+         pf_vld <= 0;
+         pf_rd <= 0;
+         pf_index <= 0;
+         pf_excess <= 0;
+      end
+      else if((ready_pop || excess_pop) && !pop_backlog) begin
+         // stale entry, the slot stays free for the next pop
+         pf_vld <= 0;
+         pf_rd <= 0;
+      end
+      else if(ready_pop || excess_pop) begin
+         pf_vld <= 1;
+         pf_index <= pop_class_index;
+         pf_excess <= excess_pop;
+         // port b reads the old row while port a writes it
+         if(ram_wr_en && (ram_addr == pop_class_index)) begin
+            pf_rd <= 0;
+            pf_row <= ram_din;
+            pf_min_row <= min_ram_din;
+         end
+         else begin
+            pf_rd <= 1;
+         end
+      end
+      else begin
+         if(sched_go) begin
+            pf_vld <= 0;
+         end
+         pf_rd <= 0;
+         if(ram_wr_en && (ram_addr == pf_index)) begin
+            pf_row <= ram_din;
+            pf_min_row <= min_ram_din;
+         end
+         else begin
+            pf_row <= pf_dout;
+            pf_min_row <= pf_min_dout;
+         end
+      end
+   end
+
+   integer list_i;
+   always @(posedge clk) begin
+      if(prio_wr_en) begin
+         class_prio[prio_wr_index] <= prio_wr_level;
+      end
+
+      if(rst) begin
+         class_queued <= 0;
+         class_backlog <= 0;
+         for(list_i = 0; list_i < PRIO_LEVELS; list_i = list_i + 1) begin
+            ready_head[list_i] <= 0;
+            ready_tail[list_i] <= 0;
+            excess_head[list_i] <= 0;
+            excess_tail[list_i] <= 0;
+            prio_skip[list_i] <= 0;
+         end
+         ready_vld <= 0;
+         excess_vld <= 0;
+         prio_starve_max <= 0;
+         cal_vld <= 0;
+         cal_ptr <= 0;
+         cal_lvl <= 0;
+         cal_time <= 0;
+      end
+      else begin
+         if(starve_wr_en) begin
+            prio_starve_max <= starve_max_doorbell;
+         end
+
+         // levels passed over while they wait count towards starvation
+         if(ready_pop || excess_pop) begin
+            for(list_i = 0; list_i < PRIO_LEVELS; list_i = list_i + 1) begin
+               if((list_i == pop_lvl) || !prio_vld[list_i]) begin
+                  prio_skip[list_i] <= 0;
+               end
+               else if(prio_skip[list_i] != 16'hffff) begin
+                  prio_skip[list_i] <= prio_skip[list_i] + 1;
+               end
+            end
+         end
+
+         if(sched_go) begin
+            class_queued[pf_index] <= 0;
+         end
+         if((ready_pop || excess_pop) && !pop_backlog) begin
+            class_queued[pop_class_index] <= 0;
+         end
+
+         if(ram_wr_en) begin
+            class_backlog[ram_addr] <= backlog_din;
+         end
+         if((state == STATE_DOORBELL) && (inst_doorbell == DOORBELL_DELETE_CLASS) && doorbell_task_q_deq_en) begin
+            class_backlog[class_num_minus_1] <= 0;
+         end
+
+         if(ready_pop) begin
+            if(ready_head[pop_lvl] == ready_tail[pop_lvl]) begin
+               ready_vld[pop_lvl] <= 0;
+            end
+            else begin
+               ready_head[pop_lvl] <= class_next[ready_head[pop_lvl]];
+            end
+         end
+         else if(excess_pop) begin
+            if(excess_head[pop_lvl] == excess_tail[pop_lvl]) begin
+               excess_vld[pop_lvl] <= 0;
+            end
+            else begin
+               excess_head[pop_lvl] <= class_next[excess_head[pop_lvl]];
+            end
+         end
+
+         // a push lands behind what the pop left
+         if(ready_push) begin
+            class_queued[push_class_index] <= 1;
+            if(ready_left[push_lvl]) begin
+               class_next[ready_tail[push_lvl]] <= push_class_index;
+            end
+            else begin
+               ready_head[push_lvl] <= push_class_index;
+            end
+            ready_tail[push_lvl] <= push_class_index;
+            ready_vld[push_lvl] <= 1;
+         end
+         else if(excess_push) begin
+            class_queued[push_class_index] <= 1;
+            if(excess_left[push_lvl]) begin
+               class_next[excess_tail[push_lvl]] <= push_class_index;
+            end
+            else begin
+               excess_head[push_lvl] <= push_class_index;
+            end
+            excess_tail[push_lvl] <= push_class_index;
+            excess_vld[push_lvl] <= 1;
+         end
+         else if(cal_push) begin
+            class_queued[push_class_index] <= 1;
+            if(cal_vld[cal_push_slot]) begin
+               class_next[cal_tail[cal_push_slot]] <= push_class_index;
+            end
+            else begin
+               cal_head[cal_push_slot] <= push_class_index;
+            end
+            cal_tail[cal_push_slot] <= push_class_index;
+            cal_vld[cal_push_slot] <= 1;
+         end
+         else if(cal_splice) begin
+            // append the whole bucket to the ready list of its level, one
+            // level per cycle
+            if(cal_vld[cal_splice_slot]) begin
+               if(ready_left[cal_lvl]) begin
+                  class_next[ready_tail[cal_lvl]] <= cal_head[cal_splice_slot];
+               end
+               else begin
+                  ready_head[cal_lvl] <= cal_head[cal_splice_slot];
+               end
+               ready_tail[cal_lvl] <= cal_tail[cal_splice_slot];
+               ready_vld[cal_lvl] <= 1;
+               cal_vld[cal_splice_slot] <= 0;
+            end
+            cal_lvl <= cal_lvl + 1;
+            if(cal_lvl == PRIO_LEVELS - 1) begin
+               cal_ptr <= cal_ptr + 1;
+               cal_time <= cal_time + CAL_SLOT_CYCLES;
+            end
+         end
+      end
+   end
+
+   // snapshot reads take the stats ram read port when no update does
+   always @(*) begin
+      stats_raddr = stats_index;
+      snap_issue = 0;
+      if(!stats_upd && snap_busy && !snap_rd && !snap_hold) begin
+         snap_issue = 1;
+         stats_raddr = snap_index;
+      end
+      snap_enq = snap_hold && !doorbell_dne_q_enq_en && !doorbell_dne_q_full;
+   end
+
+   always @(posedge clk) begin
+      stats_ram_dout <= stats_ram[stats_raddr];
+      stats_rd_index <= stats_raddr;
+      if(stats_s1_vld) begin
+         stats_ram[stats_s1_index] <= stats_din;
+      end
+      stats_wr_index <= stats_s1_index;
+      stats_wr_data <= stats_din;
+
+      stats_s1_clear <= stats_clear;
+      stats_s1_index <= stats_index;
+      stats_s1_bytes <= stats_bytes;
+      stats_s1_pkts <= stats_pkts;
+      stats_s1_starved <= stats_starved;
+      stats_s1_doorbell <= stats_doorbell;
+
+      if(snap_rd) begin
+         snap_data <= stats_fwd_dout;
+      end
+
+      if(rst) begin
+         stats_s1_vld <= 0;
+         stats_wr_vld <= 0;
+         snap_busy <= 0;
+         snap_rd <= 0;
+         snap_hold <= 0;
+         snap_index <= 0;
+         snap_last <= 0;
+         snap_evict <= 0;
+         snap_seq <= 0;
+      end
+      else begin
+         stats_s1_vld <= stats_upd;
+         stats_wr_vld <= stats_s1_vld;
+         snap_rd <= snap_issue;
+         if(snap_start) begin
+            snap_busy <= 1;
+            snap_index <= class_index_doorbell;
+            snap_last <= snap_evict_start ? class_index_doorbell :
+                         snap_last_doorbell[10] ? 10'd1023 : snap_last_doorbell[9:0];
+            snap_evict <= snap_evict_start;
+            snap_seq <= snap_evict_start ? 6'd0 : stats_seq_doorbell;
+         end
+         else if(snap_rd) begin
+            snap_hold <= 1;
+         end
+         else if(snap_enq) begin
+            snap_hold <= 0;
+            if(snap_index == snap_last) begin
+               snap_busy <= 0;
+            end
+            else begin
+               snap_index <= snap_index + 1;
+            end
+         end
       end
    end
 
@@ -1,180 +1,82 @@
 /*******************************************************************************
-*     This file is owned and controlled by Xilinx and must be used solely      *
-*     for design, simulation, implementation and creation of design files      *
-*     limited to Xilinx devices or technologies. Use with non-Xilinx           *
-*     devices or technologies is expressly prohibited and immediately          *
-*     terminates your license.                                                 *
-*                                                                              *
-*     XILINX IS PROVIDING THIS DESIGN, CODE, OR INFORMATION "AS IS" SOLELY     *
-*     FOR USE IN DEVELOPING PROGRAMS AND SOLUTIONS FOR XILINX DEVICES.  BY     *
-*     PROVIDING THIS DESIGN, CODE, OR INFORMATION AS ONE POSSIBLE              *
-*     IMPLEMENTATION OF THIS FEATURE, APPLICATION OR STANDARD, XILINX IS       *
-*     MAKING NO REPRESENTATION THAT THIS IMPLEMENTATION IS FREE FROM ANY       *
-*     CLAIMS OF INFRINGEMENT, AND YOU ARE RESPONSIBLE FOR OBTAINING ANY        *
-*     RIGHTS YOU MAY REQUIRE FOR YOUR IMPLEMENTATION.  XILINX EXPRESSLY        *
-*     DISCLAIMS ANY WARRANTY WHATSOEVER WITH RESPECT TO THE ADEQUACY OF THE    *
-*     IMPLEMENTATION, INCLUDING BUT NOT LIMITED TO ANY WARRANTIES OR           *
-*     REPRESENTATIONS THAT THIS IMPLEMENTATION IS FREE FROM CLAIMS OF          *
-*     INFRINGEMENT, IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A    *
-*     PARTICULAR PURPOSE.                                                      *
-*                                                                              *
-*     Xilinx products are not intended for use in life support appliances,     *
-*     devices, or systems.  Use in such applications are expressly             *
-*     prohibited.                                                              *
-*                                                                              *
-*     (c) Copyright 1995-2013 Xilinx, Inc.                                     *
-*     All rights reserved.                                                     *
-*******************************************************************************/
-// You must compile the wrapper file nicpic_ram.v when simulating
-// the core, nicpic_ram. When compiling the wrapper file, be sure to
-// reference the XilinxCoreLib Verilog simulation library. For detailed
-// instructions, please refer to the "CORE Generator Help".
-
-// The synthesis directives "translate_off/translate_on" specified below are
-// supported by Xilinx, Mentor Graphics and Synplicity synthesis
-// tools. Ensure they are correct for your synthesis tool(s).
+ *
+ *  NetFPGA-10G http://www.netfpga.org
+ *
+ *  File:
+ *        nicpic_ram.v
+ *
+ *  Library:
+ *        hw/contrib/pcores/nicpic_dma_v1_00_a
+ *
+ *  Module:
+ *        nicpic_ram
+ *
+ *  Author:
+ *        Yilong Geng
+ *
+ *  Description:
+ *        Class ram of the nicpic scheduler, one row per class. Port a is
+ *        read and written by the state machine and is write first, port b
+ *        only reads for the scheduler prefetch. A port b read of the row
+ *        port a writes in the same cycle returns the old row.
+ *
+ *  Copyright notice:
+ *        Copyright (C) 2010, 2011 The Board of Trustees of The Leland Stanford
+ *                                 Junior University
+ *
+ *  Licence:
+ *        This file is part of the NetFPGA 10G development base package.
+ *
+ *        This file is free code: you can redistribute it and/or modify it under
+ *        the terms of the GNU Lesser General Public License version 2.1 as
+ *        published by the Free Software Foundation.
+ *
+ *        This package is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *        Lesser General Public License for more details.
+ *
+ *        You should have received a copy of the GNU Lesser General Public
+ *        License along with the NetFPGA source package.  If not, see
+ *        http://www.gnu.org/licenses/.
+ *
+ */
 
 `timescale 1ns/1ps
 
-module nicpic_ram(
-  clka,
-  rsta,
-  wea,
-  addra,
-  dina,
-  douta
-);
+module nicpic_ram
+   (
+   input                   clk,
+
+   input                   wea,
+   input  [9:0]            addra,
+   input  [545:0]          dina,
+   output reg [545:0]      douta,
+
+   input  [9:0]            addrb,
+   output reg [545:0]      doutb
+   );
 
-input clka;
-input rsta;
-input [0 : 0] wea;
-input [8 : 0] addra;
-input [511 : 0] dina;
-output [511 : 0] douta;
+   reg [545:0] ram [0:1023];
 
-// synthesis translate_off
+   integer i;
+   initial begin
+      for(i = 0; i < 1024; i = i + 1)
+         ram[i] = 0;
+   end
 
-  BLK_MEM_GEN_V6_3 #(
-    .C_ADDRA_WIDTH(9),
-    .C_ADDRB_WIDTH(9),
-    .C_ALGORITHM(1),
-    .C_AXI_ID_WIDTH(4),
-    .C_AXI_SLAVE_TYPE(0),
-    .C_AXI_TYPE(1),
-    .C_BYTE_SIZE(9),
-    .C_COMMON_CLK(0),
-    .C_DEFAULT_DATA("0"),
-    .C_DISABLE_WARN_BHV_COLL(0),
-    .C_DISABLE_WARN_BHV_RANGE(0),
-    .C_ENABLE_32BIT_ADDRESS(0),
-    .C_FAMILY("virtex5"),
-    .C_HAS_AXI_ID(0),
-    .C_HAS_ENA(0),
-    .C_HAS_ENB(0),
-    .C_HAS_INJECTERR(0),
-    .C_HAS_MEM_OUTPUT_REGS_A(0),
-    .C_HAS_MEM_OUTPUT_REGS_B(0),
-    .C_HAS_MUX_OUTPUT_REGS_A(0),
-    .C_HAS_MUX_OUTPUT_REGS_B(0),
-    .C_HAS_REGCEA(0),
-    .C_HAS_REGCEB(0),
-    .C_HAS_RSTA(1),
-    .C_HAS_RSTB(0),
-    .C_HAS_SOFTECC_INPUT_REGS_A(0),
-    .C_HAS_SOFTECC_OUTPUT_REGS_B(0),
-    .C_INIT_FILE_NAME("no_coe_file_loaded"),
-    .C_INITA_VAL("0"),
-    .C_INITB_VAL("0"),
-    .C_INTERFACE_TYPE(0),
-    .C_LOAD_INIT_FILE(0),
-    .C_MEM_TYPE(0),
-    .C_MUX_PIPELINE_STAGES(0),
-    .C_PRIM_TYPE(1),
-    .C_READ_DEPTH_A(512),
-    .C_READ_DEPTH_B(512),
-    .C_READ_WIDTH_A(512),
-    .C_READ_WIDTH_B(512),
-    .C_RST_PRIORITY_A("CE"),
-    .C_RST_PRIORITY_B("CE"),
-    .C_RST_TYPE("SYNC"),
-    .C_RSTRAM_A(0),
-    .C_RSTRAM_B(0),
-    .C_SIM_COLLISION_CHECK("ALL"),
-    .C_USE_BYTE_WEA(0),
-    .C_USE_BYTE_WEB(0),
-    .C_USE_DEFAULT_DATA(0),
-    .C_USE_ECC(0),
-    .C_USE_SOFTECC(0),
-    .C_WEA_WIDTH(1),
-    .C_WEB_WIDTH(1),
-    .C_WRITE_DEPTH_A(512),
-    .C_WRITE_DEPTH_B(512),
-    .C_WRITE_MODE_A("READ_FIRST"),
-    .C_WRITE_MODE_B("WRITE_FIRST"),
-    .C_WRITE_WIDTH_A(512),
-    .C_WRITE_WIDTH_B(512),
-    .C_XDEVICEFAMILY("virtex5")
-  )
-  inst (
-    .CLKA(clka),
-    .RSTA(rsta),
-    .WEA(wea),
-    .ADDRA(addra),
-    .DINA(dina),
-    .DOUTA(douta),
-    .ENA(),
-    .REGCEA(),
-    .CLKB(),
-    .RSTB(),
-    .ENB(),
-    .REGCEB(),
-    .WEB(),
-    .ADDRB(),
-    .DINB(),
-    .DOUTB(),
-    .INJECTSBITERR(),
-    .INJECTDBITERR(),
-    .SBITERR(),
-    .DBITERR(),
-    .RDADDRECC(),
-    .S_ACLK(),
-    .S_ARESETN(),
-    .S_AXI_AWID(),
-    .S_AXI_AWADDR(),
-    .S_AXI_AWLEN(),
-    .S_AXI_AWSIZE(),
-    .S_AXI_AWBURST(),
-    .S_AXI_AWVALID(),
-    .S_AXI_AWREADY(),
-    .S_AXI_WDATA(),
-    .S_AXI_WSTRB(),
-    .S_AXI_WLAST(),
-    .S_AXI_WVALID(),
-    .S_AXI_WREADY(),
-    .S_AXI_BID(),
-    .S_AXI_BRESP(),
-    .S_AXI_BVALID(),
-    .S_AXI_BREADY(),
-    .S_AXI_ARID(),
-    .S_AXI_ARADDR(),
-    .S_AXI_ARLEN(),
-    .S_AXI_ARSIZE(),
-    .S_AXI_ARBURST(),
-    .S_AXI_ARVALID(),
-    .S_AXI_ARREADY(),
-    .S_AXI_RID(),
-    .S_AXI_RDATA(),
-    .S_AXI_RRESP(),
-    .S_AXI_RLAST(),
-    .S_AXI_RVALID(),
-    .S_AXI_RREADY(),
-    .S_AXI_INJECTSBITERR(),
-    .S_AXI_INJECTDBITERR(),
-    .S_AXI_SBITERR(),
-    .S_AXI_DBITERR(),
-    .S_AXI_RDADDRECC()
-  );
+   always @(posedge clk) begin
+      if(wea) begin
+         ram[addra] <= dina;
+         douta <= dina;
+      end
+      else begin
+         douta <= ram[addra];
+      end
+   end
 
-// synthesis translate_on
+   always @(posedge clk) begin
+      doutb <= ram[addrb];
+   end
 
 endmodule
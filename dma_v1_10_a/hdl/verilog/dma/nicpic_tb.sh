@@ -0,0 +1,7 @@
+
+cd $(dirname $0)
+rm -rf unittest_build
+mkdir  unittest_build
+cd     unittest_build
+fuse -incremental -prj ../nicpic_tb.prj -o nicpic_tb.exe testbench
+./nicpic_tb.exe -tclbatch ../nicpic_tb.tcl
@@ -0,0 +1,44 @@
+################################################################################
+#
+#  NetFPGA-10G http://www.netfpga.org
+#
+#  File:
+#        nicpic_tb.tcl
+#
+#  Library:
+#        hw/contrib/pcores/nicpic_dma_v1_00_a
+#
+#  Module:
+#        nicpic_tb.tcl
+#
+#  Author:
+#        Yilong Geng
+#
+#  Description:
+#        Runs the nicpic rate sweep, the testbench prints the achieved
+#        rate of each class and Test Passed or Test Failed
+#
+#  Copyright notice:
+#        Copyright (C) 2010, 2011 The Board of Trustees of The Leland Stanford
+#                                 Junior University
+#
+#  Licence:
+#        This file is part of the NetFPGA 10G development base package.
+#
+#        This file is free code: you can redistribute it and/or modify it under
+#        the terms of the GNU Lesser General Public License version 2.1 as
+#        published by the Free Software Foundation.
+#
+#        This package is distributed in the hope that it will be useful, but
+#        WITHOUT ANY WARRANTY; without even the implied warranty of
+#        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+#        Lesser General Public License for more details.
+#
+#        You should have received a copy of the GNU Lesser General Public
+#        License along with the NetFPGA source package.  If not, see
+#        http://www.gnu.org/licenses/.
+#
+#
+
+run 11 ms
+quit
@@ -0,0 +1,594 @@
+/*******************************************************************************
+ *
+ *  NetFPGA-10G http://www.netfpga.org
+ *
+ *  File:
+ *        nicpic_tb.v
+ *
+ *  Library:
+ *        hw/contrib/pcores/nicpic_dma_v1_00_a
+ *
+ *  Module:
+ *        testbench
+ *
+ *  Author:
+ *        Yilong Geng
+ *
+ *  Description:
+ *        Rate sweep of the nicpic token buckets. One class per rate from
+ *        1 Mbps to 10 Gbps plus a jumbo frame class stay backlogged, a
+ *        model of tx_ctrl sends what the tokens allow and hands feedback
+ *        back later. Achieved and configured rates are compared per class,
+ *        then the tx model stops and the per class counters read back with
+ *        DOORBELL_READ_STATS are checked against what it sent. One more
+ *        class has a launch time on its first packet and must not be
+ *        dispatched before it. A second nicpic puts PRIO_CLASSES classes
+ *        on a link that takes one batch at a time, one at level 0 and the
+ *        rest at level 3, and the level 0 class must take the link.
+ *        The priority part has not been run yet; there is no run log
+ *        to show that it passes.
+ *
+ *  Copyright notice:
+ *        Copyright (C) 2010, 2011 The Board of Trustees of The Leland Stanford
+ *                                 Junior University
+ *
+ *  Licence:
+ *        This file is part of the NetFPGA 10G development base package.
+ *
+ *        This file is free code: you can redistribute it and/or modify it under
+ *        the terms of the GNU Lesser General Public License version 2.1 as
+ *        published by the Free Software Foundation.
+ *
+ *        This package is distributed in the hope that it will be useful, but
+ *        WITHOUT ANY WARRANTY; without even the implied warranty of
+ *        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *        Lesser General Public License for more details.
+ *
+ *        You should have received a copy of the GNU Lesser General Public
+ *        License along with the NetFPGA source package.  If not, see
+ *        http://www.gnu.org/licenses/.
+ *
+ */
+
+`timescale 1 ns / 1ps
+module testbench();
+
+    localparam CLASSES = 8;
+    localparam CLK_HZ = 160000000.0;
+    localparam FEEDBACK_DELAY = 100;    // cycles a batch spends in the tx engine
+    localparam RUN_CYCLES = 1600000;    // 10 ms
+    localparam ERROR_MAX = 0.01;
+
+    localparam [5:0] DOORBELL_ADD_CLASS = 1;
+    localparam [5:0] DOORBELL_ADD_DSC = 4;
+    localparam [5:0] DOORBELL_SET_PARAMS = 7;
+    localparam [5:0] DOORBELL_READ_STATS = 15;
+    localparam [9:0] STATS_LAST = CLASSES - 1;
+    localparam DRAIN_CYCLES = 2000;
+    localparam BURST_PKTS = 4;
+    localparam EDT_CLASS = CLASSES;     // the class with a launch time
+    localparam [31:0] EDT_LAUNCH = 100000;
+    localparam EDT_SLACK = 1024;        // calendar buckets fire at 256 cycle steps
+    localparam [5:0] DOORBELL_SET_PRIO = 16;
+    localparam PRIO_CLASSES = 33;
+    localparam PRIO_HI = PRIO_CLASSES - 1;  // the level 0 class
+    localparam [15:0] PRIO_LEN = 1500;
+    localparam PRIO_BYTES_PER_CYCLE = 8;    // about 10 Gbps
+    localparam PRIO_SHARE_MIN = 2;          // level 0 against the level 3 average
+
+    reg clk, reset;
+
+    // class setup
+    real     bps_cfg [0:CLASSES];
+    reg [15:0] len_cfg [0:CLASSES];
+    reg [23:0] rate_cfg [0:CLASSES];
+
+    // nicpic ports
+    wire         tx_task_q_deq_en;
+    wire [513:0] tx_task_q_data;
+    wire         tx_task_q_empty;
+    reg          doorbell_task_q_enq_en;
+    reg [191:0]  doorbell_task_q_data;
+    wire         doorbell_task_q_full;
+    wire         doorbell_dne_q_empty;
+    wire [287:0] doorbell_dne_q_deq_data;
+    reg          feedback_task_q_enq_en;
+    reg [351:0]  feedback_task_q_enq_data;
+    wire         feedback_task_q_full;
+
+    wire         task_parent_vld;
+    wire [9:0]   task_parent_index;
+    wire [63:0]  task_parent_tokens;
+    wire [23:0]  task_parent_rate;
+    wire [9:0]   task_class_index;
+    wire [63:0]  task_tokens;
+    wire [63:0]  task_rate;
+    wire [63:0]  task_dsc_buffer_host_addr;
+    wire [31:0]  task_dsc_buffer_mask;
+    wire [25:0]  task_dsc_head_index;
+    wire [25:0]  task_dsc_tail_index;
+    wire [63:0]  task_pkt_host_addr;
+    wire [15:0]  task_pkt_len;
+    wire [15:0]  task_pkt_port;
+    wire [32:0]  task_pkt_launch;
+    assign {task_parent_vld,
+            task_parent_index,
+            task_parent_tokens,
+            task_parent_rate,
+            task_class_index,
+            task_tokens,
+            task_rate,
+            task_dsc_buffer_host_addr,
+            task_dsc_buffer_mask,
+            task_dsc_head_index,
+            task_dsc_tail_index,
+            task_pkt_host_addr,
+            task_pkt_len,
+            task_pkt_port,
+            task_pkt_launch} = tx_task_q_data;
+
+    // the tx model stops sending before the counters are read, tasks
+    // still come back as feedback so nothing is left in flight
+    reg stopped;
+    assign tx_task_q_deq_en = !tx_task_q_empty;
+
+    reg [31:0] cycle;
+    integer i, j, c, n;
+
+    // doorbells: add, set params and give one endless descriptor ring per class
+    reg [7:0] doorbell_count;
+    reg stats_go;                   // then one DOORBELL_READ_STATS for all classes
+    wire [3:0] doorbell_class = doorbell_count / 3;
+    wire [63:0] doorbell_burst = BURST_PKTS * len_cfg[doorbell_class] * rate_cfg[doorbell_class];
+    wire [32:0] doorbell_launch = (doorbell_class == EDT_CLASS) ? {1'b1, EDT_LAUNCH} : 33'b0;
+
+    always @(posedge clk) begin
+       doorbell_task_q_enq_en <= 0;
+       if(reset) begin
+          doorbell_count <= 0;
+       end
+       else if(!doorbell_task_q_full && !doorbell_task_q_enq_en && stats_go) begin
+          doorbell_task_q_enq_en <= 1;
+          doorbell_task_q_data <= {102'b0, STATS_LAST, 10'd0, DOORBELL_READ_STATS};
+       end
+       else if(!doorbell_task_q_full && !doorbell_task_q_enq_en && doorbell_count < 3 * (CLASSES + 1)) begin
+          doorbell_task_q_enq_en <= 1;
+          doorbell_count <= doorbell_count + 1;
+          case(doorbell_count % 3)
+             0: doorbell_task_q_data <= {64'h100000 + (doorbell_class << 12), 32'hffffffff,
+                                         16'b0, 6'b0, doorbell_class, DOORBELL_ADD_CLASS};
+             1: doorbell_task_q_data <= {40'b0, rate_cfg[doorbell_class],
+                                         doorbell_burst[39:0], 8'b0, 6'b0, doorbell_class,
+                                         DOORBELL_SET_PARAMS};
+             2: doorbell_task_q_data <= {31'b0, doorbell_launch,
+                                         64'h200000 + (doorbell_class << 12), 26'h3ffffff, 2'b0, 4'b1,
+                                         len_cfg[doorbell_class], 6'b0, doorbell_class,
+                                         DOORBELL_ADD_DSC};
+          endcase
+       end
+    end
+
+    // tx_ctrl: send packets while the tokens last, report after a while
+    reg [63:0] tokens_left;
+    reg [63:0] cost;
+    reg        fb_pending [0:CLASSES];
+    reg [31:0] fb_due [0:CLASSES];
+    reg [63:0] fb_tokens [0:CLASSES];
+    reg [25:0] fb_head [0:CLASSES];
+    reg [63:0] fb_pkt_host_addr [0:CLASSES];
+    reg [15:0] fb_pkt_port [0:CLASSES];
+    reg [15:0] fb_pkt_len [0:CLASSES];
+    reg [31:0] fb_bytes [0:CLASSES];
+    reg [15:0] fb_pkts [0:CLASSES];
+
+    reg [31:0] first_cycle [0:CLASSES];
+    reg [31:0] last_cycle [0:CLASSES];
+    reg [63:0] bytes_sent [0:CLASSES];
+    reg [31:0] batches [0:CLASSES];
+    reg [63:0] bytes_total [0:CLASSES];
+    reg [63:0] pkts_total [0:CLASSES];
+
+    always @(posedge clk) begin
+       if(reset) begin
+          cycle <= 0;
+          for(i = 0; i <= CLASSES; i = i + 1) begin
+             fb_pending[i] <= 0;
+             batches[i] <= 0;
+             bytes_sent[i] <= 0;
+             bytes_total[i] <= 0;
+             pkts_total[i] <= 0;
+          end
+       end
+       else begin
+          cycle <= cycle + 1;
+          if(!tx_task_q_empty) begin
+             c = task_class_index;
+             cost = task_pkt_len * task_rate[23:0];
+             tokens_left = task_tokens;
+             n = 0;
+             while(!stopped && tokens_left >= cost && n < 64) begin
+                tokens_left = tokens_left - cost;
+                n = n + 1;
+             end
+             if(n == 0 && !stopped) begin
+                $display("%t class %0d dispatched without tokens", $time, c);
+             end
+             // the first batch may spend tokens from before the class
+             // was set up, measure from it on
+             if(batches[c] == 0) begin
+                first_cycle[c] <= cycle;
+             end
+             else begin
+                bytes_sent[c] <= bytes_sent[c] + n * task_pkt_len;
+             end
+             last_cycle[c] <= cycle;
+             batches[c] <= batches[c] + 1;
+             bytes_total[c] <= bytes_total[c] + n * task_pkt_len;
+             pkts_total[c] <= pkts_total[c] + n;
+
+             fb_pending[c] <= 1;
+             fb_due[c] <= cycle + FEEDBACK_DELAY;
+             fb_tokens[c] <= tokens_left;
+             fb_head[c] <= task_dsc_head_index + n;
+             fb_pkt_host_addr[c] <= task_pkt_host_addr;
+             fb_pkt_port[c] <= task_pkt_port;
+             fb_pkt_len[c] <= task_pkt_len;
+             fb_bytes[c] <= n * task_pkt_len;
+             fb_pkts[c] <= n;
+          end
+       end
+    end
+
+    // one feedback per cycle, the next packet stays pending so the class is backlogged
+    reg fb_found;
+    always @(posedge clk) begin
+       feedback_task_q_enq_en <= 0;
+       fb_found = 0;
+       if(!reset && !feedback_task_q_full && !feedback_task_q_enq_en) begin
+          for(j = 0; j <= CLASSES; j = j + 1) begin
+             if(!fb_found && fb_pending[j] && (fb_due[j] <= cycle)) begin
+                fb_found = 1;
+                fb_pending[j] <= 0;
+                feedback_task_q_enq_en <= 1;
+                feedback_task_q_enq_data <= {fb_bytes[j],
+                                             fb_pkts[j],
+                                             1'b0, 10'b0, 64'b0,
+                                             j[9:0],
+                                             fb_tokens[j],
+                                             fb_head[j],
+                                             fb_pkt_host_addr[j],
+                                             fb_pkt_port[j],
+                                             fb_pkt_len[j],
+                                             33'b0};
+             end
+          end
+       end
+    end
+
+    // counters coming back from DOORBELL_READ_STATS
+    reg [63:0] stats_bytes [0:CLASSES-1];
+    reg [63:0] stats_pkts [0:CLASSES-1];
+    reg [63:0] stats_starved [0:CLASSES-1];
+    reg [63:0] stats_doorbells [0:CLASSES-1];
+    reg [31:0] stats_num;
+    wire [5:0] dne_inst = doorbell_dne_q_deq_data[21:16];
+    wire [9:0] dne_class = doorbell_dne_q_deq_data[31:22];
+
+    always @(posedge clk) begin
+       if(reset) begin
+          stats_num <= 0;
+       end
+       else if(!doorbell_dne_q_empty && (dne_inst == DOORBELL_READ_STATS) && (dne_class < CLASSES)) begin
+          stats_bytes[dne_class] <= doorbell_dne_q_deq_data[95:32];
+          stats_pkts[dne_class] <= doorbell_dne_q_deq_data[159:96];
+          stats_starved[dne_class] <= doorbell_dne_q_deq_data[223:160];
+          stats_doorbells[dne_class] <= doorbell_dne_q_deq_data[287:224];
+          stats_num <= stats_num + 1;
+       end
+    end
+
+    // strict priority. Every class may send 10 Gbps, more than the link
+    // takes in total, with a burst of one packet. The tx_task_q in front of
+    // the link is FIFO, so what the level 0 class gets over its fair share
+    // is down to the order nicpic dispatches in
+    // Not run yet: neither the checks below nor the starvation bound
+    // they assume have been seen to pass in simulation
+    reg [23:0]   prio_rate;
+    wire         prio_tx_task_q_deq_en;
+    wire [513:0] prio_tx_task_q_data;
+    wire         prio_tx_task_q_empty;
+    reg          prio_doorbell_task_q_enq_en;
+    reg [191:0]  prio_doorbell_task_q_data;
+    wire         prio_doorbell_task_q_full;
+    wire         prio_doorbell_dne_q_empty;
+    wire [287:0] prio_doorbell_dne_q_deq_data;
+    reg          prio_feedback_task_q_enq_en;
+    reg [351:0]  prio_feedback_task_q_enq_data;
+    wire         prio_feedback_task_q_full;
+
+    wire         prio_task_parent_vld;
+    wire [9:0]   prio_task_parent_index;
+    wire [63:0]  prio_task_parent_tokens;
+    wire [23:0]  prio_task_parent_rate;
+    wire [9:0]   prio_task_class_index;
+    wire [63:0]  prio_task_tokens;
+    wire [63:0]  prio_task_rate;
+    wire [63:0]  prio_task_dsc_buffer_host_addr;
+    wire [31:0]  prio_task_dsc_buffer_mask;
+    wire [25:0]  prio_task_dsc_head_index;
+    wire [25:0]  prio_task_dsc_tail_index;
+    wire [63:0]  prio_task_pkt_host_addr;
+    wire [15:0]  prio_task_pkt_len;
+    wire [15:0]  prio_task_pkt_port;
+    wire [32:0]  prio_task_pkt_launch;
+    assign {prio_task_parent_vld,
+            prio_task_parent_index,
+            prio_task_parent_tokens,
+            prio_task_parent_rate,
+            prio_task_class_index,
+            prio_task_tokens,
+            prio_task_rate,
+            prio_task_dsc_buffer_host_addr,
+            prio_task_dsc_buffer_mask,
+            prio_task_dsc_head_index,
+            prio_task_dsc_tail_index,
+            prio_task_pkt_host_addr,
+            prio_task_pkt_len,
+            prio_task_pkt_port,
+            prio_task_pkt_launch} = prio_tx_task_q_data;
+
+    // doorbells: add, set the level, set params and give a descriptor ring
+    reg [7:0] prio_db_count;
+    wire [9:0] prio_db_class = prio_db_count / 4;
+    wire [1:0] prio_db_level = (prio_db_class == PRIO_HI) ? 2'd0 : 2'd3;
+    wire [63:0] prio_db_burst = PRIO_LEN * prio_rate;
+
+    always @(posedge clk) begin
+       prio_doorbell_task_q_enq_en <= 0;
+       if(reset) begin
+          prio_db_count <= 0;
+       end
+       else if(!prio_doorbell_task_q_full && !prio_doorbell_task_q_enq_en &&
+               prio_db_count < 4 * PRIO_CLASSES) begin
+          prio_doorbell_task_q_enq_en <= 1;
+          prio_db_count <= prio_db_count + 1;
+          case(prio_db_count % 4)
+             0: prio_doorbell_task_q_data <= {64'h100000 + (prio_db_class << 12), 32'hffffffff,
+                                              16'b0, prio_db_class, DOORBELL_ADD_CLASS};
+             1: prio_doorbell_task_q_data <= {174'b0, prio_db_level, prio_db_class, DOORBELL_SET_PRIO};
+             2: prio_doorbell_task_q_data <= {40'b0, prio_rate, prio_db_burst[39:0], 8'b0,
+                                              prio_db_class, DOORBELL_SET_PARAMS};
+             3: prio_doorbell_task_q_data <= {64'b0, 64'h200000 + (prio_db_class << 12),
+                                              26'h3ffffff, 2'b0, 4'b1, PRIO_LEN,
+                                              prio_db_class, DOORBELL_ADD_DSC};
+          endcase
+       end
+    end
+
+    // the link takes the next batch once the last one is on the wire
+    reg [31:0] prio_link_busy;
+    assign prio_tx_task_q_deq_en = !prio_tx_task_q_empty && (prio_link_busy == 0);
+
+    reg [63:0] prio_tokens_left;
+    reg [63:0] prio_cost;
+    integer    prio_c, prio_n;
+    reg        prio_fb_pending [0:PRIO_CLASSES-1];
+    reg [31:0] prio_fb_due [0:PRIO_CLASSES-1];
+    reg [63:0] prio_fb_tokens [0:PRIO_CLASSES-1];
+    reg [25:0] prio_fb_head [0:PRIO_CLASSES-1];
+    reg [63:0] prio_fb_pkt_host_addr [0:PRIO_CLASSES-1];
+    reg [15:0] prio_fb_pkt_port [0:PRIO_CLASSES-1];
+    reg [15:0] prio_fb_pkt_len [0:PRIO_CLASSES-1];
+    reg [31:0] prio_fb_bytes [0:PRIO_CLASSES-1];
+    reg [15:0] prio_fb_pkts [0:PRIO_CLASSES-1];
+    reg [63:0] prio_pkts [0:PRIO_CLASSES-1];
+
+    always @(posedge clk) begin
+       if(reset) begin
+          prio_link_busy <= 0;
+          for(i = 0; i < PRIO_CLASSES; i = i + 1) begin
+             prio_fb_pending[i] <= 0;
+             prio_pkts[i] <= 0;
+          end
+       end
+       else if(prio_tx_task_q_deq_en) begin
+          prio_c = prio_task_class_index;
+          prio_cost = prio_task_pkt_len * prio_task_rate[23:0];
+          prio_tokens_left = prio_task_tokens;
+          prio_n = 0;
+          while(prio_tokens_left >= prio_cost && prio_n < 64) begin
+             prio_tokens_left = prio_tokens_left - prio_cost;
+             prio_n = prio_n + 1;
+          end
+          prio_link_busy <= prio_n * prio_task_pkt_len / PRIO_BYTES_PER_CYCLE;
+          prio_pkts[prio_c] <= prio_pkts[prio_c] + prio_n;
+
+          prio_fb_pending[prio_c] <= 1;
+          prio_fb_due[prio_c] <= cycle + prio_n * prio_task_pkt_len / PRIO_BYTES_PER_CYCLE + FEEDBACK_DELAY;
+          prio_fb_tokens[prio_c] <= prio_tokens_left;
+          prio_fb_head[prio_c] <= prio_task_dsc_head_index + prio_n;
+          prio_fb_pkt_host_addr[prio_c] <= prio_task_pkt_host_addr;
+          prio_fb_pkt_port[prio_c] <= prio_task_pkt_port;
+          prio_fb_pkt_len[prio_c] <= prio_task_pkt_len;
+          prio_fb_bytes[prio_c] <= prio_n * prio_task_pkt_len;
+          prio_fb_pkts[prio_c] <= prio_n;
+       end
+       else if(prio_link_busy != 0) begin
+          prio_link_busy <= prio_link_busy - 1;
+       end
+    end
+
+    reg prio_fb_found;
+    always @(posedge clk) begin
+       prio_feedback_task_q_enq_en <= 0;
+       prio_fb_found = 0;
+       if(!reset && !prio_feedback_task_q_full && !prio_feedback_task_q_enq_en) begin
+          for(j = 0; j < PRIO_CLASSES; j = j + 1) begin
+             if(!prio_fb_found && prio_fb_pending[j] && (prio_fb_due[j] <= cycle)) begin
+                prio_fb_found = 1;
+                prio_fb_pending[j] <= 0;
+                prio_feedback_task_q_enq_en <= 1;
+                prio_feedback_task_q_enq_data <= {prio_fb_bytes[j],
+                                                  prio_fb_pkts[j],
+                                                  1'b0, 10'b0, 64'b0,
+                                                  j[9:0],
+                                                  prio_fb_tokens[j],
+                                                  prio_fb_head[j],
+                                                  prio_fb_pkt_host_addr[j],
+                                                  prio_fb_pkt_port[j],
+                                                  prio_fb_pkt_len[j],
+                                                  33'b0};
+             end
+          end
+       end
+    end
+
+    // rate in bits per second to a 24 bit cost per byte, 4096 tokens per cycle
+    function [23:0] rate_from_bps;
+       input real bps;
+       begin
+          rate_from_bps = $rtoi(32768.0 * CLK_HZ / bps + 0.5);
+       end
+    endfunction
+
+    real achieved, error, error_abs;
+    real prio_lo_avg;
+    reg failed;
+
+    initial begin
+       clk = 0;
+       reset = 1;
+
+       bps_cfg[0] = 1.0e6;    len_cfg[0] = 64;
+       bps_cfg[1] = 10.0e6;   len_cfg[1] = 64;
+       bps_cfg[2] = 100.0e6;  len_cfg[2] = 1500;
+       bps_cfg[3] = 1.0e9;    len_cfg[3] = 1500;
+       bps_cfg[4] = 2.5e9;    len_cfg[4] = 1500;
+       bps_cfg[5] = 5.0e9;    len_cfg[5] = 1500;
+       bps_cfg[6] = 10.0e9;   len_cfg[6] = 1500;
+       bps_cfg[7] = 1.0e9;    len_cfg[7] = 9000;
+       bps_cfg[EDT_CLASS] = 1.0e9; len_cfg[EDT_CLASS] = 1500;
+       for(i = 0; i <= CLASSES; i = i + 1)
+          rate_cfg[i] = rate_from_bps(bps_cfg[i]);
+       prio_rate = rate_from_bps(10.0e9);
+
+       stopped = 0;
+       stats_go = 0;
+       #100 reset = 0;
+
+       wait(cycle == RUN_CYCLES);
+       stopped = 1;
+
+       failed = 0;
+       for(i = 0; i < CLASSES; i = i + 1) begin
+          if(batches[i] < 3) begin
+             $display("class %0d: %0d batches, too few to measure", i, batches[i]);
+             failed = 1;
+          end
+          else begin
+             achieved = bytes_sent[i] * 8.0 * CLK_HZ / (last_cycle[i] - first_cycle[i]);
+             error = (achieved - bps_cfg[i]) / bps_cfg[i];
+             error_abs = (error < 0) ? -error : error;
+             $display("class %0d: len %0d rate %0d configured %e bps achieved %e bps error %f%%",
+                      i, len_cfg[i], rate_cfg[i], bps_cfg[i], achieved, error * 100.0);
+             if(error_abs > ERROR_MAX)
+                failed = 1;
+          end
+       end
+
+       if((batches[EDT_CLASS] == 0) || (first_cycle[EDT_CLASS] < EDT_LAUNCH) ||
+          (first_cycle[EDT_CLASS] > EDT_LAUNCH + EDT_SLACK)) begin
+          $display("class %0d: first dispatch at cycle %0d, launch time %0d",
+                   EDT_CLASS, first_cycle[EDT_CLASS], EDT_LAUNCH);
+          failed = 1;
+       end
+
+       // the level 0 class is dispatched ahead of every level 3 class that
+       // waits with it, the level 3 classes share what is left
+       prio_lo_avg = 0.0;
+       for(i = 0; i < PRIO_HI; i = i + 1)
+          prio_lo_avg = prio_lo_avg + prio_pkts[i];
+       prio_lo_avg = prio_lo_avg / PRIO_HI;
+       $display("priority: level 0 class %0d pkts, level 3 classes %f pkts on average",
+                prio_pkts[PRIO_HI], prio_lo_avg);
+       if(prio_pkts[PRIO_HI] < PRIO_SHARE_MIN * prio_lo_avg) begin
+          $display("priority: level 0 class did not take the link");
+          failed = 1;
+       end
+
+       // all feedback is in after the drain, then read the counters. Every
+       // class had DOORBELL_SET_PARAMS and DOORBELL_ADD_DSC after it was added
+       wait(cycle == RUN_CYCLES + DRAIN_CYCLES);
+       @(negedge clk) stats_go = 1;
+       @(negedge clk) stats_go = 0;
+       wait(stats_num == CLASSES);
+       for(i = 0; i < CLASSES; i = i + 1) begin
+          $display("class %0d: counters bytes %0d pkts %0d starved %0d cycles doorbells %0d",
+                   i, stats_bytes[i], stats_pkts[i], stats_starved[i], stats_doorbells[i]);
+          if((stats_bytes[i] != bytes_total[i]) || (stats_pkts[i] != pkts_total[i]) ||
+             (stats_doorbells[i] != 2)) begin
+             $display("class %0d: counters do not match, sent %0d bytes %0d pkts",
+                      i, bytes_total[i], pkts_total[i]);
+             failed = 1;
+          end
+       end
+       // the 1 Mbps class waits on tokens most of the time
+       if(stats_starved[0] < RUN_CYCLES / 2) begin
+          $display("class 0: starved cycles too low");
+          failed = 1;
+       end
+
+       if(failed)
+          $display("Test Failed");
+       else
+          $display("Test Passed");
+       $finish;
+    end
+
+    always #3.125 clk = ~clk;
+
+    nicpic nicpic
+      (
+       .tx_task_q_deq_en(tx_task_q_deq_en),
+       .tx_task_q_data(tx_task_q_data),
+       .tx_task_q_empty(tx_task_q_empty),
+
+       .doorbell_task_q_enq_en(doorbell_task_q_enq_en),
+       .doorbell_task_q_data(doorbell_task_q_data),
+       .doorbell_task_q_full(doorbell_task_q_full),
+
+       .doorbell_dne_q_deq_en(!doorbell_dne_q_empty),
+       .doorbell_dne_q_deq_data(doorbell_dne_q_deq_data),
+       .doorbell_dne_q_empty(doorbell_dne_q_empty),
+
+       .feedback_task_q_enq_en(feedback_task_q_enq_en),
+       .feedback_task_q_enq_data(feedback_task_q_enq_data),
+       .feedback_task_q_full(feedback_task_q_full),
+
+       .clk(clk),
+       .rst(reset)
+       );
+
+    nicpic prio_nicpic
+      (
+       .tx_task_q_deq_en(prio_tx_task_q_deq_en),
+       .tx_task_q_data(prio_tx_task_q_data),
+       .tx_task_q_empty(prio_tx_task_q_empty),
+
+       .doorbell_task_q_enq_en(prio_doorbell_task_q_enq_en),
+       .doorbell_task_q_data(prio_doorbell_task_q_data),
+       .doorbell_task_q_full(prio_doorbell_task_q_full),
+
+       .doorbell_dne_q_deq_en(!prio_doorbell_dne_q_empty),
+       .doorbell_dne_q_deq_data(prio_doorbell_dne_q_deq_data),
+       .doorbell_dne_q_empty(prio_doorbell_dne_q_empty),
+
+       .feedback_task_q_enq_en(prio_feedback_task_q_enq_en),
+       .feedback_task_q_enq_data(prio_feedback_task_q_enq_data),
+       .feedback_task_q_full(prio_feedback_task_q_full),
+
+       .clk(clk),
+       .rst(reset)
+       );
+
+endmodule
@@ -44,10 +44,12 @@
 #include <linux/init.h>
 #include <linux/stat.h>
 #include <linux/pci.h>
+#include <linux/vmalloc.h>
 #include "nf10driver.h"
 #include "nf10fops.h"
 #include "nf10iface.h"
 #include "nicpic.h"
+#include "nf10priv.h"
 
 #define SK_BUFF_ALLOC_SIZE  1533
 
@@ -61,6 +63,18 @@ static struct pci_device_id pci_id[] = {
 };
 MODULE_DEVICE_TABLE(pci, pci_id);
 
+static int tx_cut_lines = 0;
+module_param(tx_cut_lines, int, S_IRUGO);
+MODULE_PARM_DESC(tx_cut_lines, "64 byte lines of a tx packet on the card before it goes to the MAC, 0 for the first, 65535 for the whole packet");
+
+// size of a card memory as a mask, read from cfg. Bitfiles that do not
+// report it return 0, they have the fallback size
+static uint64_t nf10_mem_mask(struct nf10_card *card, int word, uint64_t fallback){
+    uint64_t mask = *(((uint64_t*)card->cfg_addr)+word);
+
+    return mask ? mask : fallback;
+}
+
 static int __devinit nf10_probe(struct pci_dev *pdev, const struct pci_device_id *id){
 	int err;
     int i;
@@ -139,10 +153,11 @@ static int __devinit nf10_probe(struct pci_dev *pdev, const struct pci_device_id
 
 	printk(KERN_INFO "nf10: mapping mem memory\n");
 
-    card->tx_doorbell = ioremap_nocache(pci_resource_start(pdev, 2) + 0 * 0x00100000ULL, 0x00100000ULL);
+    card->tx_doorbell = ioremap_nocache(pci_resource_start(pdev, 2) + 0 * 0x00100000ULL, NICPIC_INLINE_BASE);
+    card->tx_inline = ioremap_wc(pci_resource_start(pdev, 2) + NICPIC_INLINE_BASE, NICPIC_INLINE_SLOTS * NICPIC_INLINE_MAX);
     card->rx_dsc = ioremap_nocache(pci_resource_start(pdev, 2) + 1 * 0x00100000ULL, 0x00100000ULL);
 
-	if (!card->tx_doorbell || !card->rx_dsc)
+	if (!card->tx_doorbell || !card->tx_inline || !card->rx_dsc)
 	{
 		printk(KERN_ERR "nf10: cannot mem region len:%lx start:%lx\n",
 			(long unsigned)pci_resource_len(pdev, 2),
@@ -155,15 +170,21 @@ static int __devinit nf10_probe(struct pci_dev *pdev, const struct pci_device_id
     msleep(1);
     printk(KERN_INFO "reset: %d\n", *(((uint64_t*)card->cfg_addr)+30));
 
-    // set buffer masks
-    card->tx_dsc_mask = 0x000007ffULL;
-    card->rx_dsc_mask = 0x000007ffULL;
-    card->tx_pkt_mask = 0x00007fffULL;
-    card->rx_pkt_mask = 0x00007fffULL;
-    card->tx_dne_mask = 0x000007ffULL;
-    card->rx_dne_mask = 0x000007ffULL;
-    card->tx_doorbell_mask  = 0x000007ffULL;
-    card->tx_doorbell_dne_mask = 0x000007ffULL;
+    // set buffer masks, as big as the card memories were built
+    card->tx_dsc_mask = nf10_mem_mask(card, 53, 0x000007ffULL);
+    card->rx_dsc_mask = nf10_mem_mask(card, 56, 0x000007ffULL);
+    card->tx_pkt_mask = nf10_mem_mask(card, 54, 0x00007fffULL);
+    card->rx_pkt_mask = nf10_mem_mask(card, 57, 0x00007fffULL);
+    card->tx_dne_mask = nf10_mem_mask(card, 55, 0x000007ffULL);
+    card->rx_dne_mask = nf10_mem_mask(card, 58, 0x000007ffULL);
+    card->tx_doorbell_mask  = nf10_mem_mask(card, 59, 0x000007ffULL);
+    card->tx_doorbell_dne_mask = nf10_mem_mask(card, 60, 0x000007ffULL);
+    // no inline packets without the memory for them
+    card->inline_slots = (nf10_mem_mask(card, 61, 0) + 1) / NICPIC_INLINE_MAX;
+    if(card->inline_slots > NICPIC_INLINE_SLOTS)
+        card->inline_slots = NICPIC_INLINE_SLOTS;
+    printk(KERN_INFO "nf10: tx_pkt %llu bytes, rx_pkt %llu bytes, %d inline slots\n",
+           card->tx_pkt_mask+1, card->rx_pkt_mask+1, card->inline_slots);
     /*
     if(card->tx_dsc_mask > card->tx_dne_mask){
         *(((uint64_t*)card->cfg_addr)+1) = card->tx_dne_mask;
@@ -187,10 +208,16 @@ static int __devinit nf10_probe(struct pci_dev *pdev, const struct pci_device_id
     card->host_tx_dne_ptr = pci_alloc_consistent(pdev, card->tx_dne_mask+1, &(card->host_tx_dne_dma));
     card->host_rx_dne_ptr = pci_alloc_consistent(pdev, card->rx_dne_mask+1, &(card->host_rx_dne_dma));
     card->host_tx_doorbell_dne_ptr = pci_alloc_consistent(pdev, card->tx_doorbell_dne_mask+1, &(card->host_tx_doorbell_dne_dma));
+    card->bulk_table_ptr = pci_alloc_consistent(pdev, NICPIC_BULK_TABLE_SIZE, &(card->bulk_table_dma));
+    card->vclasses = (struct dsc_buff**)vzalloc(VCLASS_NUM_MAX*sizeof(struct dsc_buff*));
+    card->cc_flows = (uint32_t*)vzalloc(CC_FLOW_NUM*sizeof(uint32_t));
 
     if( (card->host_rx_dne_ptr == NULL) ||
         (card->host_tx_dne_ptr == NULL) ||
-        (card->host_tx_doorbell_dne_ptr == NULL)){
+        (card->host_tx_doorbell_dne_ptr == NULL) ||
+        (card->bulk_table_ptr == NULL) ||
+        (card->vclasses == NULL) ||
+        (card->cc_flows == NULL)){
         
         printk(KERN_ERR "nf10: cannot allocate dma buffer\n");
         goto err_out_free_private2;
@@ -204,6 +231,9 @@ static int __devinit nf10_probe(struct pci_dev *pdev, const struct pci_device_id
     *(((uint64_t*)card->cfg_addr)+37) = card->host_tx_doorbell_dne_dma;
     *(((uint64_t*)card->cfg_addr)+38) = card->tx_doorbell_dne_mask;
 
+    // tx cut-through
+    *(((uint64_t*)card->cfg_addr)+42) = tx_cut_lines;
+
     // init mem buffers
     card->mem_tx_dsc.wr_ptr = 0;
     card->mem_tx_dsc.rd_ptr = 0;
@@ -280,6 +310,18 @@ static int __devinit nf10_probe(struct pci_dev *pdev, const struct pci_device_id
 
     // initialize descriptors buffers
     card->class_num = 0;
+    atomic_set(&card->bulk_busy, 0);
+    atomic_set(&card->stats_left, 0);
+    card->stats_seq = 0;
+    card->cc_num = 0;
+    hrtimer_init(&card->cc_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+    card->cc_timer.function = nf10priv_cc_timer;
+    card->nicpic_clk_hz = NICPIC_CLK_HZ;
+    card->edt_ns = 0;
+    card->vclass_num = 0;
+    INIT_LIST_HEAD(&card->slot_lru);
+    card->evict_slot = -1;
+    card->slot_wait = 0;
 
     // store private data to pdev
 	pci_set_drvdata(pdev, card);
@@ -396,9 +438,11 @@ static int __devinit nf10_probe(struct pci_dev *pdev, const struct pci_device_id
     *(((uint64_t*)card->tx_doorbell) + 8 * 2 + 1) = (port_decoded << 96) + (uint64_t)pkt_len;
     mb();*/
 
-        nicpic_add_class(card, 0xffffULL, 1, 0xffff);
+        // a class per port, the scheduler interleaves them so a port that
+        // is held back by its class does not block the others
+        for(i = 0; i < PORT_NUM; i++)
+            nicpic_add_class(card, 0xffffULL, 1, 0xffff);
         //nicpic_start_class(card, 0, 1500);
-        nicpic_add_class(card, 0xffffULL, 1, 0xffff);
         //nicpic_start_class(card, 1, 1500);
         //nicpic_add_class(card, 0xffffULL, 1, 0xffff);
         //nicpic_start_class(card, 2, 1500);
@@ -433,8 +477,12 @@ static int __devinit nf10_probe(struct pci_dev *pdev, const struct pci_device_id
     pci_free_consistent(pdev, card->tx_dne_mask+1, card->host_tx_dne_ptr, card->host_tx_dne_dma);
     pci_free_consistent(pdev, card->rx_dne_mask+1, card->host_rx_dne_ptr, card->host_rx_dne_dma);
     pci_free_consistent(pdev, card->tx_doorbell_dne_mask+1, card->host_tx_doorbell_dne_ptr, card->host_tx_doorbell_dne_dma);
+    if(card->bulk_table_ptr) pci_free_consistent(pdev, NICPIC_BULK_TABLE_SIZE, card->bulk_table_ptr, card->bulk_table_dma);
+    if(card->vclasses) vfree(card->vclasses);
+    if(card->cc_flows) vfree(card->cc_flows);
  err_out_iounmap:
     if(card->tx_doorbell) iounmap(card->tx_doorbell);
+    if(card->tx_inline) iounmap(card->tx_inline);
     if(card->rx_dsc) iounmap(card->rx_dsc);
     if(card->cfg_addr)   iounmap(card->cfg_addr);
 	pci_set_drvdata(pdev, NULL);
@@ -459,6 +507,9 @@ static void __devexit nf10_remove(struct pci_dev *pdev){
     printk(KERN_INFO "nf10: releasing private memory\n");
     card = (struct nf10_card*)pci_get_drvdata(pdev);
 
+    // no more rate updates
+    hrtimer_cancel(&card->cc_timer);
+
     //doorbell_stop_class(card, 0);
     //doorbell_delete_class(card);
     /*
@@ -476,9 +527,7 @@ static void __devexit nf10_remove(struct pci_dev *pdev){
     for(j=0; j<card->class_num; j++)
     {
         for(i=card->dsc_buffs[j]->head; i<card->dsc_buffs[j]->tail; i++){
-        pci_unmap_single(card->pdev, card->dsc_buffs[j]->pkt_physical_addr[i],
-                         card->dsc_buffs[j]->skb[i]->len, PCI_DMA_TODEVICE);
-        dev_kfree_skb_any(card->dsc_buffs[j]->skb[i]);
+        nicpic_tx_free(card, card->dsc_buffs[j], i);
         }
         kfree(card->dsc_buffs[j]->skb);
         kfree(card->dsc_buffs[j]->pkt_physical_addr);
@@ -488,6 +537,24 @@ static void __devexit nf10_remove(struct pci_dev *pdev){
         kfree(card->dsc_buffs[j]);
     }
 
+    // classes that only live in host memory
+    for(j=0; j<card->vclass_num; j++)
+    {
+        if(card->vclasses[j] == NULL || card->vclasses[j]->slot >= 0 ||
+           (card->vclasses[j]->class_index >= 0 && card->vclasses[j]->class_index < card->class_num &&
+            card->dsc_buffs[card->vclasses[j]->class_index] == card->vclasses[j]))
+            continue;
+        for(i=card->vclasses[j]->head; i<card->vclasses[j]->tail; i++){
+        nicpic_tx_free(card, card->vclasses[j], i);
+        }
+        kfree(card->vclasses[j]->skb);
+        kfree(card->vclasses[j]->pkt_physical_addr);
+        pci_free_consistent(card->pdev, card->vclasses[j]->mask+65,
+                            card->vclasses[j]->ptr_ori,
+                            card->vclasses[j]->physical_addr_ori);
+        kfree(card->vclasses[j]);
+    }
+
     if(card){
 
         nf10fops_remove(pdev, card);
@@ -496,11 +563,15 @@ static void __devexit nf10_remove(struct pci_dev *pdev){
         if(card->cfg_addr) iounmap(card->cfg_addr);
 
         if(card->tx_doorbell) iounmap(card->tx_doorbell);
+        if(card->tx_inline) iounmap(card->tx_inline);
         if(card->rx_dsc) iounmap(card->rx_dsc);
 
         pci_free_consistent(pdev, card->tx_dne_mask+1, card->host_tx_dne_ptr, card->host_tx_dne_dma);
         pci_free_consistent(pdev, card->rx_dne_mask+1, card->host_rx_dne_ptr, card->host_rx_dne_dma);
         pci_free_consistent(pdev, card->tx_doorbell_dne_mask+1, card->host_tx_doorbell_dne_ptr, card->host_tx_doorbell_dne_dma);
+        pci_free_consistent(pdev, NICPIC_BULK_TABLE_SIZE, card->bulk_table_ptr, card->bulk_table_dma);
+        vfree(card->vclasses);
+        vfree(card->cc_flows);
         //pci_free_consistent(pdev, card->tx_dsc_buffer_host_mask+1, card->tx_dsc_buffer_ptr_tmp, card->tx_dsc_buffer_host_addr_tmp);
 
         if(card->tx_bk_dma_addr) kfree(card->tx_bk_dma_addr);
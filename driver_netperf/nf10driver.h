@@ -43,12 +43,20 @@
 #define PCI_VENDOR_ID_NF10 0x10ee
 #define PCI_DEVICE_ID_NF10 0x4244
 #define DEVICE_NAME "nf10"
-#define CLASS_NUM_MAX 1023
+#define PORT_NUM 4           // network ports, each has its own class, see nf10_probe
+#define CLASS_NUM_MAX 1023   // nicpic slots
+#define VCLASS_NUM_MAX 65536 // host classes, CLASS_NUM_MAX of them are cached in nicpic
+#define CC_FLOW_BITS 12      // tcp flows remembered to match congestion feedback to a class
+#define CC_FLOW_NUM (1 << CC_FLOW_BITS)
 
 #include <linux/netdevice.h> 
 #include <linux/cdev.h>
 #include <asm/atomic.h>
 #include <linux/workqueue.h>
+#include <linux/list.h>
+#include <linux/ktime.h>
+#include <linux/hrtimer.h>
+#include <linux/bitops.h>
 
 void work_handler(struct work_struct *w);
 
@@ -60,6 +68,22 @@ struct nf10mem{
     uint64_t cl_size;
 } __attribute__ ((aligned(64)));
 
+struct nicpic_rate{
+    uint64_t rate;          // value programmed into the card
+    uint64_t tokens_max;
+    uint64_t bps;           // rate actually enforced
+    uint64_t step_bps;      // resolution, distance to the next slower setting
+    int64_t error_ppm;      // (bps - requested) / requested
+};
+
+// counters the card keeps per slot, cleared when a class is loaded into it
+struct nicpic_stats{
+    uint64_t bytes;
+    uint64_t pkts;
+    uint64_t starved_cycles; // backlogged but waiting for tokens
+    uint64_t doorbells;      // updates to the class
+};
+
 struct dsc_buff{
     void *ptr_ori;
     void *ptr;
@@ -71,6 +95,28 @@ struct dsc_buff{
     uint64_t tail;
     struct sk_buff **skb;
     uint64_t *pkt_physical_addr;
+    struct nicpic_rate rate;
+    struct nicpic_rate min_rate; // committed rate, rate holds the bucket fill
+    int parent_index;       // host class id of the parent, -1 if none
+    int child_num;          // classes sharing this class's tokens
+    uint64_t quantum;       // round robin bytes per turn, 0 for a paced class
+    uint64_t prio;          // strict priority level, 0 goes first
+    uint32_t vclass;        // host class id
+    int slot;               // nicpic slot, -1 while the class only lives in host memory
+    struct list_head lru;   // resident classes, least recently used first
+    int spilled;            // state below was handed back by an eviction
+    struct nicpic_stats stats_out; // counters of the slots the class held before
+    uint32_t stats_out_num;        // evictions counted in stats_out
+    uint64_t spill_tokens;
+    ktime_t spill_time;
+    int cc_on;              // rate follows the ECN echo of the acks, see nicpic_set_cc
+    uint64_t cc_max_bps;    // configured rate, the adapted one stays below it
+    uint64_t cc_bps;
+    uint64_t cc_burst;
+    uint64_t cc_ai_bps;     // increase per period without marks
+    uint32_t cc_alpha;      // estimated marked fraction, NICPIC_CC_ALPHA_ONE is all
+    atomic_t cc_acks;       // since the last period
+    atomic_t cc_marks;
 };
 
 struct my_work_t{
@@ -85,6 +131,7 @@ struct nf10_card{
     volatile void *cfg_addr;   // kernel virtual address of the card BAR0 space
     volatile void *tx_doorbell;     // kernel virtual address of the card tx descriptor space
     volatile void *rx_dsc;     // kernel virtual address of the card rx descriptor space
+    void __iomem *tx_inline;   // write combined, small packets sent from card memory
 
     uint64_t tx_dsc_mask;
     uint64_t rx_dsc_mask;
@@ -103,11 +150,29 @@ struct nf10_card{
 
     void *host_tx_doorbell_dne_ptr;         // virtual address
     uint64_t host_tx_doorbell_dne_dma;      // physical address
+
+    void *bulk_table_ptr;          // virtual address of the nicpic bulk parameter table
+    uint64_t bulk_table_dma;       // physical address
+    atomic_t bulk_busy;            // bulk update in flight, cleared by its doorbell completion
+    uint64_t nicpic_clk_hz;        // nicpic clock, measured by nicpic_calibrate
+    struct nicpic_stats stats[CLASS_NUM_MAX]; // by slot, filled by a stats snapshot
+    atomic_t stats_left;           // snapshot entries still to come
+    uint32_t stats_seq;            // tag of the last snapshot, low 6 bits go to the card
+    uint32_t *cc_flows;            // host class + 1 by flow hash, 0 if unknown
+    int cc_num;                    // classes under congestion control
+    struct hrtimer cc_timer;       // congestion control period, runs while cc_num
+    uint64_t cc_index[CLASS_NUM_MAX]; // rate updates of one period
+    uint64_t cc_rate[CLASS_NUM_MAX];
+    uint64_t cc_tokens_max[CLASS_NUM_MAX];
+    uint64_t edt_ns;               // host monotonic ns and card tx cycles read together,
+    uint64_t edt_cycles;           // launch times are extrapolated from them
+    unsigned long inline_busy[BITS_TO_LONGS(64)]; // tx_inline slots until their tx completion
+    int inline_slots;              // as many as the card memory holds, at most 64
     
     struct pci_dev *pdev;
     struct cdev cdev; // char device structure (for /dev/nf10)
 
-    struct net_device *ndev[4]; // network devices
+    struct net_device *ndev[PORT_NUM]; // network devices
     
     // memory buffers
     struct nf10mem mem_tx_dsc;
@@ -131,8 +196,16 @@ struct nf10_card{
     
 
     // tx dsc buffer
-    struct dsc_buff *dsc_buffs[CLASS_NUM_MAX];
+    struct dsc_buff *dsc_buffs[CLASS_NUM_MAX]; // by slot
     int class_num;
+    struct dsc_buff **vclasses;    // by host class id
+    int vclass_num;
+    struct list_head slot_lru;
+    int evict_slot;                // slot being evicted, -1 if none
+    int evict_done;                // entries of the eviction seen, state and counters. At 2
+                                   // the slot is reloaded once tx completions are drained
+    uint32_t load_vclass;          // class waiting for evict_slot
+    int slot_wait;                 // a miss found every resident class busy
 
     uint64_t tx_dsc_buffer_host_mask;
     void *tx_dsc_buffer_ptr, *tx_dsc_buffer_ptr_tmp;
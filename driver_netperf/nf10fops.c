@@ -50,6 +50,7 @@
 #include <linux/interrupt.h>
 #include <asm/irq.h>
 #include "nicpic.h"
+#include "nf10priv.h"
 
 static dev_t devno;
 static struct class *dev_class;
@@ -77,6 +78,14 @@ long nf10fops_ioctl (struct file *f, unsigned int cmd, unsigned long arg){
     uint64_t addr, val;
     unsigned long flags;
     int i;
+    struct nf10_ioctl_rate rate;
+    struct nf10_ioctl_range range;
+    uint64_t parent[2];
+    uint64_t drr[2];
+    uint64_t prio[2];
+    uint64_t cc[2];
+    struct nf10_ioctl_stats stats;
+    int ok;
 
     switch(cmd){
     /*
@@ -148,6 +157,98 @@ long nf10fops_ioctl (struct file *f, unsigned int cmd, unsigned long arg){
         axi_wr_cnt = 0;
         spin_unlock_irqrestore(&axi_lock, flags);
         break;
+    case NF10_IOCTL_CMD_SET_RATE:
+    case NF10_IOCTL_CMD_GET_RATE:
+    case NF10_IOCTL_CMD_CALIBRATE:
+    case NF10_IOCTL_CMD_SET_MIN:
+        if(copy_from_user(&rate, (struct nf10_ioctl_rate*)arg, sizeof(rate))) return -EFAULT;
+        // calibration sleeps and rings no doorbell, the rest runs under tx_lock
+        if(cmd == NF10_IOCTL_CMD_CALIBRATE){
+            ok = nicpic_calibrate(card, rate.bps, (unsigned int)rate.ms, &rate.result);
+        }
+        else{
+            spin_lock_irqsave(&tx_lock, flags);
+            if(cmd == NF10_IOCTL_CMD_SET_RATE)
+                ok = nicpic_set_rate_bps(card, rate.class_index, rate.bps, rate.burst_bytes, &rate.result);
+            else if(cmd == NF10_IOCTL_CMD_SET_MIN)
+                ok = nicpic_set_min_bps(card, rate.class_index, rate.bps, rate.burst_bytes, &rate.result);
+            else if((ok = rate.class_index < card->vclass_num && card->vclasses[rate.class_index] != NULL))
+                rate.result = card->vclasses[rate.class_index]->rate;
+            spin_unlock_irqrestore(&tx_lock, flags);
+        }
+        if(copy_to_user((struct nf10_ioctl_rate*)arg, &rate, sizeof(rate))) return -EFAULT;
+        if(!ok) return -EINVAL;
+        break;
+    case NF10_IOCTL_CMD_SET_RATE_RANGE:
+        // one bulk doorbell for the whole range, -EINVAL while the last one is in flight
+        if(copy_from_user(&range, (struct nf10_ioctl_range*)arg, sizeof(range))) return -EFAULT;
+        if(range.count == 0 || range.count > CLASS_NUM_MAX) return -EINVAL;
+        spin_lock_irqsave(&tx_lock, flags);
+        ok = nicpic_set_rate_range_bps(card, range.class_index, (int)range.count, range.bps,
+                                       range.burst_bytes, &range.result);
+        spin_unlock_irqrestore(&tx_lock, flags);
+        if(copy_to_user((struct nf10_ioctl_range*)arg, &range, sizeof(range))) return -EFAULT;
+        if(!ok) return -EINVAL;
+        break;
+    case NF10_IOCTL_CMD_ADD_CLASS:
+        // {bps, burst bytes} in, the new class id out, NICPIC_MARK_BASE + id as skb->mark
+        if(copy_from_user(&rate, (struct nf10_ioctl_rate*)arg, sizeof(rate))) return -EFAULT;
+        ok = nicpic_rate_from_bps(card, rate.bps, rate.burst_bytes, NICPIC_ERROR_PPM_MAX, &rate.result);
+        if(ok){
+            i = nicpic_add_vclass(card, 0xffffULL, rate.result.rate, rate.result.tokens_max);
+            ok = i >= 0;
+            rate.class_index = ok ? i : 0;
+        }
+        if(copy_to_user((struct nf10_ioctl_rate*)arg, &rate, sizeof(rate))) return -EFAULT;
+        if(!ok) return -EINVAL;
+        break;
+    case NF10_IOCTL_CMD_SET_PARENT:
+        // {class, parent}, parent ~0 detaches the class
+        if(copy_from_user(parent, (uint64_t*)arg, 16)) return -EFAULT;
+        ok = 1;
+        spin_lock_irqsave(&tx_lock, flags);
+        if(parent[1] == ~0ULL)
+            nicpic_clear_parent(card, parent[0]);
+        else
+            ok = nicpic_set_parent(card, parent[0], parent[1]);
+        spin_unlock_irqrestore(&tx_lock, flags);
+        if(!ok) return -EINVAL;
+        break;
+    case NF10_IOCTL_CMD_SET_DRR:
+        // {class, quantum}, a parent applies the quantum to all its children
+        if(copy_from_user(drr, (uint64_t*)arg, 16)) return -EFAULT;
+        spin_lock_irqsave(&tx_lock, flags);
+        if(drr[0] < card->vclass_num && card->vclasses[drr[0]] != NULL && card->vclasses[drr[0]]->child_num)
+            ok = nicpic_set_group_drr(card, drr[0], drr[1]);
+        else
+            ok = nicpic_set_drr(card, drr[0], drr[1]);
+        spin_unlock_irqrestore(&tx_lock, flags);
+        if(!ok) return -EINVAL;
+        break;
+    case NF10_IOCTL_CMD_SET_PRIO:
+        // {class, level}, class ~0 sets the starvation limit instead
+        if(copy_from_user(prio, (uint64_t*)arg, 16)) return -EFAULT;
+        spin_lock_irqsave(&tx_lock, flags);
+        if(prio[0] == ~0ULL)
+            ok = nicpic_set_starve(card, prio[1]);
+        else
+            ok = nicpic_set_prio(card, prio[0], prio[1]);
+        spin_unlock_irqrestore(&tx_lock, flags);
+        if(!ok) return -EINVAL;
+        break;
+    case NF10_IOCTL_CMD_SET_CC:
+        // {class, increase in bps per period}, 0 goes back to the fixed rate
+        if(copy_from_user(cc, (uint64_t*)arg, 16)) return -EFAULT;
+        spin_lock_irqsave(&tx_lock, flags);
+        ok = nicpic_set_cc(card, cc[0], cc[1]);
+        spin_unlock_irqrestore(&tx_lock, flags);
+        if(!ok) return -EINVAL;
+        break;
+    case NF10_IOCTL_CMD_GET_STATS:
+        if(copy_from_user(&stats, (struct nf10_ioctl_stats*)arg, sizeof(stats))) return -EFAULT;
+        if(!nicpic_read_stats(card, stats.class_index, &stats.stats)) return -EINVAL;
+        if(copy_to_user((struct nf10_ioctl_stats*)arg, &stats, sizeof(stats))) return -EFAULT;
+        break;
     default:
         printk(KERN_ERR "nf10: unknown ioctl\n");
         break;
@@ -46,6 +46,41 @@
 #define NF10_IOCTL_CMD_WRITE_REG (SIOCDEVPRIVATE+1)
 #define NF10_IOCTL_CMD_READ_REG (SIOCDEVPRIVATE+2)
 #define NF10_IOCTL_CMD_ADD_DSC (SIOCDEVPRIVATE+3)
+#define NF10_IOCTL_CMD_SET_RATE (SIOCDEVPRIVATE+4)
+#define NF10_IOCTL_CMD_GET_RATE (SIOCDEVPRIVATE+5)
+#define NF10_IOCTL_CMD_CALIBRATE (SIOCDEVPRIVATE+6)
+#define NF10_IOCTL_CMD_SET_PARENT (SIOCDEVPRIVATE+7)
+#define NF10_IOCTL_CMD_SET_DRR (SIOCDEVPRIVATE+8)
+#define NF10_IOCTL_CMD_SET_MIN (SIOCDEVPRIVATE+9)
+#define NF10_IOCTL_CMD_GET_STATS (SIOCDEVPRIVATE+10)
+#define NF10_IOCTL_CMD_SET_PRIO (SIOCDEVPRIVATE+11)
+#define NF10_IOCTL_CMD_SET_CC (SIOCDEVPRIVATE+12)
+#define NF10_IOCTL_CMD_ADD_CLASS (SIOCDEVPRIVATE+13)
+#define NF10_IOCTL_CMD_SET_RATE_RANGE (SIOCDEVPRIVATE+14)
+
+// class_index is a host class id, the ones of the ports or one from
+// NF10_IOCTL_CMD_ADD_CLASS, whether or not the class holds a nicpic slot
+struct nf10_ioctl_rate{
+    uint64_t class_index;
+    uint64_t bps;
+    uint64_t burst_bytes;
+    uint64_t ms;                // calibration window
+    struct nicpic_rate result;
+};
+
+// one rate for count classes from class_index on
+struct nf10_ioctl_range{
+    uint64_t class_index;
+    uint64_t count;
+    uint64_t bps;
+    uint64_t burst_bytes;
+    struct nicpic_rate result;
+};
+
+struct nf10_ioctl_stats{
+    uint64_t class_index;
+    struct nicpic_stats stats;
+};
 
 int nf10fops_open (struct inode *n, struct file *f);
 long nf10fops_ioctl (struct file *f, unsigned int cmd, unsigned long arg);
@@ -62,6 +62,7 @@ irqreturn_t int_handler(int irq, void *dev_id){
 static netdev_tx_t nf10i_tx(struct sk_buff *skb, struct net_device *dev){
     struct nf10_card* card = ((struct nf10_ndev_priv*)netdev_priv(dev))->card;
     int port = ((struct nf10_ndev_priv*)netdev_priv(dev))->port_num;
+    int ret;
 
     // meet minimum size requirement
     if(skb->len < 60){
@@ -75,8 +76,12 @@ static netdev_tx_t nf10i_tx(struct sk_buff *skb, struct net_device *dev){
         return NETDEV_TX_OK;        
     }
 
-    // transmit packet
-    if(nf10priv_xmit(card, skb, port)){
+    // transmit packet. A class that is being loaded into nicpic keeps the
+    // packet, the queue is already stopped and woken once the class is in
+    ret = nf10priv_xmit(card, skb, port);
+    if(ret == -EBUSY)
+        return NETDEV_TX_BUSY;
+    if(ret){
         //printk(KERN_ERR "nf10: dropping packet at port %d", port);
         dev_kfree_skb_any(skb);
         return NETDEV_TX_OK;
@@ -154,7 +159,7 @@ int nf10iface_probe(struct pci_dev *pdev, struct nf10_card *card){
     }
 
     // Set up the network device...
-    for (i = 0; i < 4; i++){
+    for (i = 0; i < PORT_NUM; i++){
         netdev = card->ndev[i] = alloc_netdev(sizeof(struct nf10_ndev_priv),
                                               devname, nf10iface_init);
         if(netdev == NULL){
@@ -189,7 +194,7 @@ int nf10iface_probe(struct pci_dev *pdev, struct nf10_card *card){
     
     // fail
  err_out_free_dev:
-    for (i = 0; i < 4; i++){
+    for (i = 0; i < PORT_NUM; i++){
         if(card->ndev[i]){
             unregister_netdev(card->ndev[i]);
             free_netdev(card->ndev[i]);
@@ -203,7 +208,7 @@ int nf10iface_probe(struct pci_dev *pdev, struct nf10_card *card){
 int nf10iface_remove(struct pci_dev *pdev, struct nf10_card *card){
     int i;
 
-    for (i = 0; i < 4; i++){
+    for (i = 0; i < PORT_NUM; i++){
         if(card->ndev[i]){
             unregister_netdev(card->ndev[i]);
             free_netdev(card->ndev[i]);
@@ -14,7 +14,7 @@
  *  Description:
  *        These functions control the card tx/rx operation. 
  *        nf10priv_xmit -- gets called for every transmitted packet
- *                         (on any nf interface)
+ *                         (on any nf interface), -EBUSY asks for a retry
  *        work_handler  -- gets called when the interrupt handler puts work
  *                         on the queue
  *        nf10priv_send_rx_dsc -- allocates and sends a receive descriptor
@@ -75,7 +75,8 @@
 
 //#define LOOPBACK_MODE
 
-static DEFINE_SPINLOCK(tx_lock);
+// the tx rings and the doorbell slots, shared with the ioctls
+DEFINE_SPINLOCK(tx_lock);
 static DEFINE_SPINLOCK(work_lock);
 static DEFINE_SPINLOCK(rx_dsc_lock);
 
@@ -87,14 +88,13 @@ int nf10priv_xmit(struct nf10_card *card, struct sk_buff *skb, int port){
     unsigned long flags;
     uint64_t dsc_index = 0;
     uint64_t port_decoded = 0;
-    uint64_t dsc_l0, dsc_l1;
+    uint64_t dsc_l0, dsc_l1, dsc_l2;
     uint64_t dma_addr;
-    uint64_t class_index = skb->mark;
+    uint64_t class_index;
+    uint32_t vclass;
+    int slot;
     uint64_t port_short;
 
-    //decide which class does this packet belong to
-    class_index = 0;
-
     //printk(KERN_EMERG "xmit\n");
     if(len > 1514)
         printk(KERN_ERR "nf10: ERROR too big packet. TX size: %d\n", len);
@@ -102,17 +102,41 @@ int nf10priv_xmit(struct nf10_card *card, struct sk_buff *skb, int port){
     // packet buffer management
     spin_lock_irqsave(&tx_lock, flags);
 
+    //decide which class does this packet belong to. A mark from NICPIC_MARK_BASE
+    //on names a class made with NF10_IOCTL_CMD_ADD_CLASS, otherwise the port's own class
+    vclass = port;
+    if(skb->mark >= NICPIC_MARK_BASE + PORT_NUM && skb->mark - NICPIC_MARK_BASE < card->vclass_num)
+        vclass = skb->mark - NICPIC_MARK_BASE;
+
+    // the class may have to be brought into a nicpic slot first. The queue
+    // stops under the lock, so the wake after the load cannot come first
+    slot = nicpic_vclass_slot(card, vclass);
+    if(slot == -EBUSY){
+        netif_stop_queue(card->ndev[port]);
+        spin_unlock_irqrestore(&tx_lock, flags);
+        return -EBUSY;
+    }
+    if(slot < 0){
+        spin_unlock_irqrestore(&tx_lock, flags);
+        return -1;
+    }
+    class_index = slot;
+
     if(!(card->dsc_buffs[class_index]->head == 0 && card->dsc_buffs[class_index]->tail == ((card->dsc_buffs[class_index]->mask)>>6))
        && !(card->dsc_buffs[class_index]->head != 0 && card->dsc_buffs[class_index]->tail == card->dsc_buffs[class_index]->head - 1)){
         
         dsc_index = card->dsc_buffs[class_index]->tail;
         card->dsc_buffs[class_index]->tail = ((card->dsc_buffs[class_index]->tail+1) & card->dsc_buffs[class_index]->mask);
-        dma_addr = pci_map_single(card->pdev, data, len, PCI_DMA_TODEVICE);
+        // small packets go to card memory, the card does not have to read them
+        dma_addr = nicpic_inline(card, skb);
+        if(dma_addr == 0){
+            dma_addr = pci_map_single(card->pdev, data, len, PCI_DMA_TODEVICE);
         
-        if(pci_dma_mapping_error(card->pdev, dma_addr)){
-            printk(KERN_ERR "nf10: dma mapping error");
-            spin_unlock_irqrestore(&tx_lock, flags);
-            return -1;
+            if(pci_dma_mapping_error(card->pdev, dma_addr)){
+                printk(KERN_ERR "nf10: dma mapping error");
+                spin_unlock_irqrestore(&tx_lock, flags);
+                return -1;
+            }
         }
 
     } 
@@ -120,8 +144,12 @@ int nf10priv_xmit(struct nf10_card *card, struct sk_buff *skb, int port){
         spin_unlock_irqrestore(&tx_lock, flags);
         return -1;
     }
-    
-    spin_unlock_irqrestore(&tx_lock, flags);
+
+    // departure time asked for with SO_TXTIME, the card holds the packet until then
+    dsc_l2 = nicpic_launch(card, skb);
+
+    // so congestion feedback on the acks finds the class
+    nicpic_cc_tx(card, skb, vclass);
     
     // figure out ports
     if(port == 0){
@@ -152,19 +180,41 @@ int nf10priv_xmit(struct nf10_card *card, struct sk_buff *skb, int port){
     mb();
     *(((uint64_t*)card->dsc_buffs[class_index]->ptr) + 8 * dsc_index + 0) = dsc_l0;
     *(((uint64_t*)card->dsc_buffs[class_index]->ptr) + 8 * dsc_index + 1) = dsc_l1;
+    *(((uint64_t*)card->dsc_buffs[class_index]->ptr) + 8 * dsc_index + 2) = dsc_l2;
     mb();
 
+    // the doorbell slot is taken under the lock, timer and ioctls ring too
     doorbell_add_dsc(card, class_index, dma_addr, port_short,
-                     len, card->dsc_buffs[class_index]->tail);
+                     len, card->dsc_buffs[class_index]->tail, dsc_l2);
+
+    spin_unlock_irqrestore(&tx_lock, flags);
 
     return 0;
 }
 
+// congestion control period, see nicpic_cc_tick
+enum hrtimer_restart nf10priv_cc_timer(struct hrtimer *t){
+    struct nf10_card *card = container_of(t, struct nf10_card, cc_timer);
+    unsigned long flags;
+    int more;
+
+    spin_lock_irqsave(&tx_lock, flags);
+    more = nicpic_cc_tick(card);
+    spin_unlock_irqrestore(&tx_lock, flags);
+
+    if(!more)
+        return HRTIMER_NORESTART;
+    hrtimer_forward_now(t, ns_to_ktime(NICPIC_CC_PERIOD_NS));
+    return HRTIMER_RESTART;
+}
+
 void work_handler(struct work_struct *w){
     struct nf10_card * card = ((struct my_work_t *)w)->card;
     int irq_done = 0;
     uint64_t tx_int;
     uint32_t tx_doorbell_int;
+    uint64_t spill_tokens, spill_head;
+    struct nicpic_stats stats;
     uint64_t rx_int;
     uint64_t addr;
     uint64_t index;
@@ -212,6 +262,10 @@ void work_handler(struct work_struct *w){
             addr = card->host_tx_doorbell_dne.rd_ptr;
             card->host_tx_doorbell_dne.rd_ptr = (addr + 64) & card->host_tx_doorbell_dne.mask;
             index = addr / 64;
+
+            // state of an evicted class follows the status word
+            spill_tokens = *(((uint64_t*)card->host_tx_doorbell_dne_ptr) + index * 8 + 1);
+            spill_head = *(((uint64_t*)card->host_tx_doorbell_dne_ptr) + index * 8 + 2);
             
             // invalidate host tx completion buffer
             *(((uint32_t*)card->host_tx_doorbell_dne_ptr) + index * 16) = 0xffffffff;
@@ -226,17 +280,51 @@ void work_handler(struct work_struct *w){
             {
                 card->class_num--;
                 for(i=card->dsc_buffs[card->class_num]->head; i<card->dsc_buffs[card->class_num]->tail; i++){
-                   pci_unmap_single(card->pdev, card->dsc_buffs[card->class_num]->pkt_physical_addr[i],
-                                    card->dsc_buffs[card->class_num]->skb[i]->len, PCI_DMA_TODEVICE);
-                   dev_kfree_skb_any(card->dsc_buffs[card->class_num]->skb[i]);
+                   nicpic_tx_free(card, card->dsc_buffs[card->class_num], i);
                 }
                 kfree(card->dsc_buffs[card->class_num]->skb);
                 kfree(card->dsc_buffs[card->class_num]->pkt_physical_addr);
                 pci_free_consistent(card->pdev, card->dsc_buffs[card->class_num]->mask+65,
                                     card->dsc_buffs[card->class_num]->ptr_ori,
                                     card->dsc_buffs[card->class_num]->physical_addr_ori);
+                card->vclasses[card->dsc_buffs[card->class_num]->vclass] = NULL;
+                list_del(&card->dsc_buffs[card->class_num]->lru);
                 kfree(card->dsc_buffs[card->class_num]);
             }
+
+            if(((tx_doorbell_int>>16) & 0x3f) == 10 && ((tx_doorbell_int>>8) & 0x1) == 1)
+            {
+                spin_lock(&tx_lock);
+                nicpic_vclass_evicted(card, (tx_doorbell_int>>22) & 0x3ff, spill_tokens,
+                                      spill_head & 0x3ffffff, (spill_head >> 26) & 0x1);
+                spin_unlock(&tx_lock);
+            }
+
+            // last class of a bulk parameter update, the table can be reused
+            if(((tx_doorbell_int>>16) & 0x3f) == 7 && ((tx_doorbell_int>>8) & 0x1) == 1)
+            {
+                atomic_set(&card->bulk_busy, 0);
+            }
+
+            // one class of a stats snapshot, its counters follow the status word.
+            // [9] marks the counters an eviction hands back, [15:10] is the tag
+            // of the snapshot, a late entry of one given up on is dropped
+            if(((tx_doorbell_int>>16) & 0x3f) == 15)
+            {
+                stats.bytes = spill_tokens;
+                stats.pkts = spill_head;
+                stats.starved_cycles = *(((uint64_t*)card->host_tx_doorbell_dne_ptr) + index * 8 + 3);
+                stats.doorbells = *(((uint64_t*)card->host_tx_doorbell_dne_ptr) + index * 8 + 4);
+                if((tx_doorbell_int>>9) & 0x1){
+                    spin_lock(&tx_lock);
+                    nicpic_vclass_evicted_stats(card, (tx_doorbell_int>>22) & 0x3ff, &stats);
+                    spin_unlock(&tx_lock);
+                }
+                else if(((tx_doorbell_int>>10) & 0x3f) == (card->stats_seq & 0x3f)){
+                    card->stats[(tx_doorbell_int>>22) & 0x3ff] = stats;
+                    atomic_add_unless(&card->stats_left, -1, 0);
+                }
+            }
         }
 
         if( (tx_int & 0xffff) == 1 ){
@@ -264,12 +352,16 @@ void work_handler(struct work_struct *w){
             //printk(KERN_EMERG "%d\n", (int)((tx_int >> 16) & 0xffff));
             //printk(KERN_EMERG "%x\n", (tx_int >> 32));
             class_index = ((tx_int >> 16) & 0xffff);
-            for(i=card->dsc_buffs[class_index]->head; i<(tx_int >> 32); i++){
-                   pci_unmap_single(card->pdev, card->dsc_buffs[class_index]->pkt_physical_addr[i],
-                                    card->dsc_buffs[class_index]->skb[i]->len, PCI_DMA_TODEVICE);
-                   dev_kfree_skb_any(card->dsc_buffs[class_index]->skb[i]);
+            // an evicted class was already reaped from its spilled state
+            // the card merges the completions of a class, one entry may
+            // cover many packets and wrap around the ring
+            if(card->dsc_buffs[class_index]->slot >= 0){
+                for(i=card->dsc_buffs[class_index]->head; i!=(tx_int >> 32);
+                    i=(i+1) & (card->dsc_buffs[class_index]->mask >> 6)){
+                       nicpic_tx_free(card, card->dsc_buffs[class_index], i);
+                }
+                card->dsc_buffs[((tx_int >> 16) & 0xffff)]->head = (tx_int >> 32);
             }
-            card->dsc_buffs[((tx_int >> 16) & 0xffff)]->head = (tx_int >> 32);
             /*
             // restart queue if needed
             if( ((atomic64_read(&card->mem_tx_dsc.cnt) + 8*1) <= card->mem_tx_dsc.cl_size) &&
@@ -282,6 +374,12 @@ void work_handler(struct work_struct *w){
 
             }*/
         }
+        else{
+            // posted tx completions are handled, an evicted slot can be reused
+            spin_lock(&tx_lock);
+            nicpic_vclass_finish_evict(card);
+            spin_unlock(&tx_lock);
+        }
         
         if( ((rx_int >> 48) & 0xffff) != 0xffff ){
             irq_done = 0;
@@ -339,6 +437,7 @@ void work_handler(struct work_struct *w){
                 // update stats
                 card->ndev[port]->stats.rx_packets++;
                 card->ndev[port]->stats.rx_bytes += skb->len;
+                nicpic_cc_rx(card, skb);
 
 #ifdef LOOPBACK_MODE
                 iph = (struct iphdr *)skb->data;
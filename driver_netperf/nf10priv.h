@@ -41,9 +41,13 @@
 
 #include "nf10driver.h"
 
+// held while a doorbell slot is taken and written
+extern spinlock_t tx_lock;
+
 int nf10priv_xmit(struct nf10_card *card, struct sk_buff *skb, int port);
 void work_handler(struct work_struct *w);
 int nf10priv_send_rx_dsc(struct nf10_card *card);
+enum hrtimer_restart nf10priv_cc_timer(struct hrtimer *t);
 
 
 #endif
@@ -1,7 +1,16 @@
 #include <linux/pci.h>
+#include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/if_ether.h>
+#include <linux/ip.h>
+#include <linux/tcp.h>
+#include <net/sock.h>
 #include "nicpic.h"
+#include "nf10priv.h"
 #define SK_BUFF_ALLOC_SIZE  1533
 
+// every doorbell takes the next slot of the card's doorbell window, call
+// them under tx_lock so two writers never share a slot
 void doorbell_add_class(struct nf10_card *card, uint64_t dsc_buffer_host_addr, uint64_t dsc_buffer_mask)
 {
     uint64_t dsc_l0, dsc_l1;
@@ -61,7 +70,8 @@ void doorbell_set_tokens_max(struct nf10_card *card, uint64_t class_index, uint6
 }
 
 void doorbell_add_dsc(struct nf10_card *card, uint64_t class_index, uint64_t pkt_host_addr,
-                      uint64_t pkt_port_short, uint64_t pkt_len, uint64_t dsc_tail_index)
+                      uint64_t pkt_port_short, uint64_t pkt_len, uint64_t dsc_tail_index,
+                      uint64_t launch)
 {
     uint64_t dsc_l0, dsc_l1;
     uint64_t inst = 4;
@@ -74,8 +84,11 @@ void doorbell_add_dsc(struct nf10_card *card, uint64_t class_index, uint64_t pkt
     dsc_l0 = (dsc_tail_index<<38) + (pkt_port_short<<32) + (pkt_len<<16) + (class_index<<6) + inst;
     dsc_l1 = pkt_host_addr;
 
+    // the second word sets the valid bit, so it goes last
     mb();
     *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 0) = dsc_l0;
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 2) = launch;
+    wmb();
     *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 1) = dsc_l1;
     mb();
 }
@@ -119,40 +132,1241 @@ void doorbell_delete_class(struct nf10_card *card)
     mb();
 }
 
-int nicpic_add_class(struct nf10_card *card, uint64_t buff_mask, uint64_t rate, uint64_t tokens_max)
+// rate and tokens_max in one doorbell, tokens_max is 40 bits wide
+void doorbell_set_params(struct nf10_card *card, uint64_t class_index, uint64_t rate, uint64_t tokens_max)
+{
+    uint64_t dsc_l0, dsc_l1;
+    uint64_t inst = 7;
+    uint64_t doorbell_addr = 0, doorbell_index = 0;
+
+    doorbell_addr = card->mem_tx_doorbell.wr_ptr;
+    card->mem_tx_doorbell.wr_ptr = (doorbell_addr + 64) & card->mem_tx_doorbell.mask;
+    doorbell_index = doorbell_addr/64;
+
+    dsc_l0 = ((tokens_max & 0xffffffffffULL)<<24) + (class_index<<6) + inst;
+    dsc_l1 = rate;
+
+    mb();
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 0) = dsc_l0;
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 1) = dsc_l1;
+    mb();
+}
+
+// the card reads count entries from the table at table_host_addr and
+// applies them to classes class_index, class_index+1, ... or, in list
+// mode, to the class stored in each entry
+void doorbell_set_params_bulk(struct nf10_card *card, uint64_t class_index, uint64_t list,
+                              uint64_t count, uint64_t table_host_addr)
+{
+    uint64_t dsc_l0, dsc_l1;
+    uint64_t inst = 8;
+    uint64_t doorbell_addr = 0, doorbell_index = 0;
+
+    doorbell_addr = card->mem_tx_doorbell.wr_ptr;
+    card->mem_tx_doorbell.wr_ptr = (doorbell_addr + 64) & card->mem_tx_doorbell.mask;
+    doorbell_index = doorbell_addr/64;
+
+    dsc_l0 = (count<<32) + (list<<16) + (class_index<<6) + inst;
+    dsc_l1 = table_host_addr;
+
+    mb();
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 0) = dsc_l0;
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 1) = dsc_l1;
+    mb();
+}
+
+// the class shares the tokens of parent_index on top of its own limit
+void doorbell_set_parent(struct nf10_card *card, uint64_t class_index, uint64_t parent_vld,
+                         uint64_t parent_index)
+{
+    uint64_t dsc_l0, dsc_l1;
+    uint64_t inst = 9;
+    uint64_t doorbell_addr = 0, doorbell_index = 0;
+
+    doorbell_addr = card->mem_tx_doorbell.wr_ptr;
+    card->mem_tx_doorbell.wr_ptr = (doorbell_addr + 64) & card->mem_tx_doorbell.mask;
+    doorbell_index = doorbell_addr/64;
+
+    dsc_l0 = (parent_vld<<16) + (class_index<<6) + inst;
+    dsc_l1 = parent_index;
+
+    mb();
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 0) = dsc_l0;
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 1) = dsc_l1;
+    mb();
+}
+
+void doorbell_evict_class(struct nf10_card *card, uint64_t class_index)
+{
+    uint64_t dsc_l0, dsc_l1;
+    uint64_t inst = 10;
+    uint64_t doorbell_addr = 0, doorbell_index = 0;
+
+    doorbell_addr = card->mem_tx_doorbell.wr_ptr;
+    card->mem_tx_doorbell.wr_ptr = (doorbell_addr + 64) & card->mem_tx_doorbell.mask;
+    doorbell_index = doorbell_addr/64;
+
+    dsc_l0 = (class_index<<6) + inst;
+    dsc_l1 = 0xffffffffffffffffULL;
+
+    mb();
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 0) = dsc_l0;
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 1) = dsc_l1;
+    mb();
+}
+
+void doorbell_load_class(struct nf10_card *card, uint64_t class_index, uint64_t dsc_buffer_host_addr,
+                         uint64_t dsc_buffer_mask)
+{
+    uint64_t dsc_l0, dsc_l1;
+    uint64_t inst = 11;
+    uint64_t doorbell_addr = 0, doorbell_index = 0;
+
+    doorbell_addr = card->mem_tx_doorbell.wr_ptr;
+    card->mem_tx_doorbell.wr_ptr = (doorbell_addr + 64) & card->mem_tx_doorbell.mask;
+    doorbell_index = doorbell_addr/64;
+
+    dsc_l0 = (dsc_buffer_mask<<32) + (class_index<<6) + inst;
+    dsc_l1 = dsc_buffer_host_addr;
+
+    mb();
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 0) = dsc_l0;
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 1) = dsc_l1;
+    mb();
+}
+
+void doorbell_load_state(struct nf10_card *card, uint64_t class_index, uint64_t tokens,
+                         uint64_t dsc_head_index)
+{
+    uint64_t dsc_l0, dsc_l1;
+    uint64_t inst = 12;
+    uint64_t doorbell_addr = 0, doorbell_index = 0;
+
+    doorbell_addr = card->mem_tx_doorbell.wr_ptr;
+    card->mem_tx_doorbell.wr_ptr = (doorbell_addr + 64) & card->mem_tx_doorbell.mask;
+    doorbell_index = doorbell_addr/64;
+
+    dsc_l0 = (dsc_head_index<<32) + (class_index<<6) + inst;
+    dsc_l1 = tokens;
+
+    mb();
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 0) = dsc_l0;
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 1) = dsc_l1;
+    mb();
+}
+
+void doorbell_set_drr(struct nf10_card *card, uint64_t class_index, uint64_t drr)
+{
+    uint64_t dsc_l0, dsc_l1;
+    uint64_t inst = 13;
+    uint64_t doorbell_addr = 0, doorbell_index = 0;
+
+    doorbell_addr = card->mem_tx_doorbell.wr_ptr;
+    card->mem_tx_doorbell.wr_ptr = (doorbell_addr + 64) & card->mem_tx_doorbell.mask;
+    doorbell_index = doorbell_addr/64;
+
+    dsc_l0 = (drr<<16) + (class_index<<6) + inst;
+    dsc_l1 = 0;
+
+    mb();
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 0) = dsc_l0;
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 1) = dsc_l1;
+    mb();
+}
+
+void doorbell_set_min(struct nf10_card *card, uint64_t class_index, uint64_t fill, uint64_t tokens_max)
+{
+    uint64_t dsc_l0, dsc_l1;
+    uint64_t inst = 14;
+    uint64_t doorbell_addr = 0, doorbell_index = 0;
+
+    doorbell_addr = card->mem_tx_doorbell.wr_ptr;
+    card->mem_tx_doorbell.wr_ptr = (doorbell_addr + 64) & card->mem_tx_doorbell.mask;
+    doorbell_index = doorbell_addr/64;
+
+    dsc_l0 = ((fill & 0x1ffffffULL)<<16) + (class_index<<6) + inst;
+    dsc_l1 = tokens_max & 0xffffffffffULL;
+
+    mb();
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 0) = dsc_l0;
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 1) = dsc_l1;
+    mb();
+}
+
+void doorbell_read_stats(struct nf10_card *card, uint64_t class_index, uint64_t count,
+                         uint64_t seq)
+{
+    uint64_t dsc_l0, dsc_l1;
+    uint64_t inst = 15;
+    uint64_t doorbell_addr = 0, doorbell_index = 0;
+
+    doorbell_addr = card->mem_tx_doorbell.wr_ptr;
+    card->mem_tx_doorbell.wr_ptr = (doorbell_addr + 64) & card->mem_tx_doorbell.mask;
+    doorbell_index = doorbell_addr/64;
+
+    dsc_l0 = ((seq & 0x3fULL)<<26) + (((count - 1) & 0x3ffULL)<<16) + (class_index<<6) + inst;
+    dsc_l1 = 0;
+
+    mb();
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 0) = dsc_l0;
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 1) = dsc_l1;
+    mb();
+}
+
+void doorbell_set_prio(struct nf10_card *card, uint64_t class_index, uint64_t level)
+{
+    uint64_t dsc_l0, dsc_l1;
+    uint64_t inst = 16;
+    uint64_t doorbell_addr = 0, doorbell_index = 0;
+
+    doorbell_addr = card->mem_tx_doorbell.wr_ptr;
+    card->mem_tx_doorbell.wr_ptr = (doorbell_addr + 64) & card->mem_tx_doorbell.mask;
+    doorbell_index = doorbell_addr/64;
+
+    dsc_l0 = ((level & 0x3ULL)<<16) + (class_index<<6) + inst;
+    dsc_l1 = 0;
+
+    mb();
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 0) = dsc_l0;
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 1) = dsc_l1;
+    mb();
+}
+
+void doorbell_set_starve(struct nf10_card *card, uint64_t class_index, uint64_t starve_max)
+{
+    uint64_t dsc_l0, dsc_l1;
+    uint64_t inst = 17;
+    uint64_t doorbell_addr = 0, doorbell_index = 0;
+
+    doorbell_addr = card->mem_tx_doorbell.wr_ptr;
+    card->mem_tx_doorbell.wr_ptr = (doorbell_addr + 64) & card->mem_tx_doorbell.mask;
+    doorbell_index = doorbell_addr/64;
+
+    dsc_l0 = ((starve_max & 0xffffULL)<<16) + (class_index<<6) + inst;
+    dsc_l1 = 0;
+
+    mb();
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 0) = dsc_l0;
+    *(((uint64_t*)card->tx_doorbell) + 8 * doorbell_index + 1) = dsc_l1;
+    mb();
+}
+
+// host side state of a class, it does not own a nicpic slot yet. Sleeps,
+// the class is published under tx_lock
+static struct dsc_buff *nicpic_alloc_class(struct nf10_card *card, uint64_t buff_mask, uint64_t rate, uint64_t tokens_max)
 {
-    int class_index;
-
-    class_index = card->class_num;
-    card->class_num++;
-    card->dsc_buffs[class_index] = (struct dsc_buff*)kmalloc(sizeof(struct dsc_buff), GFP_KERNEL);
-    card->dsc_buffs[class_index]->class_index = class_index;
-    card->dsc_buffs[class_index]->head = 0;
-    card->dsc_buffs[class_index]->tail = 0;
-    card->dsc_buffs[class_index]->mask = buff_mask;
-    card->dsc_buffs[class_index]->ptr_ori = pci_alloc_consistent(card->pdev, buff_mask+1+64, &(card->dsc_buffs[class_index]->physical_addr_ori));
-    if(card->dsc_buffs[class_index]->ptr_ori == NULL)
+    struct dsc_buff *buff;
+    unsigned long flags;
+
+    if(card->vclass_num >= VCLASS_NUM_MAX)
+        return NULL;
+
+    buff = (struct dsc_buff*)kmalloc(sizeof(struct dsc_buff), GFP_KERNEL);
+    if(buff == NULL)
+        return NULL;
+    buff->class_index = -1;
+    buff->head = 0;
+    buff->tail = 0;
+    buff->mask = buff_mask;
+    buff->ptr_ori = pci_alloc_consistent(card->pdev, buff_mask+1+64, &(buff->physical_addr_ori));
+    if(buff->ptr_ori == NULL)
     {
-        card->class_num--;
-        return 0;
+        kfree(buff);
+        return NULL;
+    }
+    buff->ptr = (void *)(((uint64_t)(buff->ptr_ori) & 0xffffffffffffffc0ULL) + 0x40ULL);
+    buff->physical_addr = (buff->physical_addr_ori & 0xffffffffffffffc0ULL) + 0x40ULL;
+    buff->skb = (struct sk_buff**)kmalloc((buff_mask+1)*sizeof(struct sk_buff*), GFP_KERNEL);
+    buff->pkt_physical_addr = (uint64_t *)kmalloc((buff_mask+1)*sizeof(uint64_t), GFP_KERNEL);
+
+    buff->parent_index = -1;
+    buff->child_num = 0;
+    buff->quantum = 0;
+    buff->prio = 0;
+    memset(&buff->min_rate, 0, sizeof(struct nicpic_rate));
+    memset(&buff->rate, 0, sizeof(struct nicpic_rate));
+    buff->rate.rate = rate;
+    buff->rate.tokens_max = tokens_max;
+    if(rate)
+        buff->rate.bps = 8 * NICPIC_TOKENS_PER_CYCLE * card->nicpic_clk_hz / rate;
+
+    buff->slot = -1;
+    INIT_LIST_HEAD(&buff->lru);
+    buff->spilled = 0;
+    buff->spill_tokens = 0;
+    memset(&buff->stats_out, 0, sizeof(struct nicpic_stats));
+    buff->stats_out_num = 0;
+    buff->cc_on = 0;
+    atomic_set(&buff->cc_acks, 0);
+    atomic_set(&buff->cc_marks, 0);
+
+    // another class may have taken the last id meanwhile
+    spin_lock_irqsave(&tx_lock, flags);
+    if(card->vclass_num >= VCLASS_NUM_MAX){
+        spin_unlock_irqrestore(&tx_lock, flags);
+        kfree(buff->skb);
+        kfree(buff->pkt_physical_addr);
+        pci_free_consistent(card->pdev, buff_mask+1+64, buff->ptr_ori, buff->physical_addr_ori);
+        kfree(buff);
+        return NULL;
     }
-    card->dsc_buffs[class_index]->ptr = (void *)(((uint64_t)(card->dsc_buffs[class_index]->ptr_ori) & 0xffffffffffffffc0ULL) + 0x40ULL);
-    card->dsc_buffs[class_index]->physical_addr = (card->dsc_buffs[class_index]->physical_addr_ori & 0xffffffffffffffc0ULL) + 0x40ULL;
-    card->dsc_buffs[class_index]->skb = (struct sk_buff**)kmalloc((buff_mask+1)*sizeof(struct sk_buff*), GFP_KERNEL);
-    card->dsc_buffs[class_index]->pkt_physical_addr = (uint64_t *)kmalloc((buff_mask+1)*sizeof(uint64_t), GFP_KERNEL);
+    buff->vclass = card->vclass_num;
+    card->vclasses[card->vclass_num] = buff;
+    card->vclass_num++;
+    spin_unlock_irqrestore(&tx_lock, flags);
+
+    return buff;
+}
+
+// port_short from the port bits of a host descriptor
+static uint64_t nicpic_dsc_port_short(struct dsc_buff *buff, uint64_t dsc_index)
+{
+    uint64_t port_decoded = (*(((uint64_t*)buff->ptr) + 8 * dsc_index + 0) >> 32) & 0xffff;
+
+    return ((port_decoded >> 1) & 0x1) | ((port_decoded >> 2) & 0x2) |
+           ((port_decoded >> 3) & 0x4) | ((port_decoded >> 4) & 0x8);
+}
+
+// host class by id, NULL if there is none
+static struct dsc_buff *nicpic_vclass_buff(struct nf10_card *card, uint64_t vclass)
+{
+    if(vclass >= card->vclass_num)
+        return NULL;
+    return card->vclasses[vclass];
+}
 
-    doorbell_add_class(card, card->dsc_buffs[class_index]->physical_addr, buff_mask);
-    doorbell_set_rate(card, class_index, rate);
-    doorbell_set_tokens_max(card, class_index, tokens_max);
+// put a class into slot, a new slot if slot == class_num
+static void nicpic_vclass_load(struct nf10_card *card, struct dsc_buff *buff, int slot)
+{
+    struct dsc_buff *child;
+    uint64_t tokens, cycles, dsc_index;
+    int i;
+
+    if(slot == card->class_num){
+        card->class_num++;
+        doorbell_add_class(card, buff->physical_addr, buff->mask);
+    }
+    else{
+        doorbell_load_class(card, slot, buff->physical_addr, buff->mask);
+    }
+    card->dsc_buffs[slot] = buff;
+    buff->class_index = slot;
+    buff->slot = slot;
+    list_add_tail(&buff->lru, &card->slot_lru);
+
+    doorbell_set_params(card, slot, buff->rate.rate, buff->rate.tokens_max);
+    if(buff->quantum)
+        doorbell_set_drr(card, slot, 1);
+    if(buff->prio)
+        doorbell_set_prio(card, slot, buff->prio);
+    if(buff->min_rate.rate)
+        doorbell_set_min(card, slot, buff->min_rate.rate, buff->min_rate.tokens_max);
+
+    // the hierarchy is kept by class id, the card links slots
+    if(buff->parent_index >= 0 && card->vclasses[buff->parent_index]->slot >= 0)
+        doorbell_set_parent(card, slot, 1, card->vclasses[buff->parent_index]->slot);
+    for(i = 0; buff->child_num && i < card->class_num; i++){
+        child = card->dsc_buffs[i];
+        if(child->slot == i && child->parent_index == (int)buff->vclass)
+            doorbell_set_parent(card, i, 1, slot);
+    }
+
+    if(buff->spilled){
+        // tokens earned while the class was out, a round robin deficit is kept as is
+        cycles = (uint64_t)ktime_to_ns(ktime_sub(ktime_get(), buff->spill_time)) / 1000 *
+                 (card->nicpic_clk_hz / 1000) / 1000;
+        tokens = buff->spill_tokens + cycles * NICPIC_TOKENS_PER_CYCLE;
+        if(tokens > buff->rate.tokens_max || tokens < buff->spill_tokens)
+            tokens = buff->rate.tokens_max;
+        if(buff->quantum)
+            tokens = buff->spill_tokens;
+        doorbell_load_state(card, slot, tokens, buff->head);
+
+        // hand the first outstanding descriptor over again
+        if(buff->head != buff->tail){
+            dsc_index = buff->head;
+            doorbell_add_dsc(card, slot, buff->pkt_physical_addr[dsc_index],
+                             nicpic_dsc_port_short(buff, dsc_index),
+                             buff->skb[dsc_index]->len, buff->tail,
+                             *(((uint64_t*)buff->ptr) + 8 * dsc_index + 2));
+        }
+        buff->spilled = 0;
+    }
+}
+
+int nicpic_add_class(struct nf10_card *card, uint64_t buff_mask, uint64_t rate, uint64_t tokens_max)
+{
+    struct dsc_buff *buff;
+    unsigned long flags;
+
+    if(card->class_num >= CLASS_NUM_MAX)
+        return 0;
+
+    buff = nicpic_alloc_class(card, buff_mask, rate, tokens_max);
+    if(buff == NULL)
+        return 0;
+
+    spin_lock_irqsave(&tx_lock, flags);
+    nicpic_vclass_load(card, buff, card->class_num);
+    spin_unlock_irqrestore(&tx_lock, flags);
 
     return 1;
 }
 
+// a class that gets a nicpic slot on its first use, returns its id or -1.
+// Packets with the id in skb->mark are sent in it. Sleeps
+int nicpic_add_vclass(struct nf10_card *card, uint64_t buff_mask, uint64_t rate, uint64_t tokens_max)
+{
+    struct dsc_buff *buff;
+
+    buff = nicpic_alloc_class(card, buff_mask, rate, tokens_max);
+    if(buff == NULL)
+        return -1;
+
+    return (int)buff->vclass;
+}
+
+// least recently used class that may give up its slot. Port classes and
+// classes in a hierarchy stay resident, and so does a class with packets
+// queued, a spilled class is only loaded again when it sends
+static struct dsc_buff *nicpic_vclass_victim(struct nf10_card *card)
+{
+    struct dsc_buff *victim;
+
+    list_for_each_entry(victim, &card->slot_lru, lru){
+        if(victim->vclass >= PORT_NUM && victim->parent_index < 0 &&
+           victim->child_num == 0 && victim->head == victim->tail)
+            return victim;
+    }
+
+    return NULL;
+}
+
+// returns the slot of a resident class. Otherwise a free slot is taken or
+// the least recently used idle class is evicted, and -EBUSY is returned until
+// the class is loaded, nicpic_vclass_finish_evict then wakes the tx queues.
+// -EBUSY as well while no class can be evicted, the queues go again once one
+// has drained. -EINVAL if the class does not exist. Call under tx_lock.
+int nicpic_vclass_slot(struct nf10_card *card, uint32_t vclass)
+{
+    struct dsc_buff *buff, *victim;
+    int slot;
+
+    buff = nicpic_vclass_buff(card, vclass);
+    if(buff == NULL)
+        return -EINVAL;
+
+    // a child only goes out under the cap of its parent, which comes in first
+    if(buff->parent_index >= 0 && card->vclasses[buff->parent_index]->slot < 0){
+        slot = nicpic_vclass_slot(card, buff->parent_index);
+        if(slot < 0)
+            return slot;
+    }
+
+    if(buff->slot >= 0){
+        list_move_tail(&buff->lru, &card->slot_lru);
+        return buff->slot;
+    }
+
+    // one miss at a time
+    if(card->evict_slot >= 0)
+        return -EBUSY;
+
+    if(card->class_num < CLASS_NUM_MAX){
+        nicpic_vclass_load(card, buff, card->class_num);
+        return buff->slot;
+    }
+
+    victim = nicpic_vclass_victim(card);
+    if(victim == NULL){
+        card->slot_wait = 1;
+        return -EBUSY;
+    }
+
+    card->evict_slot = victim->slot;
+    card->evict_done = 0;
+    card->load_vclass = vclass;
+    doorbell_evict_class(card, victim->slot);
+
+    return -EBUSY;
+}
+
+// the card handed back the state of an evicted class. Its slot is reused
+// by nicpic_vclass_finish_evict once tx completions that are already
+// posted have been handled, they still refer to the old class.
+void nicpic_vclass_evicted(struct nf10_card *card, uint64_t class_index, uint64_t tokens,
+                           uint64_t dsc_head_index, int pending)
+{
+    struct dsc_buff *buff = card->dsc_buffs[class_index];
+    uint64_t ring_mask = buff->mask >> 6;
+    uint64_t done;
+    uint64_t i;
+
+    // the packet the card was holding has not been sent, unless a tx
+    // completion already moved the head past it. Both ends may have
+    // wrapped, done counts only if it lies between head and tail
+    done = pending ? ((dsc_head_index - 1) & ring_mask) : dsc_head_index;
+    if(((done - buff->head) & ring_mask) <= ((buff->tail - buff->head) & ring_mask)){
+        for(i=buff->head; i!=done; i=(i+1) & ring_mask){
+            nicpic_tx_free(card, buff, i);
+        }
+        buff->head = done;
+    }
+
+    buff->spilled = 1;
+    buff->spill_tokens = tokens;
+    buff->spill_time = ktime_get();
+    buff->slot = -1;
+    list_del_init(&buff->lru);
+
+    card->evict_done++;
+}
+
+// the counters the evicted class gathered in its slot, the card sends them
+// after its state. The slot keeps them until it is loaded again
+void nicpic_vclass_evicted_stats(struct nf10_card *card, uint64_t class_index,
+                                 struct nicpic_stats *stats)
+{
+    struct dsc_buff *buff = card->dsc_buffs[class_index];
+
+    buff->stats_out.bytes += stats->bytes;
+    buff->stats_out.pkts += stats->pkts;
+    buff->stats_out.starved_cycles += stats->starved_cycles;
+    buff->stats_out.doorbells += stats->doorbells;
+    buff->stats_out_num++;
+
+    card->evict_done++;
+}
+
+// call under tx_lock, the queues stopped on the miss go again. A miss that
+// found no class to evict retries once one has drained
+void nicpic_vclass_finish_evict(struct nf10_card *card)
+{
+    int i;
+
+    if(card->evict_slot < 0){
+        if(!card->slot_wait || nicpic_vclass_victim(card) == NULL)
+            return;
+        card->slot_wait = 0;
+    }
+    else{
+        if(card->evict_done < 2)
+            return;
+        nicpic_vclass_load(card, card->vclasses[card->load_vclass], card->evict_slot);
+        card->evict_slot = -1;
+    }
+
+    for(i = 0; i < PORT_NUM; i++){
+        if(netif_queue_stopped(card->ndev[i]))
+            netif_wake_queue(card->ndev[i]);
+    }
+}
+
 void nicpic_delete_class(struct nf10_card *card)
 {
         doorbell_stop_class(card, card->class_num - 1);
         doorbell_delete_class(card);
 }
+
+// the hierarchy has two levels: a parent (tenant) caps the aggregate of
+// its children (flows), which keep their own limits. A parent should not
+// carry packets of its own, its children wait while it is in flight.
+// Classes are host class ids, the card learns the link once both are resident
+int nicpic_set_parent(struct nf10_card *card, uint64_t vclass, uint64_t parent_vclass)
+{
+    struct dsc_buff *child, *parent;
+
+    child = nicpic_vclass_buff(card, vclass);
+    parent = nicpic_vclass_buff(card, parent_vclass);
+    if(child == NULL || parent == NULL || vclass == parent_vclass)
+        return 0;
+
+    if(child->child_num != 0 || parent->parent_index >= 0)
+        return 0;
+
+    if(child->parent_index >= 0)
+        card->vclasses[child->parent_index]->child_num--;
+    child->parent_index = (int)parent_vclass;
+    parent->child_num++;
+    if(child->slot >= 0 && parent->slot >= 0)
+        doorbell_set_parent(card, child->slot, 1, parent->slot);
+
+    return 1;
+}
+
+void nicpic_clear_parent(struct nf10_card *card, uint64_t vclass)
+{
+    struct dsc_buff *child;
+
+    child = nicpic_vclass_buff(card, vclass);
+    if(child == NULL)
+        return;
+
+    if(child->parent_index >= 0)
+        card->vclasses[child->parent_index]->child_num--;
+    child->parent_index = -1;
+    if(child->slot >= 0)
+        doorbell_set_parent(card, child->slot, 0, 0);
+}
+
+static int nicpic_set_params_bulk(struct nf10_card *card, uint64_t class_index, uint64_t list,
+                                  uint64_t *class_list, int count, uint64_t *rate, uint64_t *tokens_max)
+{
+    int i;
+
+    if(count <= 0 || count > CLASS_NUM_MAX)
+        return 0;
+
+    // one bulk update at a time, the card reads the table after the doorbell
+    if(atomic_cmpxchg(&card->bulk_busy, 0, 1) != 0)
+        return 0;
+
+    for(i = 0; i < count; i++){
+        *(((uint64_t*)card->bulk_table_ptr) + 2 * i + 0) = rate[i];
+        *(((uint64_t*)card->bulk_table_ptr) + 2 * i + 1) = (tokens_max[i] & 0xffffffffffULL) +
+            (list ? (class_list[i] << 48) : 0);
+    }
+
+    doorbell_set_params_bulk(card, class_index, list, count, card->bulk_table_dma);
+
+    return 1;
+}
+
+// returns 0 if another bulk update has not completed yet
+int nicpic_set_params_range(struct nf10_card *card, uint64_t class_index, int count,
+                            uint64_t *rate, uint64_t *tokens_max)
+{
+    if(class_index + count > CLASS_NUM_MAX)
+        return 0;
+    return nicpic_set_params_bulk(card, class_index, 0, NULL, count, rate, tokens_max);
+}
+
+int nicpic_set_params_list(struct nf10_card *card, uint64_t *class_index, int count,
+                           uint64_t *rate, uint64_t *tokens_max)
+{
+    return nicpic_set_params_bulk(card, 0, 1, class_index, count, rate, tokens_max);
+}
+
+// fills result even when the setting is refused so the caller can see why
+int nicpic_rate_from_bps(struct nf10_card *card, uint64_t bps, uint64_t burst_bytes,
+                         uint64_t max_error_ppm, struct nicpic_rate *result)
+{
+    uint64_t bps_unit = 8 * NICPIC_TOKENS_PER_CYCLE * card->nicpic_clk_hz; // bps at rate 1
+    uint64_t rate;
+    int64_t error_ppm;
+
+    memset(result, 0, sizeof(struct nicpic_rate));
+    if(bps == 0 || burst_bytes > NICPIC_TOKENS_MAX_MAX)
+        return 0;
+
+    rate = (bps_unit + bps/2) / bps;
+    if(rate == 0 || rate > NICPIC_RATE_MAX)
+        return 0;
+
+    result->rate = rate;
+    result->tokens_max = burst_bytes * rate;
+    result->bps = bps_unit / rate;
+    result->step_bps = result->bps - bps_unit / (rate + 1);
+    result->error_ppm = ((int64_t)result->bps - (int64_t)bps) * 1000000 / (int64_t)bps;
+
+    error_ppm = result->error_ppm < 0 ? -result->error_ppm : result->error_ppm;
+    if((uint64_t)error_ppm > max_error_ppm)
+        return 0;
+
+    // a bucket smaller than a full frame never lets that frame out
+    if(burst_bytes < NICPIC_FRAME_MAX || result->tokens_max > NICPIC_TOKENS_MAX_MAX)
+        return 0;
+
+    return 1;
+}
+
+// the committed bucket counts in peak bucket tokens (rate per byte) and gains
+// fill/4096 of them per cycle, so a class is guaranteed fill*clk/(512*rate) bps
+static int nicpic_min_from_bps(struct nf10_card *card, uint64_t rate, uint64_t bps,
+                               uint64_t burst_bytes, struct nicpic_rate *result)
+{
+    uint64_t clk = card->nicpic_clk_hz;
+    uint64_t fill;
+    int64_t error_ppm;
+
+    memset(result, 0, sizeof(struct nicpic_rate));
+    if(bps == 0 || rate == 0 || burst_bytes > NICPIC_TOKENS_MAX_MAX)
+        return 0;
+
+    // 512*rate*bps overflows 64 bits at 24 bit rates, split bps by clk
+    fill = 512 * rate * (bps / clk) + (512 * rate * (bps % clk) + clk/2) / clk;
+    // more than the peak rate could never be used
+    if(fill == 0 || fill > NICPIC_MIN_FILL_MAX)
+        return 0;
+
+    result->rate = fill;
+    result->tokens_max = burst_bytes * rate;
+    result->bps = fill * clk / (512 * rate);
+    result->step_bps = clk / (512 * rate);
+    result->error_ppm = ((int64_t)result->bps - (int64_t)bps) * 1000000 / (int64_t)bps;
+
+    error_ppm = result->error_ppm < 0 ? -result->error_ppm : result->error_ppm;
+    if((uint64_t)error_ppm > NICPIC_ERROR_PPM_MAX)
+        return 0;
+
+    if(burst_bytes < NICPIC_FRAME_MAX || result->tokens_max > NICPIC_TOKENS_MAX_MAX)
+        return 0;
+
+    return 1;
+}
+
+// a committed rate below the peak rate. Classes within it are served before
+// the ones that only have spare capacity left. bps == 0 removes it.
+int nicpic_set_min_bps(struct nf10_card *card, uint64_t vclass, uint64_t bps,
+                       uint64_t burst_bytes, struct nicpic_rate *result)
+{
+    struct dsc_buff *buff;
+
+    buff = nicpic_vclass_buff(card, vclass);
+    if(buff == NULL)
+        return 0;
+
+    if(bps == 0){
+        memset(result, 0, sizeof(struct nicpic_rate));
+    }
+    else if(!nicpic_min_from_bps(card, buff->rate.rate, bps, burst_bytes, result)){
+        return 0;
+    }
+
+    buff->min_rate = *result;
+    if(buff->slot >= 0)
+        doorbell_set_min(card, buff->slot, result->rate, result->tokens_max);
+
+    return 1;
+}
+
+// keep the committed bps when the peak bucket's cost per byte changes
+static void nicpic_rescale_min(struct nf10_card *card, struct dsc_buff *buff, uint64_t rate)
+{
+    struct nicpic_rate result;
+
+    if(buff->min_rate.rate == 0 || buff->rate.rate == 0 || rate == buff->rate.rate)
+        return;
+
+    if(!nicpic_min_from_bps(card, rate, buff->min_rate.bps,
+                            buff->min_rate.tokens_max / buff->rate.rate, &result))
+        memset(&result, 0, sizeof(struct nicpic_rate));
+    buff->min_rate = result;
+    if(buff->slot >= 0)
+        doorbell_set_min(card, buff->slot, result.rate, result.tokens_max);
+}
+
+// returns 0 and leaves the class untouched if the card cannot honour bps
+int nicpic_set_rate_bps(struct nf10_card *card, uint64_t vclass, uint64_t bps,
+                        uint64_t burst_bytes, struct nicpic_rate *result)
+{
+    struct dsc_buff *buff;
+
+    buff = nicpic_vclass_buff(card, vclass);
+    if(buff == NULL)
+        return 0;
+
+    if(!nicpic_rate_from_bps(card, bps, burst_bytes, NICPIC_ERROR_PPM_MAX, result))
+        return 0;
+
+    nicpic_rescale_min(card, buff, result->rate);
+    buff->rate = *result;
+    // a new setting is the new ceiling of an adapted class
+    buff->cc_max_bps = result->bps;
+    buff->cc_bps = result->bps;
+    buff->cc_burst = burst_bytes;
+    if(buff->slot >= 0)
+        doorbell_set_params(card, buff->slot, result->rate, result->tokens_max);
+    if(buff->quantum){
+        buff->quantum = 0;
+        if(buff->slot >= 0)
+            doorbell_set_drr(card, buff->slot, 0);
+    }
+
+    return 1;
+}
+
+// one rate for count classes from vclass on, the resident ones get it in a
+// single bulk doorbell, in range mode if their slots are consecutive. The
+// table is filled from the cc_* scratch arrays, which are only used under
+// tx_lock. Returns 0 if the card cannot honour bps or the previous bulk
+// update has not completed yet. Call under tx_lock.
+int nicpic_set_rate_range_bps(struct nf10_card *card, uint64_t vclass, int count,
+                              uint64_t bps, uint64_t burst_bytes, struct nicpic_rate *result)
+{
+    struct dsc_buff *buff;
+    int i, n = 0, range = 1;
+
+    if(count <= 0 || vclass + count > card->vclass_num)
+        return 0;
+
+    if(!nicpic_rate_from_bps(card, bps, burst_bytes, NICPIC_ERROR_PPM_MAX, result))
+        return 0;
+
+    for(i = 0; i < count; i++){
+        buff = card->vclasses[vclass + i];
+        if(buff == NULL)
+            return 0;
+        if(buff->slot < 0)
+            continue;
+        card->cc_index[n] = buff->slot;
+        card->cc_rate[n] = result->rate;
+        card->cc_tokens_max[n] = result->tokens_max;
+        if(n && card->cc_index[n] != card->cc_index[0] + n)
+            range = 0;
+        n++;
+    }
+    if(n && range && !nicpic_set_params_range(card, card->cc_index[0], n, card->cc_rate, card->cc_tokens_max))
+        return 0;
+    if(n && !range && !nicpic_set_params_list(card, card->cc_index, n, card->cc_rate, card->cc_tokens_max))
+        return 0;
+
+    for(i = 0; i < count; i++){
+        buff = card->vclasses[vclass + i];
+        nicpic_rescale_min(card, buff, result->rate);
+        buff->rate = *result;
+        buff->cc_max_bps = result->bps;
+        buff->cc_bps = result->bps;
+        buff->cc_burst = burst_bytes;
+        if(buff->quantum){
+            buff->quantum = 0;
+            if(buff->slot >= 0)
+                doorbell_set_drr(card, buff->slot, 0);
+        }
+    }
+
+    return 1;
+}
+
+// work conserving sharing instead of pacing: backlogged round robin classes
+// get bandwidth in proportion to their quantum (bytes per turn). Setting a
+// rate in bps turns a class back into a token bucket.
+int nicpic_set_drr(struct nf10_card *card, uint64_t vclass, uint64_t quantum)
+{
+    struct dsc_buff *buff;
+
+    buff = nicpic_vclass_buff(card, vclass);
+    if(buff == NULL || quantum == 0 || quantum > NICPIC_TOKENS_MAX_MAX)
+        return 0;
+
+    nicpic_rescale_min(card, buff, 1);
+    // the deficit is kept in bytes
+    memset(&buff->rate, 0, sizeof(struct nicpic_rate));
+    buff->rate.rate = 1;
+    buff->rate.tokens_max = quantum;
+    buff->quantum = quantum;
+    if(buff->slot >= 0){
+        doorbell_set_params(card, buff->slot, 1, quantum);
+        doorbell_set_drr(card, buff->slot, 1);
+    }
+
+    return 1;
+}
+
+// round robin for every child of a parent, the parent still caps the group
+int nicpic_set_group_drr(struct nf10_card *card, uint64_t parent_vclass, uint64_t quantum)
+{
+    struct dsc_buff *parent;
+    int i;
+
+    parent = nicpic_vclass_buff(card, parent_vclass);
+    if(parent == NULL || parent->child_num == 0)
+        return 0;
+
+    for(i = 0; i < card->vclass_num; i++){
+        if(card->vclasses[i] != NULL && card->vclasses[i]->parent_index == (int)parent_vclass &&
+           !nicpic_set_drr(card, i, quantum))
+            return 0;
+    }
+
+    return 1;
+}
+
+// strict priority level of a class, level 0 is served first. Token
+// buckets still cap every class
+int nicpic_set_prio(struct nf10_card *card, uint64_t vclass, uint64_t level)
+{
+    struct dsc_buff *buff;
+
+    buff = nicpic_vclass_buff(card, vclass);
+    if(buff == NULL || level >= NICPIC_PRIO_LEVELS)
+        return 0;
+
+    buff->prio = level;
+    if(buff->slot >= 0)
+        doorbell_set_prio(card, buff->slot, level);
+
+    return 1;
+}
+
+// a waiting level passed over starve_max times in a row is served once,
+// 0 lets higher levels starve the lower ones
+int nicpic_set_starve(struct nf10_card *card, uint64_t starve_max)
+{
+    if(starve_max > NICPIC_STARVE_MAX_MAX)
+        return 0;
+
+    doorbell_set_starve(card, 0, starve_max);
+
+    return 1;
+}
+
+// counters of a class over all the slots it held. Those of its current slot
+// come from a snapshot, the card sends them through the doorbell completion
+// queue without stopping the scheduler. Entries of a snapshot given up on
+// carry an old stats_seq and are dropped. Returns 0 if another snapshot runs
+// or the card does not answer. Sleeps, takes tx_lock itself for the doorbell
+int nicpic_read_stats(struct nf10_card *card, uint64_t vclass, struct nicpic_stats *stats)
+{
+    struct dsc_buff *buff;
+    unsigned long flags;
+    uint32_t out_num;
+    int i, slot;
+
+    memset(stats, 0, sizeof(struct nicpic_stats));
+    if(atomic_cmpxchg(&card->stats_left, 0, 1) != 0)
+        return 0;
+
+    spin_lock_irqsave(&tx_lock, flags);
+    buff = nicpic_vclass_buff(card, vclass);
+    slot = buff ? buff->slot : -1;
+    if(slot >= 0){
+        out_num = buff->stats_out_num;
+        card->stats_seq++;
+        doorbell_read_stats(card, slot, 1, card->stats_seq);
+    }
+    else if(buff != NULL){
+        *stats = buff->stats_out;
+    }
+    spin_unlock_irqrestore(&tx_lock, flags);
+
+    if(slot < 0){
+        atomic_set(&card->stats_left, 0);
+        return buff != NULL;
+    }
+
+    for(i = 0; i < 100 && atomic_read(&card->stats_left); i++)
+        msleep(1);
+    if(atomic_read(&card->stats_left)){
+        atomic_set(&card->stats_left, 0);
+        return 0;
+    }
+
+    // an eviction meanwhile has counted the slot into stats_out already
+    spin_lock_irqsave(&tx_lock, flags);
+    *stats = buff->stats_out;
+    if(buff->stats_out_num == out_num){
+        stats->bytes += card->stats[slot].bytes;
+        stats->pkts += card->stats[slot].pkts;
+        stats->starved_cycles += card->stats[slot].starved_cycles;
+        stats->doorbells += card->stats[slot].doorbells;
+    }
+    spin_unlock_irqrestore(&tx_lock, flags);
+
+    return 1;
+}
+
+// closed loop rate: the current rate of a paced class becomes its ceiling and
+// every NICPIC_CC_PERIOD_NS the driver moves below it following the ECN echo
+// of the acks it gets back. ai_bps is added per period without marks, 0 turns
+// the loop off and restores the ceiling
+int nicpic_set_cc(struct nf10_card *card, uint64_t vclass, uint64_t ai_bps)
+{
+    struct dsc_buff *buff;
+    struct nicpic_rate result;
+
+    buff = nicpic_vclass_buff(card, vclass);
+    if(buff == NULL)
+        return 0;
+
+    if(ai_bps == 0){
+        if(!buff->cc_on)
+            return 1;
+        buff->cc_on = 0;
+        card->cc_num--;
+        return nicpic_set_rate_bps(card, vclass, buff->cc_max_bps, buff->cc_burst, &result);
+    }
+
+    if(buff->quantum || buff->rate.rate == 0)
+        return 0;
+
+    buff->cc_ai_bps = ai_bps;
+    if(!buff->cc_on){
+        buff->cc_max_bps = buff->rate.bps;
+        buff->cc_bps = buff->rate.bps;
+        buff->cc_burst = buff->rate.tokens_max / buff->rate.rate;
+        buff->cc_alpha = NICPIC_CC_ALPHA_ONE;
+        atomic_set(&buff->cc_acks, 0);
+        atomic_set(&buff->cc_marks, 0);
+        card->cc_num++;
+        wmb();
+        buff->cc_on = 1;
+    }
+
+    if(!hrtimer_active(&card->cc_timer))
+        hrtimer_start(&card->cc_timer, ns_to_ktime(NICPIC_CC_PERIOD_NS), HRTIMER_MODE_REL);
+
+    return 1;
+}
+
+// remote address and port, local port. The same for a segment and its ack
+static uint32_t nicpic_cc_hash(uint32_t addr, uint16_t remote_port, uint16_t local_port)
+{
+    return ((addr ^ ((uint32_t)remote_port << 16) ^ local_port) * 2654435761U) >> (32 - CC_FLOW_BITS);
+}
+
+// remembers the class of an outgoing tcp segment, skb->data is the frame
+void nicpic_cc_tx(struct nf10_card *card, struct sk_buff *skb, uint32_t vclass)
+{
+    struct ethhdr *eth = (struct ethhdr *)skb->data;
+    struct iphdr *iph;
+    struct tcphdr *th;
+
+    if(!card->vclasses[vclass]->cc_on || skb->len < ETH_HLEN + sizeof(struct iphdr) ||
+       eth->h_proto != htons(ETH_P_IP))
+        return;
+
+    iph = (struct iphdr *)(skb->data + ETH_HLEN);
+    if(iph->protocol != IPPROTO_TCP || skb->len < ETH_HLEN + iph->ihl*4 + sizeof(struct tcphdr))
+        return;
+
+    th = (struct tcphdr *)((uint8_t *)iph + iph->ihl*4);
+    card->cc_flows[nicpic_cc_hash(iph->daddr, th->dest, th->source)] = vclass + 1;
+}
+
+// counts acks and ECN echoes for the class that sent the flow, skb->data is
+// the ip header. Only counting here, the rates move in nicpic_cc_tick
+void nicpic_cc_rx(struct nf10_card *card, struct sk_buff *skb)
+{
+    struct iphdr *iph;
+    struct tcphdr *th;
+    struct dsc_buff *buff;
+    uint32_t vclass;
+
+    if(card->cc_num == 0 || skb->protocol != htons(ETH_P_IP) || skb->len < sizeof(struct iphdr))
+        return;
+
+    iph = (struct iphdr *)skb->data;
+    if(iph->protocol != IPPROTO_TCP || skb->len < iph->ihl*4 + sizeof(struct tcphdr))
+        return;
+
+    th = (struct tcphdr *)((uint8_t *)iph + iph->ihl*4);
+    // ECE on a SYN only negotiates ECN
+    if(!th->ack || th->syn)
+        return;
+
+    vclass = card->cc_flows[nicpic_cc_hash(iph->saddr, th->source, th->dest)];
+    if(vclass == 0 || vclass > card->vclass_num)
+        return;
+
+    buff = card->vclasses[vclass - 1];
+    if(!buff->cc_on)
+        return;
+
+    atomic_inc(&buff->cc_acks);
+    if(th->ece)
+        atomic_inc(&buff->cc_marks);
+}
+
+// one control period, call under tx_lock. The resident classes that changed
+// go to the card in one bulk update, if the previous one is still in flight
+// they are tried again next period. Returns 0 once no class is controlled
+int nicpic_cc_tick(struct nf10_card *card)
+{
+    uint64_t bps_min = 8 * NICPIC_TOKENS_PER_CYCLE * card->nicpic_clk_hz / NICPIC_RATE_MAX + 1;
+    struct dsc_buff *buff;
+    struct nicpic_rate result;
+    uint32_t acks, marks;
+    int i, n = 0;
+
+    if(card->cc_num == 0)
+        return 0;
+
+    for(i = 0; i < card->class_num; i++){
+        buff = card->dsc_buffs[i];
+        if(buff->slot != i || !buff->cc_on)
+            continue;
+
+        // an idle class keeps its rate
+        acks = atomic_xchg(&buff->cc_acks, 0);
+        marks = atomic_xchg(&buff->cc_marks, 0);
+        if(acks == 0)
+            continue;
+        marks = min(marks, acks);
+
+        buff->cc_alpha = buff->cc_alpha - (buff->cc_alpha >> NICPIC_CC_GAIN_SHIFT) +
+            ((marks * NICPIC_CC_ALPHA_ONE / acks) >> NICPIC_CC_GAIN_SHIFT);
+        if(marks)
+            buff->cc_bps -= buff->cc_bps * buff->cc_alpha / (2 * NICPIC_CC_ALPHA_ONE);
+        else
+            buff->cc_bps = min_t(uint64_t, buff->cc_bps + buff->cc_ai_bps, buff->cc_max_bps);
+        buff->cc_bps = max_t(uint64_t, buff->cc_bps, bps_min);
+
+        if(!nicpic_rate_from_bps(card, buff->cc_bps, buff->cc_burst, ~0ULL, &result) ||
+           result.rate == buff->rate.rate)
+            continue;
+
+        card->cc_index[n] = i;
+        card->cc_rate[n] = result.rate;
+        card->cc_tokens_max[n] = result.tokens_max;
+        n++;
+    }
+
+    if(n == 0 || !nicpic_set_params_list(card, card->cc_index, n, card->cc_rate, card->cc_tokens_max))
+        return 1;
+
+    for(i = 0; i < n; i++){
+        buff = card->dsc_buffs[card->cc_index[i]];
+        nicpic_rescale_min(card, buff, card->cc_rate[i]);
+        nicpic_rate_from_bps(card, buff->cc_bps, buff->cc_burst, ~0ULL, &buff->rate);
+    }
+
+    return 1;
+}
+
+static uint64_t nicpic_read_stat(struct nf10_card *card, uint64_t index)
+{
+    return *(((uint64_t*)card->cfg_addr) + 4096/8 + index);
+}
+
+// samples the MAC tx counters over ms (up to 1000) milliseconds while the caller keeps
+// the port busy with classes adding up to bps. The tx clock is measured
+// from the time stamps and kept for later conversions, classes set before
+// calibration should be set again. result->bps is the measured rate and
+// result->error_ppm its distance from what the card should have enforced.
+int nicpic_calibrate(struct nf10_card *card, uint64_t bps, unsigned int ms,
+                     struct nicpic_rate *result)
+{
+    uint64_t ts0, ts1, cycles, ns, bits;
+    uint32_t word0, word1, pkt0, pkt1;
+    ktime_t t0, t1;
+    struct nicpic_rate expected;
+    int64_t error_ppm;
+
+    memset(result, 0, sizeof(struct nicpic_rate));
+    if(ms == 0 || ms > 1000)
+        return 0;
+
+    t0 = ktime_get();
+    ts0 = nicpic_read_stat(card, NICPIC_STAT_MAC_TX_TS);
+    word0 = (uint32_t)nicpic_read_stat(card, NICPIC_STAT_MAC_TX_WORD_CNT);
+    pkt0 = (uint32_t)nicpic_read_stat(card, NICPIC_STAT_MAC_TX_PKT_CNT);
+
+    msleep(ms);
+
+    t1 = ktime_get();
+    ts1 = nicpic_read_stat(card, NICPIC_STAT_MAC_TX_TS);
+    word1 = (uint32_t)nicpic_read_stat(card, NICPIC_STAT_MAC_TX_WORD_CNT);
+    pkt1 = (uint32_t)nicpic_read_stat(card, NICPIC_STAT_MAC_TX_PKT_CNT);
+
+    // the time stamp only moves with traffic
+    cycles = ts1 - ts0;
+    ns = (uint64_t)ktime_to_ns(ktime_sub(t1, t0));
+    if(cycles == 0 || ns == 0 || (uint32_t)(pkt1 - pkt0) == 0)
+        return 0;
+
+    card->nicpic_clk_hz = cycles * 1000000000ULL / ns;
+    card->edt_ns = 0;
+
+    // 8 byte words, the last word of a packet is on average half full
+    bits = (uint64_t)(uint32_t)(word1 - word0) * 64 - (uint64_t)(uint32_t)(pkt1 - pkt0) * 32;
+    result->bps = bits * card->nicpic_clk_hz / cycles;
+
+    nicpic_rate_from_bps(card, bps, NICPIC_FRAME_MAX, ~0ULL, &expected);
+    if(expected.bps == 0)
+        return 0;
+
+    result->rate = expected.rate;
+    result->step_bps = expected.step_bps;
+    result->error_ppm = ((int64_t)result->bps - (int64_t)expected.bps) * 1000000 / (int64_t)expected.bps;
+
+    error_ppm = result->error_ppm < 0 ? -result->error_ppm : result->error_ppm;
+    printk(KERN_INFO "nf10: nicpic clock %lld Hz, measured %lld bps, expected %lld bps, error %lld ppm\n",
+           card->nicpic_clk_hz, result->bps, expected.bps, result->error_ppm);
+
+    return (uint64_t)error_ppm <= NICPIC_ERROR_PPM_MAX;
+}
+// reads the card tx cycle count together with the host clock, the midpoint
+// of the two host reads is taken as the time of the card read
+static void nicpic_edt_sync(struct nf10_card *card)
+{
+    uint64_t t0, t1;
+
+    t0 = (uint64_t)ktime_to_ns(ktime_get());
+    card->edt_cycles = nicpic_read_stat(card, NICPIC_STAT_TX_TIME);
+    t1 = (uint64_t)ktime_to_ns(ktime_get());
+    card->edt_ns = t0 + (t1 - t0) / 2;
+}
+
+// launch time of skb in the card tx clock, 0 to send as soon as the class
+// allows. Only sockets with SO_TXTIME on the monotonic or tai clock ask for
+// one, past times go out right away. Call with the tx lock held.
+uint64_t nicpic_launch(struct nf10_card *card, struct sk_buff *skb)
+{
+#ifdef SO_TXTIME
+    uint64_t now_ns, cycles;
+    int64_t ahead;
+
+    if(skb->sk == NULL || !sock_flag(skb->sk, SOCK_TXTIME) || ktime_to_ns(skb->tstamp) == 0)
+        return 0;
+
+    now_ns = (uint64_t)ktime_to_ns(ktime_get());
+    if(skb->sk->sk_clockid == CLOCK_MONOTONIC)
+        ahead = ktime_to_ns(skb->tstamp) - (int64_t)now_ns;
+    else if(skb->sk->sk_clockid == CLOCK_TAI)
+        ahead = ktime_to_ns(ktime_sub(skb->tstamp, ktime_get_clocktai()));
+    else
+        return 0;
+    if(ahead <= 0)
+        return 0;
+    if(ahead > NICPIC_LAUNCH_HORIZON_NS)
+        ahead = NICPIC_LAUNCH_HORIZON_NS;
+
+    if(card->edt_ns == 0 || now_ns - card->edt_ns > NICPIC_EDT_RESYNC_NS){
+        nicpic_edt_sync(card);
+        now_ns = card->edt_ns;
+    }
+
+    cycles = card->edt_cycles + (now_ns - card->edt_ns + ahead) * card->nicpic_clk_hz / 1000000000ULL;
+    return NICPIC_LAUNCH_VALID | (cycles & 0xffffffffULL);
+#else
+    return 0;
+#endif
+}
+
+// copy a small packet to a free tx_inline slot and return the address its
+// descriptor carries, 0 if it has to be mapped for a dma read instead. The
+// copy lands before the descriptor, the xmit path orders them. Call with the
+// tx lock held.
+uint64_t nicpic_inline(struct nf10_card *card, struct sk_buff *skb)
+{
+    int slot;
+
+    if(skb->len > NICPIC_INLINE_MAX)
+        return 0;
+
+    slot = find_first_zero_bit(card->inline_busy, card->inline_slots);
+    if(slot >= card->inline_slots)
+        return 0;
+    set_bit(slot, card->inline_busy);
+
+    memcpy_toio(card->tx_inline + slot * NICPIC_INLINE_MAX, skb->data, skb->len);
+    return NICPIC_INLINE_FLAG | (slot * NICPIC_INLINE_MAX);
+}
+
+// release what descriptor i of buff holds, its skb and its dma mapping or
+// inline slot
+void nicpic_tx_free(struct nf10_card *card, struct dsc_buff *buff, uint64_t i)
+{
+    uint64_t addr = buff->pkt_physical_addr[i];
+
+    if(addr & NICPIC_INLINE_FLAG)
+        clear_bit((addr & ~NICPIC_INLINE_FLAG) / NICPIC_INLINE_MAX, card->inline_busy);
+    else
+        pci_unmap_single(card->pdev, addr, buff->skb[i]->len, PCI_DMA_TODEVICE);
+    dev_kfree_skb_any(buff->skb[i]);
+}
+
 /*
 void nicpic_start_class(struct nf10_card *card, uint64_t class_index, uint64_t pkt_len)
 {
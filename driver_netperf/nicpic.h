@@ -3,16 +3,109 @@
 
 #include "nf10driver.h"
 
+// one 16 byte entry per class, read by the card in 64 byte lines
+#define NICPIC_BULK_TABLE_SIZE (((CLASS_NUM_MAX+3)/4)*64)
+
+// the token buckets run on the tx clock and gain 4096 tokens per cycle, a
+// packet costs pkt_len*rate tokens, so a class gets 32768*clk/rate bits per second
+#define NICPIC_CLK_HZ           160000000ULL
+#define NICPIC_TOKENS_PER_CYCLE 4096ULL
+#define NICPIC_RATE_MAX         0xffffffULL
+#define NICPIC_TOKENS_MAX_MAX   0xffffffffffULL
+#define NICPIC_FRAME_MAX        1514ULL
+#define NICPIC_ERROR_PPM_MAX    10000ULL // refuse settings more than 1% off
+// the committed bucket fills min_fill/4096 tokens per cycle, at most the peak rate
+#define NICPIC_MIN_FILL_MAX     (NICPIC_TOKENS_PER_CYCLE << 12)
+#define NICPIC_PRIO_LEVELS      4
+#define NICPIC_STARVE_MAX_MAX   0xffffULL
+// skb->mark NICPIC_MARK_BASE + id sends in host class id, the low 16 bits. Other
+// marks, and ids of port classes, leave the packet in the class of its port
+#define NICPIC_MARK_BASE        0x4e460000U
+// congestion control, DCTCP style: every period alpha moves 1/16 of the way to
+// the fraction of marked acks, a period with marks cuts the rate by alpha/2
+#define NICPIC_CC_PERIOD_NS     100000ULL
+#define NICPIC_CC_GAIN_SHIFT    4
+#define NICPIC_CC_ALPHA_ONE     1024
+
+// MAC tx stats, 64 bit words at cfg_addr + 4096/8
+#define NICPIC_STAT_MAC_TX_TS       (128+16)
+#define NICPIC_STAT_MAC_TX_WORD_CNT (128+17)
+#define NICPIC_STAT_MAC_TX_PKT_CNT  (128+18)
+#define NICPIC_STAT_TX_TIME         (128+19)
+// launch times (SO_TXTIME) are the low 32 bits of the card tx cycle count, [32] marks them
+// valid. Later ones are clamped to the horizon, the card time is read again every resync
+#define NICPIC_LAUNCH_VALID         (1ULL << 32)
+#define NICPIC_LAUNCH_HORIZON_NS    1000000000ULL
+#define NICPIC_EDT_RESYNC_NS        10000000ULL
+// small packets are copied to the card through the upper half of the doorbell
+// window and sent from there, their descriptor address is the flag and offset
+#define NICPIC_INLINE_BASE          0x00080000ULL
+#define NICPIC_INLINE_MAX           128
+#define NICPIC_INLINE_SLOTS         64
+#define NICPIC_INLINE_FLAG          (1ULL << 63)
+
 void doorbell_add_class(struct nf10_card *card, uint64_t dsc_buffer_host_addr, uint64_t dsc_buffer_mask);
 void doorbell_set_rate(struct nf10_card *card, uint64_t class_index, uint64_t rate);
 void doorbell_set_tokens_max(struct nf10_card *card, uint64_t class_index, uint64_t tokens_max);
 void doorbell_add_dsc(struct nf10_card *card, uint64_t class_index, uint64_t pkt_host_addr,
-                      uint64_t pkt_port_short, uint64_t pkt_len, uint64_t dsc_tail_index);
+                      uint64_t pkt_port_short, uint64_t pkt_len, uint64_t dsc_tail_index,
+                      uint64_t launch);
 void doorbell_stop_class(struct nf10_card *card, uint64_t class_index);
 void doorbell_delete_class(struct nf10_card *card);
+void doorbell_set_params(struct nf10_card *card, uint64_t class_index, uint64_t rate, uint64_t tokens_max);
+void doorbell_set_params_bulk(struct nf10_card *card, uint64_t class_index, uint64_t list,
+                              uint64_t count, uint64_t table_host_addr);
+void doorbell_set_parent(struct nf10_card *card, uint64_t class_index, uint64_t parent_vld,
+                         uint64_t parent_index);
+void doorbell_evict_class(struct nf10_card *card, uint64_t class_index);
+void doorbell_load_class(struct nf10_card *card, uint64_t class_index, uint64_t dsc_buffer_host_addr,
+                         uint64_t dsc_buffer_mask);
+void doorbell_load_state(struct nf10_card *card, uint64_t class_index, uint64_t tokens,
+                         uint64_t dsc_head_index);
+void doorbell_set_drr(struct nf10_card *card, uint64_t class_index, uint64_t drr);
+void doorbell_set_min(struct nf10_card *card, uint64_t class_index, uint64_t fill, uint64_t tokens_max);
+void doorbell_read_stats(struct nf10_card *card, uint64_t class_index, uint64_t count,
+                         uint64_t seq);
+void doorbell_set_prio(struct nf10_card *card, uint64_t class_index, uint64_t level);
+void doorbell_set_starve(struct nf10_card *card, uint64_t class_index, uint64_t starve_max);
 
 int nicpic_add_class(struct nf10_card *card, uint64_t buff_mask, uint64_t rate, uint64_t tokens_max);
 void nicpic_delete_class(struct nf10_card *card);
+int nicpic_set_params_range(struct nf10_card *card, uint64_t class_index, int count,
+                            uint64_t *rate, uint64_t *tokens_max);
+int nicpic_set_params_list(struct nf10_card *card, uint64_t *class_index, int count,
+                           uint64_t *rate, uint64_t *tokens_max);
+int nicpic_add_vclass(struct nf10_card *card, uint64_t buff_mask, uint64_t rate, uint64_t tokens_max);
+int nicpic_vclass_slot(struct nf10_card *card, uint32_t vclass);
+void nicpic_vclass_evicted(struct nf10_card *card, uint64_t class_index, uint64_t tokens,
+                           uint64_t dsc_head_index, int pending);
+void nicpic_vclass_evicted_stats(struct nf10_card *card, uint64_t class_index,
+                                 struct nicpic_stats *stats);
+void nicpic_vclass_finish_evict(struct nf10_card *card);
+int nicpic_set_parent(struct nf10_card *card, uint64_t vclass, uint64_t parent_vclass);
+void nicpic_clear_parent(struct nf10_card *card, uint64_t vclass);
+int nicpic_rate_from_bps(struct nf10_card *card, uint64_t bps, uint64_t burst_bytes,
+                         uint64_t max_error_ppm, struct nicpic_rate *result);
+int nicpic_set_rate_bps(struct nf10_card *card, uint64_t vclass, uint64_t bps,
+                        uint64_t burst_bytes, struct nicpic_rate *result);
+int nicpic_set_rate_range_bps(struct nf10_card *card, uint64_t vclass, int count,
+                              uint64_t bps, uint64_t burst_bytes, struct nicpic_rate *result);
+int nicpic_calibrate(struct nf10_card *card, uint64_t bps, unsigned int ms,
+                     struct nicpic_rate *result);
+int nicpic_set_drr(struct nf10_card *card, uint64_t vclass, uint64_t quantum);
+int nicpic_set_min_bps(struct nf10_card *card, uint64_t vclass, uint64_t bps,
+                       uint64_t burst_bytes, struct nicpic_rate *result);
+int nicpic_set_group_drr(struct nf10_card *card, uint64_t parent_vclass, uint64_t quantum);
+int nicpic_set_prio(struct nf10_card *card, uint64_t vclass, uint64_t level);
+int nicpic_set_starve(struct nf10_card *card, uint64_t starve_max);
+int nicpic_read_stats(struct nf10_card *card, uint64_t vclass, struct nicpic_stats *stats);
+int nicpic_set_cc(struct nf10_card *card, uint64_t vclass, uint64_t ai_bps);
+void nicpic_cc_tx(struct nf10_card *card, struct sk_buff *skb, uint32_t vclass);
+void nicpic_cc_rx(struct nf10_card *card, struct sk_buff *skb);
+int nicpic_cc_tick(struct nf10_card *card);
+uint64_t nicpic_launch(struct nf10_card *card, struct sk_buff *skb);
+uint64_t nicpic_inline(struct nf10_card *card, struct sk_buff *skb);
+void nicpic_tx_free(struct nf10_card *card, struct dsc_buff *buff, uint64_t i);
 //void nicpic_start_class(struct nf10_card *card, uint64_t class_index, uint64_t pkt_len);
 //void nicpic_add_dsc(struct nf10_card *card, uint64_t class_index);
 